@@ -6,6 +6,9 @@
 #include <algorithm>
 #include <deque>
 #include <fmt/format.h>
+#include <iterator>
+#include <new>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
@@ -18,23 +21,23 @@ struct Arena
     T data[N];
     usize size;
 
-    Arena(T zero = T{}) : size{0}, data{zero} {}
+    constexpr Arena(T zero = T{}) : size{0}, data{zero} {}
 
-    Arena(auto begin, auto end) : size{(usize)std::distance(begin, end)}
+    constexpr Arena(auto begin, auto end) : size{(usize)std::distance(begin, end)}
     {
         if (size > N)
             throw error("cannot create arena from range: capacity exceeded");
         std::move(begin, end, data);
     }
 
-    T &push(const T &&x)
+    constexpr T &push(const T &&x)
     {
         if (size + 1 > N)
             throw error("cannot push(): capacity exceeded");
         return (data[size++] = x);
     }
 
-    T *pop()
+    constexpr T *pop()
     {
         if (size < 1)
             throw error("cannot pop(): empty arena");
@@ -42,27 +45,37 @@ struct Arena
         return back();
     }
 
-    T *at(usize n)
+    constexpr T *at(usize n)
     {
         return n < size ? &data[n] : NULL;
     }
 
-    T *begin()
+    constexpr T *begin()
     {
         return &data[0];
     }
 
-    T *end()
+    constexpr T *end()
     {
         return &data[size];
     }
 
-    T *front()
+    constexpr const T *begin() const
+    {
+        return &data[0];
+    }
+
+    constexpr const T *end() const
+    {
+        return &data[size];
+    }
+
+    constexpr T *front()
     {
         return size != 0 ? &data[0] : NULL;
     }
 
-    T *back()
+    constexpr T *back()
     {
         return size != 0 ? &data[size - 1] : NULL;
     }
@@ -73,77 +86,151 @@ struct Arena
     }
 };
 
+// Growable arena made of chunks of N items, the first chunk is stored inline so that small arenas do not allocate and
+// the next ones are allocated once it is full. Items never move after being pushed, the chunks stay contiguous
+
 template <typename T, usize N>
 struct Dyn_Arena
 {
-    std::deque<Arena<T, N>> chunks;
-    usize size;
+    template <typename A, typename V>
+    struct Iterator
+    {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::remove_const_t<V>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = V *;
+        using reference = V &;
 
-    Dyn_Arena() = default;
+        A *arena;
+        usize n;
 
-    Dyn_Arena(auto begin, auto end) : size{(usize)std::distance(begin, end)}
-    {
-        for (usize i = 0; i < size; i += N)
+        constexpr V &operator*() const
+        {
+            return *arena->at(n);
+        }
+
+        constexpr V *operator->() const
         {
-            chunk_push() = Arena<T, N>{begin + i, begin + i + N};
+            return arena->at(n);
         }
+
+        constexpr Iterator &operator++()
+        {
+            n++;
+            return *this;
+        }
+
+        constexpr Iterator operator++(s32)
+        {
+            return Iterator{arena, n++};
+        }
+
+        constexpr bool operator==(const Iterator &) const = default;
+    };
+
+    Arena<T, N> head;
+    std::vector<Arena<T, N> *> chunks;
+    usize size;
+
+    constexpr Dyn_Arena(T zero = T{}) : head{zero}, size{0} {}
+
+    constexpr Dyn_Arena(auto begin, auto end) : Dyn_Arena()
+    {
+        for (; begin != end; ++begin)
+            push(T{*begin});
     }
 
-    Dyn_Arena(auto container) : Dyn_Arena(container.begin(), container.end()) {}
+    constexpr Dyn_Arena(Dyn_Arena &&other) : head{other.head}, chunks{std::move(other.chunks)}, size{other.size}
+    {
+        other.chunks.clear();
+        other.size = 0;
+    }
 
-    T *at(usize n)
+    constexpr Dyn_Arena &operator=(Dyn_Arena &&other)
     {
-        usize chunk_n = n / N;
-        usize item_n = n % N;
+        std::swap(head, other.head);
+        std::swap(chunks, other.chunks);
+        std::swap(size, other.size);
+        return *this;
+    }
 
-        if (chunk_n >= chunks.size() or item_n >= chunks[chunk_n].size)
-            return NULL;
-        return chunks[chunk_n].buffer[item_n];
+    Dyn_Arena(const Dyn_Arena &) = delete;
+    Dyn_Arena &operator=(const Dyn_Arena &) = delete;
+
+    constexpr ~Dyn_Arena()
+    {
+        for (Arena<T, N> *chunk : chunks)
+            delete chunk;
     }
 
-    T &push(const T &&x)
+    constexpr T *at(usize n)
     {
-        size++;
-        while (size < chunks.size() * N)
+        return n < size ? &chunk(n / N).data[n % N] : NULL;
+    }
+
+    constexpr const T *at(usize n) const
+    {
+        return n < size ? &chunk(n / N).data[n % N] : NULL;
+    }
+
+    constexpr T &push(const T &&x)
+    {
+        if (size / N > chunks.size())
             chunk_push();
-        return chunk_back().push(std::move(x));
+        return chunk(size++ / N).push(std::move(x));
     }
 
-    T *pop()
+    constexpr T *pop()
     {
         if (size < 1)
             throw error("cannot pop(): empty arena");
-        size--;
-        return chunk_back().pop();
+        chunk(--size / N).pop();
+        return back();
+    }
+
+    constexpr T *front()
+    {
+        return at(0);
+    }
+
+    constexpr T *back()
+    {
+        return size != 0 ? at(size - 1) : NULL;
+    }
+
+    constexpr Iterator<Dyn_Arena, T> begin()
+    {
+        return {this, 0};
+    }
+
+    constexpr Iterator<Dyn_Arena, T> end()
+    {
+        return {this, size};
     }
 
-    T *front()
+    constexpr Iterator<const Dyn_Arena, const T> begin() const
     {
-        return chunk_front().front();
+        return {this, 0};
     }
 
-    T *back()
+    constexpr Iterator<const Dyn_Arena, const T> end() const
     {
-        return chunk_back().back();
+        return {this, size};
     }
 
-    Arena<T, N> &chunk_push()
+    constexpr Arena<T, N> &chunk(usize n)
     {
-        return chunks.emplace_back();
+        return n != 0 ? *chunks[n - 1] : head;
     }
 
-    Arena<T, N> &chunk_front()
+    constexpr const Arena<T, N> &chunk(usize n) const
     {
-        if (chunks.empty())
-            return chunk_push();
-        return chunks.front();
+        return n != 0 ? *chunks[n - 1] : head;
     }
 
-    Arena<T, N> &chunk_back()
+    constexpr Arena<T, N> &chunk_push()
     {
-        if (chunks.empty())
-            return chunk_push();
-        return chunks.back();
+        return *chunks.emplace_back(new Arena<T, N>{});
     }
 
     Error error(std::string_view desc) const
@@ -152,28 +239,165 @@ struct Dyn_Arena
     }
 };
 
-// NOTE! this implementation of mem_arena does not deconstruct the allocated objects !
+// Bump allocator for objects of any type, constructed in place in chunks of bytes. The first chunk holds N bytes and
+// each new chunk is `growth` times larger up to chunk_max, an object larger than that gets a chunk of its own. The
+// destructors of the objects that need one are run in reverse order on reset(), rewind() and destruction. The chunks
+// are kept by reset() and rewind(), an arena reset between sources does not allocate again
 
 template <usize N>
 struct Mem_Arena
 {
-    std::deque<Arena<u8, N>> chunks;
+    struct Chunk
+    {
+        u8 *data;
+        usize size;
+    };
+
+    struct Dtor
+    {
+        void *object;
+        void (*destroy)(void *);
+    };
+
+    struct Mark
+    {
+        usize chunk;
+        usize used;
+        usize dtors;
+    };
+
+    std::vector<Chunk> chunks;
+    std::vector<Dtor> dtors;
+    usize chunk;
+    usize used;
+    usize growth;
+    usize chunk_max;
+
+    Mem_Arena(usize growth = 2, usize chunk_max = N * 64) :
+        chunk{0},
+        used{0},
+        growth{std::max<usize>(growth, 1)},
+        chunk_max{std::max(chunk_max, N)}
+    {
+    }
+
+    Mem_Arena(Mem_Arena &&other) : Mem_Arena(other.growth, other.chunk_max)
+    {
+        *this = std::move(other);
+    }
+
+    Mem_Arena &operator=(Mem_Arena &&other)
+    {
+        std::swap(chunks, other.chunks);
+        std::swap(dtors, other.dtors);
+        std::swap(chunk, other.chunk);
+        std::swap(used, other.used);
+        std::swap(growth, other.growth);
+        std::swap(chunk_max, other.chunk_max);
+        return *this;
+    }
+
+    Mem_Arena(const Mem_Arena &) = delete;
+    Mem_Arena &operator=(const Mem_Arena &) = delete;
+
+    ~Mem_Arena()
+    {
+        reset();
+        for (Chunk &chunk : chunks)
+            delete[] chunk.data;
+    }
+
+    template <typename T, typename... Args>
+    T *emplace(Args &&...args)
+    {
+        // The destructor entry is reserved first, the object is never left without its destructor
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            if (dtors.size() == dtors.capacity())
+                dtors.reserve(dtors.size() * 2 + 64);
+        }
+
+        T *object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+        if constexpr (!std::is_trivially_destructible_v<T>)
+        {
+            dtors.push_back(Dtor{object, [](void *object) {
+                                     ((T *)object)->~T();
+                                 }});
+        }
+        return object;
+    }
 
     template <typename T>
-    T *push(const T &&x)
+    T *push(T &&x)
     {
-        static_assert(sizeof(T) <= N, "cannot push item that cannot fit in a chunk");
+        return emplace<std::decay_t<T>>(std::move(x));
+    }
 
-        if (chunks.empty() or chunks.back().size + sizeof(T) > N)
+    void *allocate(usize size, usize align)
+    {
+        for (;; chunk++, used = 0)
+        {
+            if (chunk == chunks.size())
+                chunk_push(size + align);
+
+            uintptr_t begin = (uintptr_t)chunks[chunk].data;
+            usize offset = ((begin + used + align - 1) & ~(uintptr_t)(align - 1)) - begin;
+
+            if (offset + size <= chunks[chunk].size)
+            {
+                used = offset + size;
+                return chunks[chunk].data + offset;
+            }
+        }
+    }
+
+    Mark mark() const
+    {
+        return Mark{chunk, used, dtors.size()};
+    }
+
+    // Destroys the objects created since the mark, their memory is reused by the next allocations
+    void rewind(Mark mark)
+    {
+        while (dtors.size() > mark.dtors)
         {
-            chunks.emplace_back();
-            return push(std::move(x));
+            Dtor dtor = dtors.back();
+            dtors.pop_back();
+            dtor.destroy(dtor.object);
         }
 
-        Arena<u8, N> &chunk = chunks.back();
-        u8 *dst = &chunk.data[chunk.size];
-        chunk.size += sizeof(T);
-        return (T *)std::memcpy(dst, (const void *)&x, sizeof(T));
+        chunk = mark.chunk;
+        used = mark.used;
+    }
+
+    void reset()
+    {
+        rewind(Mark{0, 0, 0});
+    }
+
+    // The bytes allocated so far, with the padding of the alignments and the ends of the chunks left unused
+    usize size() const
+    {
+        usize size = used;
+        for (usize n = 0; n < std::min(chunk, chunks.size()); n++)
+            size += chunks[n].size;
+        return size;
+    }
+
+    usize capacity() const
+    {
+        usize size = 0;
+        for (const Chunk &chunk : chunks)
+            size += chunk.size;
+        return size;
+    }
+
+    Chunk &chunk_push(usize min)
+    {
+        usize size = chunks.empty() ? N : std::min(chunks.back().size * growth, chunk_max);
+        size = std::max(size, min);
+        return chunks.emplace_back(Chunk{new u8[size], size});
     }
 };
 
@@ -1,40 +1,137 @@
 #include "ast.hpp"
+#include "function.hpp"
 
 namespace bee
 {
 
-Ast::~Ast()
+// Empties the ast for the next source, the memory of the expressions, the interned names and the built-in types are
+// kept. The tables may point to the entities of the source, only the built-in types are bound again
+void Ast::reset()
 {
-    for (Frame *frame : frames)
-        delete frame;
+    defs.clear();
+    binds.clear();
+    stack.clear();
+    frame = NULL;
+    if (builtins != NULL)
+        push_frame(builtins);
+
+    exprs.reset();
+    main_frame = NULL;
+    main_scope = NULL;
+    units.clear();
+    expr_count = 0;
+}
+
+Frame *Ast::new_frame()
+{
+    return exprs.emplace<Frame>();
 }
 
 Compound_Expr *Ast::push_compound(Compound_Expr compound)
 {
-    return &compounds.emplace_back(compound);
+    return exprs.push(std::move(compound));
 }
 
-Frame *Ast::push_frame(Frame *f)
+// A unit kept by an incremental parse, its definitions are bound again in the current frame
+void Ast::push_unit(Ast_Unit unit)
 {
-    f->owner = frame;
-    frame = f;
+    main_scope->compound->insert(main_scope->compound->end(), unit.exprs.begin(), unit.exprs.end());
+    for (Ast_Entity *entity : unit.defs)
+    {
+        frame->defs.push_back(entity);
+        defs.insert(entity->symbol, entity);
+    }
+    units.push_back(std::move(unit));
+}
+
+// Moves the tokens of the expressions onto another source holding the same text 'shift' bytes away. The names of the
+// entities are interned, only the tokens of the expressions point into the source. The parser shares a statement with
+// the one after it (the target of an assignment), an expression in 'moved' already points into the new source
+void Ast::move_tokens(Ast_Expr *expr, s64 shift, std::unordered_set<Ast_Expr *> &moved)
+{
+    auto move = [shift](Token &token) {
+        if (token.expr.data() != NULL)
+            token.expr = std::string_view{token.expr.data() + shift, token.expr.size()};
+    };
+    std::vector<Ast_Expr *> stack{expr};
+
+    while (!stack.empty())
+    {
+        expr = stack.back();
+        stack.pop_back();
+        if (!moved.insert(expr).second)
+            continue;
+        move(expr->repr);
 
-    if (frame->owner != NULL)
-        frame->depth = frame->owner->depth + 1;
-    else
-        frame->depth = 0;
-    
-    if (frame->depth >= Ast_Frame_Limit)
+        switch (expr->kind())
+        {
+        case Ast_Expr_Unary:
+            move(((Unary_Expr *)expr)->op);
+            break;
+        case Ast_Expr_Binary:
+            move(((Binary_Expr *)expr)->op);
+            break;
+        case Ast_Expr_Id:
+            move(((Id_Expr *)expr)->name);
+            break;
+        case Ast_Expr_Var:
+            move(((Var_Expr *)expr)->op);
+            move(((Var_Expr *)expr)->name);
+            break;
+        case Ast_Expr_Function:
+            if (Var_Expr *params = ((Function_Expr *)expr)->function->params)
+                stack.push_back(params);
+            break;
+        case Ast_Expr_Typedef:
+            move(((Typedef_Expr *)expr)->op);
+            move(((Typedef_Expr *)expr)->name);
+            break;
+        case Ast_Expr_Record:
+            move(((Record_Expr *)expr)->kw);
+            break;
+        case Ast_Expr_Member:
+            move(((Member_Expr *)expr)->op);
+            break;
+        default:
+            break;
+        }
+
+        ast_expr_children(expr, [&stack](Ast_Expr *child) {
+            stack.push_back(child);
+        });
+    }
+}
+
+// A frame pushed again (the signature of a function around its body, the scopes of a running program) binds its
+// definitions again. The owner of a frame is the frame it was first pushed in, a frame can be on the stack many times
+Frame *Ast::push_frame(Frame *f)
+{
+    if (stack.size() >= Ast_Frame_Limit)
         throw errorf("frame depth limit exceeded");
-    
-    frames.insert(f);
-    return f;
+
+    defs.push_scope();
+    binds.push_scope();
+    for (Ast_Entity *entity : f->defs)
+        defs.insert(entity->symbol, entity);
+
+    if (f->owner == NULL and frame != NULL)
+    {
+        f->owner = frame;
+        f->depth = frame->depth + 1;
+    }
+
+    stack.push_back(f);
+    return frame = f;
 }
 
 Frame *Ast::pop_frame()
 {
-    Frame *pop = frame;
-    frame = frame->owner;
+    defs.pop_scope();
+    binds.pop_scope();
+
+    Frame *pop = stack.back();
+    stack.pop_back();
+    frame = !stack.empty() ? stack.back() : NULL;
     return pop;
 }
 
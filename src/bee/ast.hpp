@@ -4,30 +4,70 @@
 #include "entity.hpp"
 #include "expr.hpp"
 #include "frame.hpp"
+#include "interner.hpp"
+#include "symbol_table.hpp"
 #include "type_system.hpp"
-#include <unordered_map>
+#include <unordered_set>
 
 namespace bee
 {
 
 const u32 Ast_Frame_Limit = 256;
 
+// A statement of the main scope and the lines it spans in the source: the expressions it added to the main scope, the
+// entities it defined in the main frame, the symbols of the identifiers it uses and the bytes its parse took in the
+// expression arena. An incremental parse keeps or parses again whole units
+
+struct Ast_Unit
+{
+    u32 begin;
+    u32 end;
+    std::vector<Ast_Expr *> exprs;
+    std::vector<Ast_Entity *> defs;
+    std::vector<u32> symbols;
+    usize bytes;
+};
+
+// The frames record what each scope defines, the lookups go through the symbol tables in which push_frame() and
+// pop_frame() open and close a scope. Frames live in the expression arena, except the one of the built-in types, the
+// top of the stack is the current frame. The names are interned once per ast and kept between sources, the tables
+// are keyed by their symbol
+
 struct Ast
 {
+    std::string_view source;
     Mem_Arena<1024> exprs;
-    std::set<Frame *> frames;
-    std::deque<Compound_Expr> compounds;
+    Interner interner;
+    Symbol_Table<u32, Ast_Entity *> defs;
+    Symbol_Table<Function *, Scope_Expr *> binds;
+    std::vector<Frame *> stack;
+    Frame builtin_frame = {};
+    Frame *builtins = NULL;
     Frame *frame = NULL;
     Frame *main_frame;
     Scope_Expr *main_scope;
+    std::vector<Ast_Unit> units;
     Type_System type_system;
     u32 expr_count;
 
-    ~Ast();
-    Ast_Expr *find(std::string_view name);
+    void reset();
+    Frame *new_frame();
     Frame *push_frame(Frame *f);
     Frame *pop_frame();
     Compound_Expr *push_compound(Compound_Expr compound);
+    void push_unit(Ast_Unit unit);
+    void move_tokens(Ast_Expr *expr, s64 shift, std::unordered_set<Ast_Expr *> &moved);
+
+    template <typename T>
+    T *push_def(T *entity, u32 symbol)
+    {
+        static_assert(std::is_base_of_v<Ast_Entity, std::decay_t<T>>, "type is not an entity");
+        entity->symbol = symbol;
+        entity->name = interner.str(symbol);
+        frame->defs.push_back(entity);
+        defs.insert(symbol, entity);
+        return entity;
+    }
 
     template <typename T>
     T *push_expr(T expr)
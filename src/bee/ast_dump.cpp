@@ -1,7 +1,9 @@
 #include "ast_dump.hpp"
 #include "ast.hpp"
+#include "flat_ast.hpp"
 #include "function.hpp"
 #include "var.hpp"
+#include <vector>
 
 namespace bee
 {
@@ -17,6 +19,13 @@ Ast_Dump::Ast_Dump(Ast *ast) : ast(ast)
     expr_dump({"main_scope", 0}, ast->main_scope);
 }
 
+// Same output as the dump of the expressions the flat ast was built from
+Ast_Dump::Ast_Dump(Ast *ast, const Flat_Ast &flat) : ast(ast)
+{
+    frame_dump({"main_frame", 0}, ast->main_frame);
+    expr_dump({"main_scope", 0}, flat.root());
+}
+
 void Ast_Dump::frame_dump(Ast_Dump_Header h, Frame *frame)
 {
     if (!frame or frame->defs.empty())
@@ -25,7 +34,7 @@ void Ast_Dump::frame_dump(Ast_Dump_Header h, Frame *frame)
         return;
     }
     print("{}\n", h);
-    for (auto &[name, entity] : frame->defs)
+    for (Ast_Entity *entity : frame->defs)
         entity_dump({"", h.depth + 1}, entity);
 }
 
@@ -46,12 +55,24 @@ void Ast_Dump::expr_dump(Ast_Dump_Header h, Ast_Expr *ast_expr)
         break;
     }
 
+    // Chains of left operands are printed down and their right operands back up, without recursing into the chain
     case Ast_Expr_Binary: {
-        Binary_Expr *binary = (Binary_Expr *)ast_expr;
-        print("{} binary-expr [op: '{:s}']\n", h, binary->op.expr);
-        expr_dump({"prev", h.depth + 1}, binary->prev);
-        expr_dump({"post", h.depth + 1}, binary->post);
-        entity_dump({"type", h.depth + 1}, binary->type);
+        std::vector<Binary_Expr *> spine;
+        for (Ast_Expr *expr = ast_expr; expr != NULL and expr->kind() == Ast_Expr_Binary;
+             expr = ((Binary_Expr *)expr)->prev)
+        {
+            Binary_Expr *binary = (Binary_Expr *)expr;
+            Ast_Dump_Header header{spine.empty() ? h.name : "prev", h.depth + (s32)spine.size()};
+            print("{} binary-expr [op: '{:s}']\n", header, binary->op.expr);
+            spine.push_back(binary);
+        }
+        expr_dump({"prev", h.depth + (s32)spine.size()}, spine.back()->prev);
+
+        for (s32 depth = h.depth + (s32)spine.size() - 1; depth >= h.depth; depth--, spine.pop_back())
+        {
+            expr_dump({"post", depth + 1}, spine.back()->post);
+            entity_dump({"type", depth + 1}, spine.back()->type);
+        }
         break;
     }
 
@@ -195,6 +216,164 @@ void Ast_Dump::expr_dump(Ast_Dump_Header h, Ast_Expr *ast_expr)
     }
 }
 
+void Ast_Dump::expr_dump(Ast_Dump_Header h, Flat_Node node)
+{
+    switch (node.kind())
+    {
+    case Ast_Expr_None: {
+        print("{} (none)\n", h);
+        break;
+    }
+
+    case Ast_Expr_Unary: {
+        print("{} unary-expr [op: '{:s}', order: '{:s}']\n", h, node.token(), order_expr_name((Order_Expr)node.word(0)));
+        expr_dump({"expr", h.depth + 1}, node.child(0));
+        break;
+    }
+
+    // The left operand of a binary node is the node after it, a chain of left operands is a run of binary nodes
+    case Ast_Expr_Binary: {
+        u32 n = node.n;
+        for (; Flat_Node{node.flat, n}.kind() == Ast_Expr_Binary; n++)
+        {
+            Ast_Dump_Header header{n == node.n ? h.name : "prev", h.depth + (s32)(n - node.n)};
+            print("{} binary-expr [op: '{:s}']\n", header, Flat_Node{node.flat, n}.token());
+        }
+        expr_dump({"prev", h.depth + (s32)(n - node.n)}, Flat_Node{node.flat, n});
+
+        while (n-- > node.n)
+        {
+            Flat_Node binary{node.flat, n};
+            expr_dump({"post", h.depth + (s32)(n - node.n) + 1}, binary.child(1));
+            entity_dump({"type", h.depth + (s32)(n - node.n) + 1}, binary.ptr<Ast_Entity>(0));
+        }
+        break;
+    }
+
+    case Ast_Expr_Nested: {
+        print("{} nested-expr\n", h);
+        expr_dump({"expr", h.depth + 1}, node.child(0));
+        break;
+    }
+
+    case Ast_Expr_Scope: {
+        print("{} scope-expr\n", h);
+        frame_dump({"frame", h.depth + 1}, node.ptr<Frame>(0));
+
+        if (node.n + 1 == node.flat->ends[node.n])
+        {
+            print("(empty-scope)\n");
+            break;
+        }
+
+        for (Flat_Node expr : node.children())
+        {
+            expr_dump({">", h.depth + 1}, expr);
+        }
+        break;
+    }
+
+    case Ast_Expr_Return: {
+        print("{} return-expr\n", h);
+        expr_dump({"expr", h.depth + 1}, node.child(0));
+        break;
+    }
+
+    case Ast_Expr_Id: {
+        print("{} id-expr\n", h);
+        entity_dump({"entity", h.depth + 1}, node.ptr<Ast_Entity>(0));
+        break;
+    }
+
+    case Ast_Expr_Var: {
+        print("{} var-expr [name: '{:s}', op: '{:s}']\n", h, node.token(), node.span(1));
+        entity_dump({"var", h.depth + 1}, node.ptr<Var>(0));
+        expr_dump({"expr", h.depth + 1}, node.child(0));
+        expr_dump({"next", h.depth + 1}, node.child(1));
+        break;
+    }
+
+    case Ast_Expr_Char: {
+        print("{} char-expr [data: '{:c}']\n", h, (char)node.word(0));
+        break;
+    }
+
+    case Ast_Expr_Str: {
+        print("{} str-expr [data: '{:s}']\n", h, std::string_view{node.ptr<const char>(0), node.word(1)});
+        break;
+    }
+
+    case Ast_Expr_Int: {
+        print("{} int-expr [data: '{:d}', size: {:d}]\n", h, node.word(0), (u32)node.word(1));
+        break;
+    }
+
+    case Ast_Expr_Float: {
+        print("{} float-expr [data: '{:f}', size: {:d}]\n", h, std::bit_cast<f64>(node.word(0)), (u32)node.word(1));
+        break;
+    }
+
+    case Ast_Expr_Signature: {
+        print("{} signature-expr\n", h);
+        expr_dump({"params", h.depth + 1}, node.child(0));
+        entity_dump({"type", h.depth + 1}, node.ptr<Ast_Entity>(0));
+        frame_dump({"frame", h.depth + 1}, node.ptr<Frame>(1));
+        break;
+    }
+
+    case Ast_Expr_Function: {
+        print("{} function-expr\n", h);
+        entity_dump({"function", h.depth + 1}, node.ptr<Function>(0));
+        expr_dump({"scope", h.depth + 1}, node.child(0));
+        break;
+    }
+
+    case Ast_Expr_Argument: {
+        print("{} argument-expr\n", h);
+        expr_dump({"expr", h.depth + 1}, node.child(0));
+        expr_dump({"next", h.depth + 1}, node.child(1));
+        break;
+    }
+
+    case Ast_Expr_Invoke: {
+        print("{} invoke-expr\n", h);
+        expr_dump({"args", h.depth + 1}, node.child(0));
+        entity_dump({"function", h.depth + 1}, node.ptr<Function>(0));
+        break;
+    }
+
+    case Ast_Expr_If: {
+        print("{} if-expr\n", h);
+        expr_dump({"condition", h.depth + 1}, node.child(0));
+        expr_dump({"scope-if", h.depth + 1}, node.child(1));
+        expr_dump({"scope-else", h.depth + 1}, node.child(2));
+        break;
+    }
+
+    case Ast_Expr_For: {
+        print("{} for-expr\n", h);
+        expr_dump({"start", h.depth + 1}, node.child(0));
+        expr_dump({"condition", h.depth + 1}, node.child(1));
+        expr_dump({"iteration", h.depth + 1}, node.child(2));
+        expr_dump({"scope", h.depth + 1}, node.child(3));
+        frame_dump({"frame", h.depth + 1}, node.ptr<Frame>(0));
+        break;
+    }
+
+    case Ast_Expr_For_While: {
+        print("{} for-while-expr\n", h);
+        expr_dump({"condition", h.depth + 1}, node.child(0));
+        expr_dump({"scope", h.depth + 1}, node.child(1));
+        break;
+    }
+
+    default: {
+        print("{} TODO! Implement expression '{:s}' for expr_dump()'\n", h, ast_expr_kind_name(node.kind()));
+        break;
+    }
+    }
+}
+
 void Ast_Dump::entity_dump(Ast_Dump_Header h, Ast_Entity *ast_entity)
 {
     if (!ast_entity)
@@ -12,6 +12,8 @@ struct Ast;
 struct Ast_Expr;
 struct Ast_Entity;
 struct Frame;
+struct Flat_Ast;
+struct Flat_Node;
 
 struct Ast_Dump_Header
 {
@@ -24,8 +26,10 @@ struct Ast_Dump : Stream
     Ast *ast;
 
     Ast_Dump(Ast *ast);
+    Ast_Dump(Ast *ast, const Flat_Ast &flat);
     void frame_dump(Ast_Dump_Header h, Frame *frame);
     void expr_dump(Ast_Dump_Header h, Ast_Expr *ast_expr);
+    void expr_dump(Ast_Dump_Header h, Flat_Node node);
     void entity_dump(Ast_Dump_Header h, Ast_Entity *ast_entity);
 };
 
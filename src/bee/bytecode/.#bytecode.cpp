@@ -1 +0,0 @@
-jim@jim-klvlwxx9.2790:1691847211
\ No newline at end of file
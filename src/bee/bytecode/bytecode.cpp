@@ -1,27 +1,76 @@
 #include "bytecode.hpp"
 #include "ast.hpp"
+#include "function.hpp"
+#include "type_system.hpp"
 #include "var.hpp"
-#include <utility>
+#include <algorithm>
+#include <bit>
 
 namespace bee
 {
 
 Bytecode::Bytecode(Ast *ast) :
     ast{ast},
+    type_system{ast->type_system},
     none{
         Bc_Object_None,
-        Bc_Address_None,
+        ast->type_system.void_type,
+        Bc_U64,
+        0,
         NULL,
-    }
+    },
+    vars{&globals}
 {
 }
 
 std::span<Bc_Instruction> Bytecode::gen()
 {
-    gen_expr(ast->main_scope);
+    ast->push_frame(ast->main_frame);
+    u32 frame = push_instruction(Bc_Frame, Bc_U64, 0);
+    for (Ast_Expr *expr : *ast->main_scope->compound)
+        gen_statement(expr);
+
+    Ast_Entity *main = ast->defs.find(ast->interner.find("main"));
+    ast->pop_frame();
+    if (!main or main->kind() != Ast_Entity_Function)
+        throw errorf("no entry point defined in program, consider the implementation of 'main :: () -> s32'");
+
+    // The globals stay below the frame of 'main'
+    Bc_Object *result = gen_invoke((Function *)main, NULL);
+    if (result->type == Bc_Object_None)
+        throw errorf("entry point 'main' does not return a value");
+    push_instruction(Bc_Exit, result->atom, result->reg);
+    instructions[frame].x = regs;
+
+    while (!functions.empty())
+    {
+        gen_function_body(functions.front());
+        functions.pop_front();
+    }
+
+    for (auto [n, function] : invokes)
+    {
+        auto entry = entries.find(function);
+        if (entry == entries.end())
+            throw errorf("no definition found for function '{:s}'", function->name);
+        instructions[n].y = entry->second;
+    }
     return instructions;
 }
 
+// The registers of the variables a statement defines stay until the end of its scope, its temporaries are released.
+// A name alone has no effect, the compound of an invoke statement holds the name of the function before it
+void Bytecode::gen_statement(Ast_Expr *expr)
+{
+    if (expr->kind() == Ast_Expr_Id)
+        return;
+
+    u32 mark = top;
+    gen_expr(expr);
+    if (expr->kind() != Ast_Expr_Var)
+        top = mark;
+}
+
 Bc_Object *Bytecode::gen_expr(Ast_Expr *expr)
 {
     switch (expr->kind())
@@ -29,89 +78,466 @@ Bc_Object *Bytecode::gen_expr(Ast_Expr *expr)
     case Ast_Expr_Unary:
         return gen_unary((Unary_Expr *)expr);
 
+    case Ast_Expr_Binary:
+        return gen_binary((Binary_Expr *)expr);
+
+    case Ast_Expr_Nested:
+        return gen_expr(((Nested_Expr *)expr)->expr);
+
+    case Ast_Expr_Scope:
+        return gen_scope((Scope_Expr *)expr);
+
+    case Ast_Expr_Id:
+        return gen_var_id((Id_Expr *)expr);
+
+    case Ast_Expr_Var:
+        return gen_var((Var_Expr *)expr);
+
+    case Ast_Expr_Char:
+        return gen_atom(type_system.typed(expr), (u64)((Char_Expr *)expr)->data, false);
+
+    case Ast_Expr_Int:
+        return gen_atom(type_system.typed(expr), ((Int_Expr *)expr)->data, false);
+
+    case Ast_Expr_Float:
+        return gen_atom(type_system.typed(expr), std::bit_cast<u64>(((Float_Expr *)expr)->data), true);
+
+    case Ast_Expr_Return:
+        return gen_return((Return_Expr *)expr);
+
+    case Ast_Expr_Function:
+        return gen_function((Function_Expr *)expr);
+
+    case Ast_Expr_Invoke:
+        return gen_invoke(((Invoke_Expr *)expr)->function, ((Invoke_Expr *)expr)->args);
+
+    case Ast_Expr_If:
+        return gen_if((If_Expr *)expr);
+
+    case Ast_Expr_For:
+        return gen_for((For_Expr *)expr);
+
+    case Ast_Expr_For_While:
+        return gen_for_while((For_While_Expr *)expr);
+
     default:
-        throw errorf("TODO! gen_expr() support '{}'", ast_expr_kind_name(expr->kind()));
+        throw errorf("TODO! gen_expr() not implemented for '{:s}'", ast_expr_kind_name(expr->kind()));
     }
 }
 
 Bc_Object *Bytecode::gen_unary(Unary_Expr *unary)
 {
-    Bc_Object *operand = gen_expr(unary->expr);
+    u32 mark = top;
+    Bc_Object *object = gen_expr(unary->expr);
 
-    Ast_Entity *type = NULL;
-    switch (operand->type)
+    switch (unary->op.type)
     {
-    case Bc_Object_Var:
-        type = operand->var->type;
+    case Token_Add:
+        return object;
+
+    case Token_Sub: {
+        top = mark;
+        Bc_Object *neg = object_temp(object->entity);
+        push_instruction(bc_opcode(Bc_Neg, neg->atom), neg->atom, neg->reg, object->reg);
+        return neg;
+    }
+
+    // The value of a post increment is a copy taken before it
+    case Token_Increment:
+    case Token_Decrement: {
+        if (!(object->type & (Bc_Object_Var | Bc_Object_Global)))
+            throw errorf("cannot perform '{:s}' on a temporary value", unary->op.expr);
+
+        Bc_Object *result = object;
+        if (unary->order == Post_Expr)
+        {
+            result = object_temp(object->entity);
+            push_instruction(Bc_Mov, object->atom, result->reg, object->reg);
+        }
+        Bc_Opcode opcode = unary->op.type == Token_Increment ? Bc_Increment : Bc_Decrement;
+        push_instruction(bc_opcode(opcode, object->atom), object->atom, object->reg);
+        gen_store(object);
+        return result;
+    }
+
+    default:
+        throw errorf("TODO! gen_unary() not implemented for '{:s}'", token_typename(unary->op.type));
+    }
+}
+
+// A chain of left operands is generated from its innermost operand back up like Vm::run_binary() runs it, each result
+// takes the first register of the chain
+Bc_Object *Bytecode::gen_binary(Binary_Expr *binary)
+{
+    u32 mark = top;
+    usize base = spine.size();
+    spine.push_back(binary);
+    for (Ast_Expr *prev; (prev = spine.back()->prev)->kind() == Ast_Expr_Binary;)
+        spine.push_back((Binary_Expr *)prev);
+
+    Bc_Object *object = gen_expr(spine.back()->prev);
+    while (spine.size() > base)
+    {
+        binary = spine.back();
+        spine.pop_back();
+        object = gen_binary(binary, object, gen_expr(binary->post), mark);
+    }
+    return object;
+}
+
+// The operands are cast to the type of the operation, a comparison compares them in the type composed from theirs.
+// The result may take the register of an operand, the operands are read before it is written
+Bc_Object *Bytecode::gen_binary(Binary_Expr *binary, Bc_Object *prev, Bc_Object *post, u32 mark)
+{
+    Token_Type op = binary->op.type;
+    if (op == Token_Assign)
+        return gen_assign(prev, post);
+
+    Ast_Entity *type = binary->type;
+    if (op & Token_Logic)
+    {
+        Atom_Type *prev_atom = (Atom_Type *)prev->entity;
+        Atom_Type *post_atom = (Atom_Type *)post->entity;
+        type = type_system.compose_atom(prev_atom->desc | post_atom->desc, std::max(prev_atom->size, post_atom->size));
+    }
+
+    Bc_Opcode opcode = Bc_None;
+    switch (op)
+    {
+    case Token_Add:
+        opcode = Bc_Add;
+        break;
+    case Token_Sub:
+        opcode = Bc_Sub;
+        break;
+    case Token_Mul:
+        opcode = Bc_Mul;
+        break;
+    case Token_Div:
+        opcode = Bc_Div;
+        break;
+    case Token_Mod:
+        opcode = Bc_Mod;
+        break;
+    case Token_Bin_And:
+        opcode = Bc_Bin_And;
+        break;
+    case Token_Bin_Or:
+        opcode = Bc_Bin_Or;
         break;
-    case Bc_Object_Imm:
-        type = operand->imm->type;
+    case Token_Bin_Xor:
+        opcode = Bc_Bin_Xor;
+        break;
+    case Token_Shift_L:
+        opcode = Bc_Shift_L;
+        break;
+    case Token_Shift_R:
+        opcode = Bc_Shift_R;
+        break;
+    case Token_Eq:
+        opcode = Bc_Eq;
+        break;
+    case Token_Not_Eq:
+        opcode = Bc_Not_Eq;
+        break;
+    case Token_Less:
+        opcode = Bc_Less;
+        break;
+    case Token_Less_Eq:
+        opcode = Bc_Less_Eq;
+        break;
+    case Token_Greater:
+        opcode = Bc_Greater;
+        break;
+    case Token_Greater_Eq:
+        opcode = Bc_Greater_Eq;
+        break;
+    case Token_And:
+        opcode = Bc_And;
+        break;
+    case Token_Or:
+        opcode = Bc_Or;
         break;
     default:
-        throw errorf("cannot use object for unary expression");
+        throw errorf("TODO! gen_binary() not implemented for '{:s}'", token_typename(op));
     }
 
-    if (unary->op.type & (Token_Add))
+    Bc_Atom operand_atom = atom(type);
+    if (operand_atom >= Bc_F32 and opcode >= Bc_Bin_And)
+        throw errorf("cannot perform binary operation '{:s}' on float type '{:s}'", binary->op.expr, type->name);
+
+    prev = gen_cast(prev, type);
+    post = gen_cast(post, type);
+    top = mark;
+    Bc_Object *result = object_temp(binary->type);
+    push_instruction(bc_opcode(opcode, operand_atom), operand_atom, result->reg, prev->reg, post->reg);
+    return result;
+}
+
+Bc_Object *Bytecode::gen_assign(Bc_Object *var, Bc_Object *object)
+{
+    if (!(var->type & (Bc_Object_Var | Bc_Object_Global)))
+        throw errorf("cannot assign to a temporary value");
+
+    gen_move(var, object);
+    gen_store(var);
+    return var;
+}
+
+Bc_Object *Bytecode::gen_scope(Scope_Expr *scope)
+{
+    u32 mark = top;
+    for (Ast_Expr *expr : *scope->compound)
+        gen_statement(expr);
+    top = mark;
+    return &none;
+}
+
+// A variable takes its register before its expression is generated above it, a variable without expression is zero
+Bc_Object *Bytecode::gen_var(Var_Expr *def)
+{
+    Bc_Object *var = &none;
+
+    for (; def != NULL; def = def->next)
     {
-        return operand;
+        var = object_var(def->var);
+        u32 mark = top;
+        if (def->expr != NULL)
+            gen_move(var, gen_expr(def->expr));
+        else
+            instructions[push_instruction(Bc_Mov_Const, var->atom, var->reg)].n = 0;
+        top = mark;
+        (*vars)[def->var] = var;
     }
-    else if (unary->op.type & (Token_Sub))
+    return var;
+}
+
+// The globals are loaded into a temporary by the functions, the variables of another function cannot be reached
+Bc_Object *Bytecode::gen_var_id(Id_Expr *id)
+{
+    if (id->entity->kind() != Ast_Entity_Var)
+        throw errorf("'{:s}' does not reference a variable", id->name.expr);
+
+    Var *var = (Var *)id->entity;
+    if (auto local = vars->find(var); local != vars->end())
+        return local->second;
+
+    auto global = globals.find(var);
+    if (global == globals.end())
+        throw errorf("cannot reference '{:s}' outside of its function", id->name.expr);
+
+    Bc_Object *object = object_temp(var->type);
+    object->type = Bc_Object_Global;
+    object->var = var;
+    push_instruction(Bc_Load_Global, object->atom, object->reg, global->second->reg);
+    return object;
+}
+
+Bc_Object *Bytecode::gen_function(Function_Expr *def)
+{
+    functions.push_back(def);
+    return &none;
+}
+
+// A function returns through its first register, which is the one of the invoke in the frame of the caller
+void Bytecode::gen_function_body(Function_Expr *def)
+{
+    if (entries.contains(def->function))
+        throw errorf("redefinition of function '{:s}'", def->function->name);
+    entries[def->function] = instructions.size();
+
+    function = def->function;
+    locals.clear();
+    vars = &locals;
+    top = regs = 0;
+
+    u32 frame = push_instruction(Bc_Frame, Bc_U64, 0);
+    for (Var_Expr *param = function->params; param != NULL; param = param->next)
+        locals[param->var] = object_var(param->var);
+
+    gen_scope(def->scope);
+    // A function that ends without a return gives 0
+    instructions[push_instruction(Bc_Mov_Const, Bc_U64, 0)].n = 0;
+    push_instruction(Bc_Return, Bc_U64, 0);
+    instructions[frame].x = std::max(regs, 1u);
+}
+
+// The arguments are generated in the registers the frame of the function starts from
+Bc_Object *Bytecode::gen_invoke(Function *function, Argument_Expr *argument)
+{
+    u32 base = top;
+
+    for (Var_Expr *param = function->params; param != NULL; param = param->next, argument = argument->next)
     {
-        Bc_Object *sub = object_imm(type);
-        Bc_Instruction mov;
-        Bc_Instruction bin_not;
-        Bc_Instruction increment;
+        if (!argument)
+            throw errorf("missing argument '{:s}' to function '{:s}'", param->name.expr, function->name);
+
+        Bc_Object *arg = object_temp(param->var->type);
+        gen_move(arg, gen_expr(argument->expr));
+        top = arg->reg + 1;
+    }
+    if (argument != NULL)
+        throw errorf("too many arguments to function '{:s}'", function->name);
+    invokes.push_back({push_instruction(Bc_Invoke, Bc_U64, base), function});
+
+    top = base;
+    if (function->type->kind() != Ast_Entity_Atom)
+        return &none;
+    return object_temp(function->type);
+}
 
-        mov.opcode = Bc_Mov;
-        mov.prev = ;
+Bc_Object *Bytecode::gen_atom(Ast_Entity *entity, u64 data, bool is_float)
+{
+    Bc_Object *object = object_temp(entity);
+    u64 word = bc_visit(object->atom, [data, is_float]<typename T>(T) {
+        return bc_word(is_float ? (T)std::bit_cast<f64>(data) : (T)data);
+    });
+
+    instructions[push_instruction(Bc_Mov_Const, object->atom, object->reg)].n = word;
+    return object;
+}
 
-        not_instruction.opcode = Bc_Not;
-        not_instruction.operand = sub;
+Bc_Object *Bytecode::gen_return(Return_Expr *return_expr)
+{
+    if (!function)
+        throw errorf("cannot return outside of a function");
+    if (!return_expr->expr)
+    {
+        push_instruction(Bc_Return, Bc_U64, 0);
+        return &none;
     }
-    else if (unary->op.type & (Token_Decrement | Token_Increment | Token_Bin_Not | Token_Not))
+
+    Bc_Object *object = gen_cast(gen_expr(return_expr->expr), function->type);
+    push_instruction(Bc_Return, object->atom, object->reg);
+    return &none;
+}
+
+Bc_Object *Bytecode::gen_if(If_Expr *if_expr)
+{
+    Bc_Object *condition = gen_expr(if_expr->condition);
+    u32 jump_false = push_instruction(bc_opcode(Bc_Jump_False, condition->atom), condition->atom, condition->reg);
+
+    gen_scope(if_expr->scope_if);
+    if (if_expr->scope_else != NULL)
     {
-        constexpr auto token_to_opcode = [](Token_Type type) -> Bc_Opcode {
-            switch (type)
-            {
-            case Token_Decrement:
-                return Bc_Decrement;
-            case Token_Increment:
-                return Bc_Increment;
-            case Token_Bin_Not:
-                return Bc_Bin_Not;
-            case Token_Not:
-                return Bc_Not;
-            default:
-                return Bc_None;
-            }
-        };
-
-        Bc_Instruction *instruction = &instructions.emplace_back();
-        instruction->opcode = token_to_opcode(unary->op.type);
-        instruction->operand =
+        u32 jump = push_instruction(Bc_Jump, Bc_U64, 0);
+        patch_jump(jump_false);
+        gen_scope(if_expr->scope_else);
+        patch_jump(jump);
     }
     else
     {
-        throw errorf("TODO! gen_unary() support '{}'", token_typename(unary->op.type));
+        patch_jump(jump_false);
     }
+    return &none;
+}
+
+// The variables of the start expression live as long as the loop, the condition is tested before each iteration
+Bc_Object *Bytecode::gen_for(For_Expr *for_expr)
+{
+    u32 mark = top;
+    if (for_expr->start != NULL)
+        gen_expr(for_expr->start);
+
+    u32 loop_mark = top;
+    u32 loop = instructions.size();
+    Bc_Object *condition = gen_expr(for_expr->condition);
+    u32 jump_false = push_instruction(bc_opcode(Bc_Jump_False, condition->atom), condition->atom, condition->reg);
+    top = loop_mark;
+
+    gen_scope(for_expr->scope);
+    if (for_expr->iteration != NULL)
+        gen_expr(for_expr->iteration);
+    push_instruction(Bc_Jump, Bc_U64, 0, loop);
+    patch_jump(jump_false);
+
+    top = mark;
+    return &none;
+}
+
+Bc_Object *Bytecode::gen_for_while(For_While_Expr *for_expr)
+{
+    u32 mark = top;
+    u32 loop = instructions.size();
+    Bc_Object *condition = gen_expr(for_expr->condition);
+    u32 jump_false = push_instruction(bc_opcode(Bc_Jump_False, condition->atom), condition->atom, condition->reg);
+    top = mark;
+
+    gen_scope(for_expr->scope);
+    push_instruction(Bc_Jump, Bc_U64, 0, loop);
+    patch_jump(jump_false);
+    return &none;
+}
+
+Bc_Object *Bytecode::gen_cast(Bc_Object *object, Ast_Entity *type)
+{
+    Bc_Atom into = atom(type);
+    if (object->atom == into)
+        return object;
+
+    Bc_Object *cast = object_temp(type);
+    push_instruction(bc_cast_opcode(object->atom, into), into, cast->reg, object->reg);
+    return cast;
+}
+
+void Bytecode::gen_move(Bc_Object *into, Bc_Object *object)
+{
+    if (object->type == Bc_Object_None)
+        throw errorf("expression does not reduce to a value");
+
+    if (object->atom != into->atom)
+        push_instruction(bc_cast_opcode(object->atom, into->atom), into->atom, into->reg, object->reg);
+    else if (object->reg != into->reg)
+        push_instruction(Bc_Mov, into->atom, into->reg, object->reg);
 }
 
-Bc_Object *Bytecode::gen_binary(Binary_Expr *binary) {}
-Bc_Object *Bytecode::gen_scope(Scope_Expr *scope) {}
-Bc_Object *Bytecode::gen_var(Var_Expr *def) {}
-Bc_Object *Bytecode::gen_var_id(Id_Expr *id) {}
-Bc_Object *Bytecode::gen_function(Function_Expr *def) {}
-Bc_Object *Bytecode::gen_invoke(Invoke_Expr *invoke) {}
-Bc_Object *Bytecode::gen_atom(Ast_Entity *entity, void *data) {}
-Bc_Object *Bytecode::gen_return(Return_Expr *return_expr) {}
-Bc_Object *Bytecode::gen_if(If_Expr *if_expr) {}
+void Bytecode::gen_store(Bc_Object *var)
+{
+    if (var->type == Bc_Object_Global)
+        push_instruction(Bc_Store_Global, var->atom, globals.at(var->var)->reg, var->reg);
+}
+
+u32 Bytecode::push_instruction(Bc_Opcode opcode, Bc_Atom atom, u32 x, u32 y, u32 z)
+{
+    instructions.push_back(Bc_Instruction{opcode, atom, x, {{y, z}}});
+    return instructions.size() - 1;
+}
+
+void Bytecode::patch_jump(u32 jump)
+{
+    instructions[jump].y = instructions.size();
+}
 
 Bc_Object *Bytecode::object_var(Var *var)
 {
-    Bc_Object *object = &objects.push({});
-    // object->
+    Bc_Object *object = object_temp(var->type);
+    object->type = Bc_Object_Var;
+    object->var = var;
+    return object;
 }
 
-Bc_Object *Bytecode::object_imm(Ast_Entity *type) {}
+Bc_Object *Bytecode::object_temp(Ast_Entity *type)
+{
+    regs = std::max(regs, top + 1);
+    return &objects.push(Bc_Object{Bc_Object_Temp, type, atom(type), top++, NULL});
+}
+
+Bc_Atom Bytecode::atom(Ast_Entity *type)
+{
+    if (!type or type->kind() != Ast_Entity_Atom)
+        throw errorf("TODO! cannot generate values of type '{:s}'", type != NULL ? type->name : "?");
+
+    Atom_Type *atom = (Atom_Type *)type;
+    u32 size = std::countr_zero(atom->size);
+    switch (atom->desc)
+    {
+    case Atom_Signed:
+        return Bc_Atom(Bc_S8 + size);
+    case Atom_Float:
+        return size == 2 ? Bc_F32 : Bc_F64;
+    default:
+        return Bc_Atom(Bc_U8 + size);
+    }
+}
 
 } // namespace bee
@@ -5,44 +5,76 @@
 #include "error.hpp"
 #include "fwd.hpp"
 #include "instruction.hpp"
+#include <deque>
 #include <fmt/format.h>
 #include <span>
+#include <unordered_map>
 #include <vector>
 
 namespace bee
 {
 
 struct Ast;
+struct Type_System;
 
+// Lowers the ast to the instructions of a register machine. The code of the main scope comes first, it defines the
+// global variables in the frame at the bottom of the stack then invokes 'main' and exits with its value. The functions
+// follow, each one with its own frame: the arguments are its first registers, the variables and the temporaries are
+// the next ones. The temporaries of an expression are released once it is used, the variables at the end of their
+// scope
 struct Bytecode
 {
     Ast *ast;
+    Type_System &type_system;
     std::vector<Bc_Instruction> instructions;
     Dyn_Arena<Bc_Object, 512> objects;
     Bc_Object none;
 
+    std::unordered_map<Var *, Bc_Object *> globals;
+    std::unordered_map<Var *, Bc_Object *> locals;
+    std::unordered_map<Var *, Bc_Object *> *vars;
+    u32 top = 0;
+    u32 regs = 0;
+    Function *function = NULL;
+    std::vector<Binary_Expr *> spine;
+
+    // The functions are generated after the code that defines them, the invokes are patched with their entry
+    std::deque<Function_Expr *> functions;
+    std::unordered_map<Function *, u32> entries;
+    std::vector<std::pair<u32, Function *>> invokes;
+
     Bytecode(Ast *ast);
     std::span<Bc_Instruction> gen();
+    void gen_statement(Ast_Expr *expr);
     Bc_Object *gen_expr(Ast_Expr *expr);
     Bc_Object *gen_unary(Unary_Expr *unary);
     Bc_Object *gen_binary(Binary_Expr *binary);
+    Bc_Object *gen_binary(Binary_Expr *binary, Bc_Object *prev, Bc_Object *post, u32 mark);
+    Bc_Object *gen_assign(Bc_Object *var, Bc_Object *object);
     Bc_Object *gen_scope(Scope_Expr *scope);
     Bc_Object *gen_var(Var_Expr *def);
     Bc_Object *gen_var_id(Id_Expr *id);
     Bc_Object *gen_function(Function_Expr *def);
-    Bc_Object *gen_invoke(Invoke_Expr *invoke);
-    Bc_Object *gen_atom(Ast_Entity *entity, void *data);
+    void gen_function_body(Function_Expr *def);
+    Bc_Object *gen_invoke(Function *function, Argument_Expr *argument);
+    Bc_Object *gen_atom(Ast_Entity *entity, u64 data, bool is_float);
     Bc_Object *gen_return(Return_Expr *return_expr);
     Bc_Object *gen_if(If_Expr *if_expr);
+    Bc_Object *gen_for(For_Expr *for_expr);
+    Bc_Object *gen_for_while(For_While_Expr *for_expr);
+    Bc_Object *gen_cast(Bc_Object *object, Ast_Entity *type);
+    void gen_move(Bc_Object *into, Bc_Object *object);
+    void gen_store(Bc_Object *var);
 
-    // void push_binary(Bc_Instruction instruction);
-    void push_instruction(Bc_Instruction instruction);
+    u32 push_instruction(Bc_Opcode opcode, Bc_Atom atom, u32 x, u32 y = 0, u32 z = 0);
+    void patch_jump(u32 jump);
     Bc_Object *object_var(Var *var);
-    Bc_Object *object_imm(Ast_Entity *type);
+    Bc_Object *object_temp(Ast_Entity *type);
+    Bc_Atom atom(Ast_Entity *type);
 
     Error errorf(std::string_view fmt, auto... args)
     {
-        return Error{"vm error", fmt::format(fmt::runtime(fmt), args...)};
+        return Error{"bytecode error", fmt::format(fmt::runtime(fmt), args...)};
     }
 };
 
@@ -7,58 +7,111 @@
 namespace bee
 {
 
-enum Bc_Opcode : u8
-{
-    Bc_None,
-
-    Bc_Mov,
-    Bc_Mov_Const,
-
-    Bc_Invoke,
-    Bc_Jump,
+// x, y and z are registers of the frame of the call unless noted otherwise
+//
+//   Frame         x: registers of the function                Invoke      x: first argument  y: entry
+//   Mov           x = y                                       Return      x: returned value
+//   Mov_Const     x = n                                       Jump        y: target
+//   Cast_A_B      x = y from the atom A into the atom B       Jump_False  y: target when x is zero
+//   Load_Global   x = global y                                Exit        x: value of the program of the atom
+//   Store_Global  global x = y                                Neg         x = -y
+//   Increment     x += 1                                      Add ...     x = y op z
+//
+// The operations on values have an opcode for each atom of their operands, chosen by the generator, so that the vm
+// does not look at the atom. The opcodes of a family follow the order of Bc_Atom, the family names its first one
 
-    Bc_Increment,
-    Bc_Decrement,
+#define BC_OPCODES(X)                                                                                                  \
+    X(Bc_None)                                                                                                         \
+    X(Bc_Frame)                                                                                                        \
+    X(Bc_Mov)                                                                                                          \
+    X(Bc_Mov_Const)                                                                                                    \
+    X(Bc_Load_Global)                                                                                                  \
+    X(Bc_Store_Global)                                                                                                 \
+    X(Bc_Invoke)                                                                                                       \
+    X(Bc_Return)                                                                                                       \
+    X(Bc_Jump)                                                                                                         \
+    X(Bc_Exit)
 
-    Bc_Add,
-    Bc_Sub,
-    Bc_Mul,
-    Bc_Div,
-    Bc_Mod,
+#define BC_FAMILIES(X)                                                                                                 \
+    X(Bc_Jump_False)                                                                                                   \
+    X(Bc_Increment)                                                                                                    \
+    X(Bc_Decrement)                                                                                                    \
+    X(Bc_Neg)                                                                                                          \
+    X(Bc_Add)                                                                                                          \
+    X(Bc_Sub)                                                                                                          \
+    X(Bc_Mul)                                                                                                          \
+    X(Bc_Div)                                                                                                          \
+    X(Bc_Mod)                                                                                                          \
+    X(Bc_Eq)                                                                                                           \
+    X(Bc_Not_Eq)                                                                                                       \
+    X(Bc_Less)                                                                                                         \
+    X(Bc_Less_Eq)                                                                                                      \
+    X(Bc_Greater)                                                                                                      \
+    X(Bc_Greater_Eq)                                                                                                   \
+    X(Bc_And)                                                                                                          \
+    X(Bc_Or)                                                                                                           \
+    X(Bc_Bin_And)                                                                                                      \
+    X(Bc_Bin_Or)                                                                                                       \
+    X(Bc_Bin_Xor)                                                                                                      \
+    X(Bc_Shift_L)                                                                                                      \
+    X(Bc_Shift_R)                                                                                                      \
+    X(Bc_Cast_U8)                                                                                                      \
+    X(Bc_Cast_U16)                                                                                                     \
+    X(Bc_Cast_U32)                                                                                                     \
+    X(Bc_Cast_U64)                                                                                                     \
+    X(Bc_Cast_S8)                                                                                                      \
+    X(Bc_Cast_S16)                                                                                                     \
+    X(Bc_Cast_S32)                                                                                                     \
+    X(Bc_Cast_S64)                                                                                                     \
+    X(Bc_Cast_F32)                                                                                                     \
+    X(Bc_Cast_F64)
 
-    Bc_Eq,
-    Bc_Not_Eq,
-    Bc_Less,
-    Bc_Less_Eq,
-    Bc_Greater,
-    Bc_Greater_Eq,
+#define bc_opcode_name(name) name,
+#define bc_typed_name(atom, type, family) family##_##atom,
+#define bc_family_names(family) BC_ATOMS(bc_typed_name, family)
+#define bc_family_alias(family) family = family##_U8,
 
-    Bc_Not,
-    Bc_And,
-    Bc_Or,
+enum Bc_Opcode : u16
+{
+    BC_OPCODES(bc_opcode_name)
+    BC_FAMILIES(bc_family_names)
+    Bc_Opcode_Count,
 
-    Bc_Bin_Not,
-    Bc_Bin_And,
-    Bc_Bin_Or,
-    Bc_Bin_Xor,
-    Bc_Shift_L,
-    Bc_Shift_R,
+    BC_FAMILIES(bc_family_alias)
+    Bc_Cast = Bc_Cast_U8,
 };
 
+#undef bc_opcode_name
+#undef bc_typed_name
+#undef bc_family_names
+#undef bc_family_alias
+
 struct Bc_Instruction
 {
     Bc_Opcode opcode;
+    Bc_Atom atom;
+    u32 x;
 
     union {
-        Bc_Object *v;
         struct
         {
-            Bc_Object *x, y;
+            u32 y, z;
         };
-	u64 n;
+        u64 n;
     };
 };
 
+// The opcode of the family for operands of the atom
+constexpr Bc_Opcode bc_opcode(Bc_Opcode family, Bc_Atom atom)
+{
+    return Bc_Opcode(u32(family) + atom);
+}
+
+constexpr Bc_Opcode bc_cast_opcode(Bc_Atom from, Bc_Atom into)
+{
+    return Bc_Opcode(u32(Bc_Cast) + from * Bc_Atom_Count + into);
+}
+
 } // namespace bee
 
 #endif
@@ -4,7 +4,7 @@
 #include "bitset.hpp"
 #include "core.hpp"
 #include "fwd.hpp"
-#include "register.hpp"
+#include <cstring>
 
 namespace bee
 {
@@ -13,51 +13,117 @@ enum Bc_Object_Type
 {
     Bc_Object_None = 0,
     Bc_Object_Var = bitset(0),
-    Bc_Object_Imm = bitset(1),
-    Bc_Object_Interrupt = bitset(2),
+    Bc_Object_Temp = bitset(1),
+    Bc_Object_Global = bitset(2),
 };
 
-enum Bc_Address_Type
+// The atoms a register holds, in the order of the alternatives of Vm_Atom
+
+enum Bc_Atom : u8
 {
-    Bc_Address_None = 0,
-    Bc_Address_Register = bitset(1),
-    Bc_Address_Stack = bitset(2),
-    Bc_Address_Heap = bitset(3),
+    Bc_U8,
+    Bc_U16,
+    Bc_U32,
+    Bc_U64,
+    Bc_S8,
+    Bc_S16,
+    Bc_S32,
+    Bc_S64,
+    Bc_F32,
+    Bc_F64,
+    Bc_Atom_Count,
 };
 
-// enum Bc_Interrupt
-// {
-//     Bc_Interrupt_None = 0,
-//     Bc_Return = bitset(1),
-//     Bc_ = bitset(1),
-//     Bc_Return = bitset(1),
-//     Bc_Exit = bitset(),
-// };
-
-struct Bc_Address
-{
-    Bc_Address_Type type;
-    union {
-        Register *reg;
-        u64 x;
-    };
-};
+// Expands X(name, type, ...) for each atom in the order of Bc_Atom, the second list expands inside the first
+#define BC_ATOMS(X, ...)                                                                                               \
+    X(U8, u8, __VA_ARGS__)                                                                                             \
+    X(U16, u16, __VA_ARGS__)                                                                                           \
+    X(U32, u32, __VA_ARGS__)                                                                                           \
+    X(U64, u64, __VA_ARGS__)                                                                                           \
+    X(S8, s8, __VA_ARGS__)                                                                                             \
+    X(S16, s16, __VA_ARGS__)                                                                                           \
+    X(S32, s32, __VA_ARGS__)                                                                                           \
+    X(S64, s64, __VA_ARGS__)                                                                                           \
+    X(F32, f32, __VA_ARGS__)                                                                                           \
+    X(F64, f64, __VA_ARGS__)
 
-struct Bc_Imm
-{
-    Ast_Entity *type;
-};
+#define BC_ATOMS_INTO(X, ...)                                                                                          \
+    X(U8, u8, __VA_ARGS__)                                                                                             \
+    X(U16, u16, __VA_ARGS__)                                                                                           \
+    X(U32, u32, __VA_ARGS__)                                                                                           \
+    X(U64, u64, __VA_ARGS__)                                                                                           \
+    X(S8, s8, __VA_ARGS__)                                                                                             \
+    X(S16, s16, __VA_ARGS__)                                                                                           \
+    X(S32, s32, __VA_ARGS__)                                                                                           \
+    X(S64, s64, __VA_ARGS__)                                                                                           \
+    X(F32, f32, __VA_ARGS__)                                                                                           \
+    X(F64, f64, __VA_ARGS__)
 
+// A virtual register of the function being generated: a variable, a temporary value, or a global variable loaded into
+// a temporary that is stored back when it is assigned. The registers are 8 bytes words of the frame of the call
 struct Bc_Object
 {
     Bc_Object_Type type;
-    Bc_Address address;
-    union {
-        Var *var;
-        Bc_Imm *imm;
-    };
+    Ast_Entity *entity;
+    Bc_Atom atom;
+    u32 reg;
+    Var *var;
 };
 
+// The value of an atom is stored in the low bytes of its register, the others are zero
+template <typename T>
+inline T bc_value(u64 word)
+{
+    T value;
+    std::memcpy(&value, &word, sizeof(T));
+    return value;
+}
+
+template <typename T>
+inline u64 bc_word(T value)
+{
+    u64 word = 0;
+    std::memcpy(&word, &value, sizeof(T));
+    return word;
+}
+
+// Calls 'f' with a value of the type of the atom, the switch replaces the visit of a variant
+inline auto bc_visit(Bc_Atom atom, auto &&f)
+{
+    switch (atom)
+    {
+    case Bc_U8:
+        return f(u8{});
+    case Bc_U16:
+        return f(u16{});
+    case Bc_U32:
+        return f(u32{});
+    case Bc_U64:
+        return f(u64{});
+    case Bc_S8:
+        return f(s8{});
+    case Bc_S16:
+        return f(s16{});
+    case Bc_S32:
+        return f(s32{});
+    case Bc_S64:
+        return f(s64{});
+    case Bc_F32:
+        return f(f32{});
+    default:
+        return f(f64{});
+    }
+}
+
+inline u64 bc_cast(Bc_Atom from, Bc_Atom into, u64 word)
+{
+    return bc_visit(from, [into, word]<typename F>(F) {
+        return bc_visit(into, [word]<typename T>(T) {
+            return bc_word((T)bc_value<F>(word));
+        });
+    });
+}
+
 } // namespace bee
 
 #endif
@@ -0,0 +1,224 @@
+#include "vm.hpp"
+#include <cmath>
+#include <type_traits>
+
+namespace bee
+{
+
+// The generator rejects the integer operations on floats, their opcodes only keep the families aligned
+#define bc_int_kernel(name, op)                                                                                        \
+    template <typename T>                                                                                              \
+    inline T name(T a, T b)                                                                                            \
+    {                                                                                                                  \
+        if constexpr (std::is_integral_v<T>)                                                                           \
+            return T(a op b);                                                                                          \
+        else                                                                                                           \
+            return T{};                                                                                                \
+    }
+
+bc_int_kernel(bc_bin_and, &)
+bc_int_kernel(bc_bin_or, |)
+bc_int_kernel(bc_bin_xor, ^)
+bc_int_kernel(bc_shift_l, <<)
+bc_int_kernel(bc_shift_r, >>)
+
+#undef bc_int_kernel
+
+template <typename T>
+inline T bc_div(T a, T b)
+{
+    return T(a / b);
+}
+
+template <typename T>
+inline T bc_mod(T a, T b)
+{
+    if constexpr (std::is_floating_point_v<T>)
+        return std::fmod(a, b);
+    else
+        return T(a % b);
+}
+
+Bc_Vm::Bc_Vm(std::span<const Bc_Instruction> code) : code{code}, stack(Bc_Stack_Size)
+{
+}
+
+// With labels as values each instruction is threaded to the address of its handler once, then every handler jumps
+// straight to the handler of the next instruction. The switch is the portable fallback, the handlers are shared
+s32 Bc_Vm::run()
+{
+    u64 *bp = stack.data();
+    u32 ip = 0;
+    const Bc_Instruction *in = NULL;
+    calls.clear();
+
+#if BEE_BC_THREADED
+#define bc_label(name) &&bc_label_##name,
+#define bc_typed_label(atom, type, family) &&bc_label_##family##_##atom,
+#define bc_family_labels(family) BC_ATOMS(bc_typed_label, family)
+
+    static const void *const labels[Bc_Opcode_Count] = {BC_OPCODES(bc_label) BC_FAMILIES(bc_family_labels)};
+    if (threads.size() != code.size())
+    {
+        threads.clear();
+        for (const Bc_Instruction &instruction : code)
+            threads.push_back(labels[instruction.opcode]);
+    }
+    const void *const *thread = threads.data();
+
+#undef bc_label
+#undef bc_typed_label
+#undef bc_family_labels
+
+#define bc_case(name) bc_label_##name:
+#define bc_next()                                                                                                      \
+    in = &code[ip];                                                                                                    \
+    goto *thread[ip++]
+
+    bc_next();
+#else
+#define bc_case(name) case name:
+#define bc_next() continue
+
+    for (;;)
+    {
+        in = &code[ip++];
+
+        switch (in->opcode)
+        {
+#endif
+
+#define bc_arith(atom, T, family, op)                                                                                  \
+    bc_case(family##_##atom) bp[in->x] = bc_word(T(bc_value<T>(bp[in->y]) op bc_value<T>(bp[in->z])));                 \
+    bc_next();
+
+#define bc_compare(atom, T, family, op)                                                                                \
+    bc_case(family##_##atom) bp[in->x] = bc_word(u8(bc_value<T>(bp[in->y]) op bc_value<T>(bp[in->z])));                \
+    bc_next();
+
+#define bc_kernel(atom, T, family, kernel)                                                                             \
+    bc_case(family##_##atom) bp[in->x] = bc_word(kernel<T>(bc_value<T>(bp[in->y]), bc_value<T>(bp[in->z])));           \
+    bc_next();
+
+#define bc_divide(atom, T, family, kernel)                                                                             \
+    bc_case(family##_##atom)                                                                                           \
+    {                                                                                                                  \
+        if (std::is_integral_v<T> and bc_value<T>(bp[in->z]) == 0)                                                     \
+            throw errorf("division by zero");                                                                          \
+        bp[in->x] = bc_word(kernel<T>(bc_value<T>(bp[in->y]), bc_value<T>(bp[in->z])));                                \
+    }                                                                                                                  \
+    bc_next();
+
+#define bc_step(atom, T, family, op)                                                                                   \
+    bc_case(family##_##atom) bp[in->x] = bc_word(T(bc_value<T>(bp[in->x]) op 1));                                      \
+    bc_next();
+
+#define bc_neg(atom, T, family)                                                                                        \
+    bc_case(family##_##atom) bp[in->x] = bc_word(T(-bc_value<T>(bp[in->y])));                                          \
+    bc_next();
+
+#define bc_jump_false(atom, T, family)                                                                                 \
+    bc_case(family##_##atom)                                                                                           \
+    {                                                                                                                  \
+        if (bc_value<T>(bp[in->x]) == 0)                                                                               \
+            ip = in->y;                                                                                                \
+    }                                                                                                                  \
+    bc_next();
+
+#define bc_cast_into(into, U, from, T)                                                                                 \
+    bc_case(Bc_Cast_##from##_##into) bp[in->x] = bc_word((U)bc_value<T>(bp[in->y]));                                   \
+    bc_next();
+
+#define bc_cast_from(from, T, ...) BC_ATOMS_INTO(bc_cast_into, from, T)
+
+    bc_case(Bc_None) throw errorf("invalid opcode at {}", ip - 1);
+
+    bc_case(Bc_Frame)
+    {
+        if (bp + in->x > stack.data() + stack.size())
+            throw errorf("stack overflow ({} registers)", stack.size());
+    }
+    bc_next();
+
+    bc_case(Bc_Mov) bp[in->x] = bp[in->y];
+    bc_next();
+    bc_case(Bc_Mov_Const) bp[in->x] = in->n;
+    bc_next();
+    bc_case(Bc_Load_Global) bp[in->x] = stack[in->y];
+    bc_next();
+    bc_case(Bc_Store_Global) stack[in->x] = bp[in->y];
+    bc_next();
+
+    bc_case(Bc_Invoke)
+    {
+        if (calls.size() >= Bc_Call_Limit)
+            throw errorf("call stack overflow ({} calls)", Bc_Call_Limit);
+        calls.push_back(Bc_Call{ip, bp});
+        bp += in->x;
+        ip = in->y;
+    }
+    bc_next();
+
+    bc_case(Bc_Return)
+    {
+        bp[0] = bp[in->x];
+        ip = calls.back().ip;
+        bp = calls.back().bp;
+        calls.pop_back();
+    }
+    bc_next();
+
+    bc_case(Bc_Jump) ip = in->y;
+    bc_next();
+
+    bc_case(Bc_Exit) return bc_value<s32>(bc_cast(in->atom, Bc_S32, bp[in->x]));
+
+    BC_ATOMS(bc_jump_false, Bc_Jump_False)
+    BC_ATOMS(bc_step, Bc_Increment, +)
+    BC_ATOMS(bc_step, Bc_Decrement, -)
+    BC_ATOMS(bc_neg, Bc_Neg)
+
+    BC_ATOMS(bc_arith, Bc_Add, +)
+    BC_ATOMS(bc_arith, Bc_Sub, -)
+    BC_ATOMS(bc_arith, Bc_Mul, *)
+    BC_ATOMS(bc_divide, Bc_Div, bc_div)
+    BC_ATOMS(bc_divide, Bc_Mod, bc_mod)
+
+    BC_ATOMS(bc_compare, Bc_Eq, ==)
+    BC_ATOMS(bc_compare, Bc_Not_Eq, !=)
+    BC_ATOMS(bc_compare, Bc_Less, <)
+    BC_ATOMS(bc_compare, Bc_Less_Eq, <=)
+    BC_ATOMS(bc_compare, Bc_Greater, >)
+    BC_ATOMS(bc_compare, Bc_Greater_Eq, >=)
+    BC_ATOMS(bc_compare, Bc_And, &&)
+    BC_ATOMS(bc_compare, Bc_Or, ||)
+
+    BC_ATOMS(bc_kernel, Bc_Bin_And, bc_bin_and)
+    BC_ATOMS(bc_kernel, Bc_Bin_Or, bc_bin_or)
+    BC_ATOMS(bc_kernel, Bc_Bin_Xor, bc_bin_xor)
+    BC_ATOMS(bc_kernel, Bc_Shift_L, bc_shift_l)
+    BC_ATOMS(bc_kernel, Bc_Shift_R, bc_shift_r)
+
+    BC_ATOMS(bc_cast_from)
+
+#if !BEE_BC_THREADED
+        default:
+            throw errorf("invalid opcode at {}", ip - 1);
+        }
+    }
+#endif
+
+#undef bc_case
+#undef bc_next
+#undef bc_arith
+#undef bc_compare
+#undef bc_kernel
+#undef bc_divide
+#undef bc_step
+#undef bc_neg
+#undef bc_jump_false
+#undef bc_cast_into
+#undef bc_cast_from
+}
+
+} // namespace bee
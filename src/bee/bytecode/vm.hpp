@@ -0,0 +1,51 @@
+#ifndef BEE_BYTECODE_VM_HPP
+#define BEE_BYTECODE_VM_HPP
+
+#include "core.hpp"
+#include "error.hpp"
+#include "instruction.hpp"
+#include <fmt/format.h>
+#include <span>
+#include <vector>
+
+namespace bee
+{
+
+// Threaded dispatch needs the labels as values of GCC and Clang, BEE_BC_SWITCH forces the switch
+#if defined(__GNUC__) and !defined(BEE_BC_SWITCH)
+#define BEE_BC_THREADED 1
+#else
+#define BEE_BC_THREADED 0
+#endif
+
+// Registers of the stack shared by the frames of the calls, and calls in progress
+const usize Bc_Stack_Size = 1 << 20;
+const usize Bc_Call_Limit = 1 << 16;
+
+struct Bc_Call
+{
+    u32 ip;
+    u64 *bp;
+};
+
+// Runs the instructions of Bytecode::gen(), the registers of a frame start at its base pointer. 'threads' holds the
+// address of the handler of each instruction
+struct Bc_Vm
+{
+    std::span<const Bc_Instruction> code;
+    std::vector<u64> stack;
+    std::vector<Bc_Call> calls;
+    std::vector<const void *> threads;
+
+    Bc_Vm(std::span<const Bc_Instruction> code);
+    s32 run();
+
+    Error errorf(std::string_view fmt, auto... args)
+    {
+        return Error{"vm error", fmt::format(fmt::runtime(fmt), args...)};
+    }
+};
+
+} // namespace bee
+
+#endif
@@ -0,0 +1,740 @@
+#include "closure.hpp"
+#include "ast.hpp"
+#include "function.hpp"
+#include "type_system.hpp"
+#include "var.hpp"
+#include "vm.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <type_traits>
+
+namespace bee
+{
+
+// The operations bound to the nodes, the atom is a template parameter so that they never look at it while they run
+
+#define cl_arith(name, op)                                                                                             \
+    template <typename T>                                                                                              \
+    u64 name(u64 prev, u64 post)                                                                                       \
+    {                                                                                                                  \
+        return bc_word(T(bc_value<T>(prev) op bc_value<T>(post)));                                                     \
+    }
+
+#define cl_compare(name, op)                                                                                           \
+    template <typename T>                                                                                              \
+    u64 name(u64 prev, u64 post)                                                                                       \
+    {                                                                                                                  \
+        return bc_word(u8(bc_value<T>(prev) op bc_value<T>(post)));                                                    \
+    }
+
+// The compiler rejects the integer operations on floats
+#define cl_int(name, op)                                                                                               \
+    template <typename T>                                                                                              \
+    u64 name(u64 prev, u64 post)                                                                                       \
+    {                                                                                                                  \
+        if constexpr (std::is_integral_v<T>)                                                                           \
+            return bc_word(T(bc_value<T>(prev) op bc_value<T>(post)));                                                 \
+        else                                                                                                           \
+            return 0;                                                                                                  \
+    }
+
+cl_arith(cl_add, +)
+cl_arith(cl_sub, -)
+cl_arith(cl_mul, *)
+cl_compare(cl_eq, ==)
+cl_compare(cl_not_eq, !=)
+cl_compare(cl_less, <)
+cl_compare(cl_less_eq, <=)
+cl_compare(cl_greater, >)
+cl_compare(cl_greater_eq, >=)
+cl_compare(cl_and, &&)
+cl_compare(cl_or, ||)
+cl_int(cl_bin_and, &)
+cl_int(cl_bin_or, |)
+cl_int(cl_bin_xor, ^)
+cl_int(cl_shift_l, <<)
+cl_int(cl_shift_r, >>)
+
+#undef cl_arith
+#undef cl_compare
+#undef cl_int
+
+template <typename T>
+u64 cl_div(u64 prev, u64 post)
+{
+    if (std::is_integral_v<T> and bc_value<T>(post) == 0)
+        throw Error{"vm error", "division by zero"};
+    return bc_word(T(bc_value<T>(prev) / bc_value<T>(post)));
+}
+
+template <typename T>
+u64 cl_mod(u64 prev, u64 post)
+{
+    if constexpr (std::is_floating_point_v<T>)
+        return bc_word(T(std::fmod(bc_value<T>(prev), bc_value<T>(post))));
+    else
+    {
+        if (bc_value<T>(post) == 0)
+            throw Error{"vm error", "division by zero"};
+        return bc_word(T(bc_value<T>(prev) % bc_value<T>(post)));
+    }
+}
+
+template <typename F, typename T>
+u64 cl_cast_word(u64 word)
+{
+    return bc_word((T)bc_value<F>(word));
+}
+
+u64 cl_const(const Cl_Node *node, Cl_Vm &, u64 *)
+{
+    return node->n;
+}
+
+// The globals are the slots of the frame at the bottom of the stack
+template <bool Global>
+u64 cl_load(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    return (Global ? vm.stack.data() : slots)[node->n];
+}
+
+template <bool Global>
+u64 cl_store(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    return (Global ? vm.stack.data() : slots)[node->n] = cl_eval(node->a, vm, slots);
+}
+
+template <typename T, s32 Delta, bool Post, bool Global>
+u64 cl_step(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    u64 &slot = (Global ? vm.stack.data() : slots)[node->n];
+    u64 prev = slot;
+    slot = bc_word(T(bc_value<T>(slot) + Delta));
+    return Post ? prev : slot;
+}
+
+template <typename T>
+u64 cl_neg(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    return bc_word(T(-bc_value<T>(cl_eval(node->a, vm, slots))));
+}
+
+template <typename T>
+u64 cl_truth(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    return bc_value<T>(cl_eval(node->a, vm, slots)) != 0;
+}
+
+u64 cl_cast(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    return node->cast(cl_eval(node->a, vm, slots));
+}
+
+u64 cl_binary(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    u64 prev = cl_eval(node->a, vm, slots);
+    if (node->cast != NULL)
+        prev = node->cast(prev);
+    return node->op(prev, cl_eval(node->b, vm, slots));
+}
+
+// A chain of left operands runs in a loop, the native stack does not grow with its length
+u64 cl_chain(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    u64 value = cl_eval(node->a, vm, slots);
+    for (const Cl_Step &step : node->steps)
+    {
+        if (step.cast != NULL)
+            value = step.cast(value);
+        value = step.op(value, cl_eval(step.post, vm, slots));
+    }
+    return value;
+}
+
+u64 cl_scope(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    for (const Cl_Node *statement : node->nodes)
+    {
+        u64 value = cl_eval(statement, vm, slots);
+        if (vm.returning)
+            return value;
+    }
+    return 0;
+}
+
+u64 cl_return(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    u64 value = cl_eval(node->a, vm, slots);
+    vm.returning = true;
+    return value;
+}
+
+u64 cl_if(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    if (cl_eval(node->a, vm, slots) != 0)
+        return cl_eval(node->b, vm, slots);
+    if (node->c != NULL)
+        return cl_eval(node->c, vm, slots);
+    return 0;
+}
+
+// a: start  b: condition  c: scope  d: iteration
+u64 cl_for(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    if (node->a != NULL)
+        cl_eval(node->a, vm, slots);
+
+    while (cl_eval(node->b, vm, slots) != 0)
+    {
+        u64 value = cl_eval(node->c, vm, slots);
+        if (vm.returning)
+            return value;
+        if (node->d != NULL)
+            cl_eval(node->d, vm, slots);
+    }
+    return 0;
+}
+
+// The frame is taken before the arguments are evaluated in it, the calls they make take the slots above
+u64 cl_invoke(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    const Cl_Function *function = node->function;
+    if (vm.calls >= Cl_Call_Limit)
+        throw vm.errorf("call stack overflow ({} calls)", Cl_Call_Limit);
+    u64 *frame = vm.sp;
+    if (frame + function->slots > vm.stack.data() + vm.stack.size())
+        throw vm.errorf("stack overflow ({} slots)", vm.stack.size());
+
+    vm.sp = frame + function->slots;
+    for (usize n = 0; n < node->nodes.size(); n++)
+        frame[n] = cl_eval(node->nodes[n], vm, slots);
+
+    vm.calls++;
+    u64 value = cl_eval(function->body, vm, frame);
+    vm.calls--;
+    vm.returning = false;
+    vm.sp = frame;
+    return value;
+}
+
+template <typename T>
+Cl_Op cl_op(Token_Type op)
+{
+    switch (op)
+    {
+    case Token_Add:
+        return &cl_add<T>;
+    case Token_Sub:
+        return &cl_sub<T>;
+    case Token_Mul:
+        return &cl_mul<T>;
+    case Token_Div:
+        return &cl_div<T>;
+    case Token_Mod:
+        return &cl_mod<T>;
+    case Token_Bin_And:
+        return &cl_bin_and<T>;
+    case Token_Bin_Or:
+        return &cl_bin_or<T>;
+    case Token_Bin_Xor:
+        return &cl_bin_xor<T>;
+    case Token_Shift_L:
+        return &cl_shift_l<T>;
+    case Token_Shift_R:
+        return &cl_shift_r<T>;
+    case Token_Eq:
+        return &cl_eq<T>;
+    case Token_Not_Eq:
+        return &cl_not_eq<T>;
+    case Token_Less:
+        return &cl_less<T>;
+    case Token_Less_Eq:
+        return &cl_less_eq<T>;
+    case Token_Greater:
+        return &cl_greater<T>;
+    case Token_Greater_Eq:
+        return &cl_greater_eq<T>;
+    case Token_And:
+        return &cl_and<T>;
+    case Token_Or:
+        return &cl_or<T>;
+    default:
+        return NULL;
+    }
+}
+
+inline Cl_Cast cl_cast_for(Bc_Atom from, Bc_Atom into)
+{
+    return bc_visit(from, [into]<typename F>(F) {
+        return bc_visit(into, []<typename T>(T) -> Cl_Cast {
+            return &cl_cast_word<F, T>;
+        });
+    });
+}
+
+Closure::Closure(Ast *ast) : ast{ast}, type_system{ast->type_system}, vars{&globals}
+{
+}
+
+const Cl_Function *Closure::gen()
+{
+    ast->push_frame(ast->main_frame);
+    Cl_Node *body = push_node(&cl_scope, type_system.void_type);
+    for (Ast_Expr *expr : *ast->main_scope->compound)
+    {
+        if (Cl_Node *node = gen_statement(expr))
+            body->nodes.push_back(node);
+    }
+
+    Ast_Entity *main = ast->defs.find(ast->interner.find("main"));
+    ast->pop_frame();
+    if (!main or main->kind() != Ast_Entity_Function)
+        throw errorf("no entry point defined in program, consider the implementation of 'main :: () -> s32'");
+    if (((Function *)main)->type->kind() != Ast_Entity_Atom)
+        throw errorf("entry point 'main' does not return a value");
+
+    // The globals stay below the frame of 'main'
+    Cl_Node *exit = push_node(&cl_return, type_system.s32_type);
+    exit->a = gen_cast(gen_invoke((Function *)main, NULL), type_system.s32_type);
+    body->nodes.push_back(exit);
+    root = Cl_Function{body, slots};
+
+    while (!defs.empty())
+    {
+        gen_function_body(defs.front());
+        defs.pop_front();
+    }
+
+    for (auto [function, entry] : entries)
+    {
+        if (entry->body == NULL)
+            throw errorf("no definition found for function '{:s}'", function->name);
+    }
+    return &root;
+}
+
+// The slots of the variables a statement defines stay until the end of its scope. A name alone has no effect, the
+// compound of an invoke statement holds the name of the function before it
+Cl_Node *Closure::gen_statement(Ast_Expr *expr)
+{
+    if (expr->kind() == Ast_Expr_Id)
+        return NULL;
+
+    u32 mark = top;
+    Cl_Node *node = gen_expr(expr);
+    if (expr->kind() != Ast_Expr_Var)
+        top = mark;
+    return node;
+}
+
+Cl_Node *Closure::gen_expr(Ast_Expr *expr)
+{
+    switch (expr->kind())
+    {
+    case Ast_Expr_Unary:
+        return gen_unary((Unary_Expr *)expr);
+
+    case Ast_Expr_Binary:
+        return gen_binary((Binary_Expr *)expr);
+
+    case Ast_Expr_Nested:
+        return gen_expr(((Nested_Expr *)expr)->expr);
+
+    case Ast_Expr_Scope:
+        return gen_scope((Scope_Expr *)expr);
+
+    case Ast_Expr_Id:
+        return gen_var_id((Id_Expr *)expr);
+
+    case Ast_Expr_Var:
+        return gen_var((Var_Expr *)expr);
+
+    case Ast_Expr_Char:
+        return gen_atom(type_system.typed(expr), (u64)((Char_Expr *)expr)->data, false);
+
+    case Ast_Expr_Int:
+        return gen_atom(type_system.typed(expr), ((Int_Expr *)expr)->data, false);
+
+    case Ast_Expr_Float:
+        return gen_atom(type_system.typed(expr), std::bit_cast<u64>(((Float_Expr *)expr)->data), true);
+
+    case Ast_Expr_Return:
+        return gen_return((Return_Expr *)expr);
+
+    case Ast_Expr_Function:
+        return gen_function((Function_Expr *)expr);
+
+    case Ast_Expr_Invoke:
+        return gen_invoke(((Invoke_Expr *)expr)->function, ((Invoke_Expr *)expr)->args);
+
+    case Ast_Expr_If:
+        return gen_if((If_Expr *)expr);
+
+    case Ast_Expr_For:
+        return gen_for((For_Expr *)expr);
+
+    case Ast_Expr_For_While:
+        return gen_for_while((For_While_Expr *)expr);
+
+    default:
+        throw errorf("TODO! gen_expr() not implemented for '{:s}'", ast_expr_kind_name(expr->kind()));
+    }
+}
+
+Cl_Node *Closure::gen_unary(Unary_Expr *unary)
+{
+    switch (unary->op.type)
+    {
+    case Token_Add:
+        return gen_expr(unary->expr);
+
+    case Token_Sub: {
+        Cl_Node *node = gen_expr(unary->expr);
+        Cl_Node *neg = push_node(NULL, node->type);
+        neg->fn = bc_visit(atom(node->type), []<typename T>(T) -> Cl_Fn {
+            return &cl_neg<T>;
+        });
+        neg->a = node;
+        return neg;
+    }
+
+    // The value of a post increment is the one before it
+    case Token_Increment:
+    case Token_Decrement: {
+        if (unary->expr->kind() != Ast_Expr_Id or ((Id_Expr *)unary->expr)->entity->kind() != Ast_Entity_Var)
+            throw errorf("cannot perform '{:s}' on a temporary value", unary->op.expr);
+
+        auto [n, global] = var_slot((Id_Expr *)unary->expr);
+        Ast_Entity *type = ((Var *)((Id_Expr *)unary->expr)->entity)->type;
+        bool increment = unary->op.type == Token_Increment;
+        bool post = unary->order == Post_Expr;
+
+        Cl_Node *node = push_node(NULL, type);
+        node->n = n;
+        node->fn = bc_visit(atom(type), [=]<typename T>(T) -> Cl_Fn {
+            if (increment)
+            {
+                if (post)
+                    return global ? &cl_step<T, 1, true, true> : &cl_step<T, 1, true, false>;
+                return global ? &cl_step<T, 1, false, true> : &cl_step<T, 1, false, false>;
+            }
+            if (post)
+                return global ? &cl_step<T, -1, true, true> : &cl_step<T, -1, true, false>;
+            return global ? &cl_step<T, -1, false, true> : &cl_step<T, -1, false, false>;
+        });
+        return node;
+    }
+
+    default:
+        throw errorf("TODO! gen_unary() not implemented for '{:s}'", token_typename(unary->op.type));
+    }
+}
+
+// The operands are cast to the type of the operation, a comparison compares them in the type composed from theirs. A
+// chain of left operands is compiled from its innermost operand back up into the steps of one node
+Cl_Node *Closure::gen_binary(Binary_Expr *binary)
+{
+    if (binary->op.type == Token_Assign)
+        return gen_assign(binary);
+
+    usize base = spine.size();
+    spine.push_back(binary);
+    for (Ast_Expr *prev; (prev = spine.back()->prev)->kind() == Ast_Expr_Binary and
+                         ((Binary_Expr *)prev)->op.type != Token_Assign;)
+    {
+        spine.push_back((Binary_Expr *)prev);
+    }
+
+    Cl_Node *first = gen_expr(spine.back()->prev);
+    Cl_Node *chain = push_node(&cl_chain, NULL);
+    chain->a = first;
+    Ast_Entity *prev_type = first->type;
+
+    while (spine.size() > base)
+    {
+        binary = spine.back();
+        spine.pop_back();
+
+        Cl_Node *post = gen_expr(binary->post);
+        Ast_Entity *type = binary->type;
+        if (binary->op.type & Token_Logic)
+        {
+            if ((prev_type->kind() & post->type->kind()) != Ast_Entity_Atom)
+                throw errorf("cannot compare expressions of type '{:s}', '{:s}'", prev_type->name, post->type->name);
+            Atom_Type *prev_atom = (Atom_Type *)prev_type;
+            Atom_Type *post_atom = (Atom_Type *)post->type;
+            type = type_system.compose_atom(prev_atom->desc | post_atom->desc,
+                                            std::max(prev_atom->size, post_atom->size));
+        }
+
+        Bc_Atom operand_atom = atom(type);
+        Cl_Op op = bc_visit(operand_atom, [binary]<typename T>(T) {
+            return cl_op<T>(binary->op.type);
+        });
+        if (op == NULL)
+            throw errorf("TODO! gen_binary() not implemented for '{:s}'", token_typename(binary->op.type));
+        if (operand_atom >= Bc_F32 and
+            binary->op.type & (Token_Bin_And | Token_Bin_Or | Token_Bin_Xor | Token_Shift_L | Token_Shift_R))
+        {
+            throw errorf("cannot perform binary operation '{:s}' on float type '{:s}'", binary->op.expr, type->name);
+        }
+
+        Bc_Atom prev_atom = atom(prev_type);
+        Cl_Cast cast = prev_atom != operand_atom ? cl_cast_for(prev_atom, operand_atom) : NULL;
+        chain->steps.push_back(Cl_Step{op, cast, gen_cast(post, type)});
+        prev_type = binary->type;
+    }
+
+    chain->type = prev_type;
+    if (chain->steps.size() == 1)
+    {
+        chain->fn = &cl_binary;
+        chain->op = chain->steps[0].op;
+        chain->cast = chain->steps[0].cast;
+        chain->b = chain->steps[0].post;
+        chain->steps.clear();
+    }
+    return chain;
+}
+
+Cl_Node *Closure::gen_assign(Binary_Expr *binary)
+{
+    if (binary->prev->kind() != Ast_Expr_Id or ((Id_Expr *)binary->prev)->entity->kind() != Ast_Entity_Var)
+        throw errorf("cannot assign to a temporary value");
+
+    Var *var = (Var *)((Id_Expr *)binary->prev)->entity;
+    auto [n, global] = var_slot((Id_Expr *)binary->prev);
+    Cl_Node *node = push_node(global ? &cl_store<true> : &cl_store<false>, var->type);
+    node->n = n;
+    node->a = gen_cast(gen_expr(binary->post), var->type);
+    return node;
+}
+
+Cl_Node *Closure::gen_scope(Scope_Expr *scope)
+{
+    u32 mark = top;
+    Cl_Node *node = push_node(&cl_scope, type_system.void_type);
+    for (Ast_Expr *expr : *scope->compound)
+    {
+        if (Cl_Node *statement = gen_statement(expr))
+            node->nodes.push_back(statement);
+    }
+    top = mark;
+    return node;
+}
+
+// A variable takes its slot before its expression is compiled, a variable without expression is zero. The variables
+// of a definition are stored in turn
+Cl_Node *Closure::gen_var(Var_Expr *def)
+{
+    Cl_Node *node = push_node(&cl_scope, type_system.void_type);
+
+    for (; def != NULL; def = def->next)
+    {
+        u32 n = slot();
+        Cl_Node *store = push_node(&cl_store<false>, def->var->type);
+        store->n = n;
+        if (def->expr != NULL)
+            store->a = gen_cast(gen_expr(def->expr), def->var->type);
+        else
+            store->a = gen_atom(def->var->type, 0, false);
+        (*vars)[def->var] = n;
+        node->nodes.push_back(store);
+    }
+    return node->nodes.size() == 1 ? node->nodes[0] : node;
+}
+
+Cl_Node *Closure::gen_var_id(Id_Expr *id)
+{
+    if (id->entity->kind() != Ast_Entity_Var)
+        throw errorf("'{:s}' does not reference a variable", id->name.expr);
+
+    auto [n, global] = var_slot(id);
+    Cl_Node *node = push_node(global ? &cl_load<true> : &cl_load<false>, ((Var *)id->entity)->type);
+    node->n = n;
+    return node;
+}
+
+Cl_Node *Closure::gen_function(Function_Expr *def)
+{
+    defs.push_back(def);
+    return NULL;
+}
+
+void Closure::gen_function_body(Function_Expr *def)
+{
+    Cl_Function *function_entry = entry(def->function);
+    if (function_entry->body != NULL)
+        throw errorf("redefinition of function '{:s}'", def->function->name);
+
+    function = def->function;
+    locals.clear();
+    vars = &locals;
+    top = slots = 0;
+
+    for (Var_Expr *param = function->params; param != NULL; param = param->next)
+        locals[param->var] = slot();
+
+    function_entry->body = gen_scope(def->scope);
+    function_entry->slots = slots;
+}
+
+Cl_Node *Closure::gen_invoke(Function *function, Argument_Expr *argument)
+{
+    Cl_Node *node = push_node(&cl_invoke, function->type);
+    node->function = entry(function);
+
+    for (Var_Expr *param = function->params; param != NULL; param = param->next, argument = argument->next)
+    {
+        if (!argument)
+            throw errorf("missing argument '{:s}' to function '{:s}'", param->name.expr, function->name);
+        node->nodes.push_back(gen_cast(gen_expr(argument->expr), param->var->type));
+    }
+    if (argument != NULL)
+        throw errorf("too many arguments to function '{:s}'", function->name);
+    return node;
+}
+
+Cl_Node *Closure::gen_atom(Ast_Entity *entity, u64 data, bool is_float)
+{
+    Cl_Node *node = push_node(&cl_const, entity);
+    node->n = bc_visit(atom(entity), [data, is_float]<typename T>(T) {
+        return bc_word(is_float ? (T)std::bit_cast<f64>(data) : (T)data);
+    });
+    return node;
+}
+
+Cl_Node *Closure::gen_return(Return_Expr *return_expr)
+{
+    if (!function)
+        throw errorf("cannot return outside of a function");
+
+    Cl_Node *node = push_node(&cl_return, function->type);
+    if (!return_expr->expr)
+        node->a = gen_atom(type_system.u64_type, 0, false);
+    else
+        node->a = gen_cast(gen_expr(return_expr->expr), function->type);
+    return node;
+}
+
+Cl_Node *Closure::gen_if(If_Expr *if_expr)
+{
+    Cl_Node *node = push_node(&cl_if, type_system.void_type);
+    node->a = gen_condition(if_expr->condition);
+    node->b = gen_scope(if_expr->scope_if);
+    if (if_expr->scope_else != NULL)
+        node->c = gen_scope(if_expr->scope_else);
+    return node;
+}
+
+// The variables of the start expression live as long as the loop
+Cl_Node *Closure::gen_for(For_Expr *for_expr)
+{
+    u32 mark = top;
+    Cl_Node *node = push_node(&cl_for, type_system.void_type);
+    if (for_expr->start != NULL)
+        node->a = gen_expr(for_expr->start);
+    node->b = gen_condition(for_expr->condition);
+    node->c = gen_scope(for_expr->scope);
+    if (for_expr->iteration != NULL)
+        node->d = gen_expr(for_expr->iteration);
+    top = mark;
+    return node;
+}
+
+Cl_Node *Closure::gen_for_while(For_While_Expr *for_expr)
+{
+    Cl_Node *node = push_node(&cl_for, type_system.void_type);
+    node->b = gen_condition(for_expr->condition);
+    node->c = gen_scope(for_expr->scope);
+    return node;
+}
+
+// A condition is a word that is not zero when it holds, a comparison already is one
+Cl_Node *Closure::gen_condition(Ast_Expr *expr)
+{
+    Cl_Node *node = gen_expr(expr);
+    Bc_Atom condition_atom = atom(node->type);
+    if (condition_atom == Bc_U8)
+        return node;
+
+    Cl_Node *truth = push_node(NULL, type_system.u8_type);
+    truth->fn = bc_visit(condition_atom, []<typename T>(T) -> Cl_Fn {
+        return &cl_truth<T>;
+    });
+    truth->a = node;
+    return truth;
+}
+
+Cl_Node *Closure::gen_cast(Cl_Node *node, Ast_Entity *type)
+{
+    if (node == NULL)
+        throw errorf("expression does not reduce to a value");
+
+    Bc_Atom from = atom(node->type);
+    Bc_Atom into = atom(type);
+    if (from == into)
+        return node;
+
+    Cl_Node *cast = push_node(&cl_cast, type);
+    cast->cast = cl_cast_for(from, into);
+    cast->a = node;
+    return cast;
+}
+
+Cl_Node *Closure::push_node(Cl_Fn fn, Ast_Entity *type)
+{
+    Cl_Node *node = &nodes.emplace_back();
+    node->fn = fn;
+    node->type = type;
+    return node;
+}
+
+Cl_Function *Closure::entry(Function *function)
+{
+    Cl_Function *&entry = entries[function];
+    if (entry == NULL)
+        entry = &functions.emplace_back();
+    return entry;
+}
+
+u32 Closure::slot()
+{
+    slots = std::max(slots, top + 1);
+    return top++;
+}
+
+// The globals are loaded from the bottom of the stack by the functions, the variables of another function cannot be
+// reached
+std::pair<u32, bool> Closure::var_slot(Id_Expr *id)
+{
+    Var *var = (Var *)id->entity;
+    if (auto local = vars->find(var); local != vars->end())
+        return {local->second, false};
+
+    auto global = globals.find(var);
+    if (global == globals.end())
+        throw errorf("cannot reference '{:s}' outside of its function", id->name.expr);
+    return {global->second, true};
+}
+
+Bc_Atom Closure::atom(Ast_Entity *type)
+{
+    if (!type or type->kind() != Ast_Entity_Atom)
+        throw errorf("TODO! cannot compile values of type '{:s}'", type != NULL ? type->name : "?");
+
+    Atom_Type *atom = (Atom_Type *)type;
+    u32 size = std::countr_zero(atom->size);
+    switch (atom->desc)
+    {
+    case Atom_Signed:
+        return Bc_Atom(Bc_S8 + size);
+    case Atom_Float:
+        return size == 2 ? Bc_F32 : Bc_F64;
+    default:
+        return Bc_Atom(Bc_U8 + size);
+    }
+}
+
+} // namespace bee
@@ -0,0 +1,79 @@
+#ifndef BEE_CLOSURE_HPP
+#define BEE_CLOSURE_HPP
+
+#include "bytecode/object.hpp"
+#include "error.hpp"
+#include "fwd.hpp"
+#include "node.hpp"
+#include <deque>
+#include <fmt/format.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace bee
+{
+
+struct Ast;
+struct Type_System;
+
+// Compiles the ast once into a tree of nodes bound to their operations, Cl_Vm runs it by calling the root. The root
+// defines the global variables in its frame then invokes 'main' and returns its value. Like in Bytecode the variables
+// take the slots of their frame until the end of their scope, the values of the expressions are the results of the
+// calls of the nodes
+struct Closure
+{
+    Ast *ast;
+    Type_System &type_system;
+    std::deque<Cl_Node> nodes;
+    std::deque<Cl_Function> functions;
+    Cl_Function root;
+
+    std::unordered_map<Var *, u32> globals;
+    std::unordered_map<Var *, u32> locals;
+    std::unordered_map<Var *, u32> *vars;
+    u32 top = 0;
+    u32 slots = 0;
+    Function *function = NULL;
+    std::vector<Binary_Expr *> spine;
+
+    // The functions are compiled after the code that defines them, the invokes point to their entry
+    std::deque<Function_Expr *> defs;
+    std::unordered_map<Function *, Cl_Function *> entries;
+
+    Closure(Ast *ast);
+    const Cl_Function *gen();
+    Cl_Node *gen_statement(Ast_Expr *expr);
+    Cl_Node *gen_expr(Ast_Expr *expr);
+    Cl_Node *gen_unary(Unary_Expr *unary);
+    Cl_Node *gen_binary(Binary_Expr *binary);
+    Cl_Node *gen_assign(Binary_Expr *binary);
+    Cl_Node *gen_scope(Scope_Expr *scope);
+    Cl_Node *gen_var(Var_Expr *def);
+    Cl_Node *gen_var_id(Id_Expr *id);
+    Cl_Node *gen_function(Function_Expr *def);
+    void gen_function_body(Function_Expr *def);
+    Cl_Node *gen_invoke(Function *function, Argument_Expr *argument);
+    Cl_Node *gen_atom(Ast_Entity *entity, u64 data, bool is_float);
+    Cl_Node *gen_return(Return_Expr *return_expr);
+    Cl_Node *gen_if(If_Expr *if_expr);
+    Cl_Node *gen_for(For_Expr *for_expr);
+    Cl_Node *gen_for_while(For_While_Expr *for_expr);
+    Cl_Node *gen_condition(Ast_Expr *expr);
+    Cl_Node *gen_cast(Cl_Node *node, Ast_Entity *type);
+
+    Cl_Node *push_node(Cl_Fn fn, Ast_Entity *type);
+    Cl_Function *entry(Function *function);
+    u32 slot();
+    std::pair<u32, bool> var_slot(Id_Expr *id);
+    Bc_Atom atom(Ast_Entity *type);
+
+    Error errorf(std::string_view fmt, auto... args)
+    {
+        return Error{"closure error", fmt::format(fmt::runtime(fmt), args...)};
+    }
+};
+
+} // namespace bee
+
+#endif
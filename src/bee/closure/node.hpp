@@ -0,0 +1,59 @@
+#ifndef BEE_CLOSURE_NODE_HPP
+#define BEE_CLOSURE_NODE_HPP
+
+#include "core.hpp"
+#include "fwd.hpp"
+#include <vector>
+
+namespace bee
+{
+
+struct Cl_Node;
+struct Cl_Vm;
+
+// Evaluates a node in the frame of its call and returns its value as a word, 'slots' is the frame
+using Cl_Fn = u64 (*)(const Cl_Node *node, Cl_Vm &vm, u64 *slots);
+using Cl_Op = u64 (*)(u64 prev, u64 post);
+using Cl_Cast = u64 (*)(u64 word);
+
+// An operation of a chain of left operands, the value of the chain so far is cast to the atom of the operation first
+struct Cl_Step
+{
+    Cl_Op op;
+    Cl_Cast cast;
+    Cl_Node *post;
+};
+
+// The arguments of a call are the first slots of its frame, the variables of the function the next ones
+struct Cl_Function
+{
+    Cl_Node *body = NULL;
+    u32 slots = 0;
+};
+
+// A node is bound to the operation for the atoms of its operands, to the slot of its variable and to its children,
+// nothing is looked up while it runs. 'n' is the constant or the slot of the node
+struct Cl_Node
+{
+    Cl_Fn fn;
+    Ast_Entity *type;
+    u64 n = 0;
+    Cl_Node *a = NULL;
+    Cl_Node *b = NULL;
+    Cl_Node *c = NULL;
+    Cl_Node *d = NULL;
+    Cl_Op op = NULL;
+    Cl_Cast cast = NULL;
+    Cl_Function *function = NULL;
+    std::vector<Cl_Node *> nodes;
+    std::vector<Cl_Step> steps;
+};
+
+inline u64 cl_eval(const Cl_Node *node, Cl_Vm &vm, u64 *slots)
+{
+    return node->fn(node, vm, slots);
+}
+
+} // namespace bee
+
+#endif
@@ -0,0 +1,22 @@
+#include "vm.hpp"
+#include "bytecode/object.hpp"
+
+namespace bee
+{
+
+Cl_Vm::Cl_Vm(const Cl_Function *root) : root{root}, stack(Cl_Stack_Size)
+{
+}
+
+s32 Cl_Vm::run()
+{
+    if (root->slots > stack.size())
+        throw errorf("stack overflow ({} slots)", stack.size());
+
+    sp = stack.data() + root->slots;
+    calls = 0;
+    returning = false;
+    return bc_value<s32>(cl_eval(root->body, *this, stack.data()));
+}
+
+} // namespace bee
@@ -0,0 +1,39 @@
+#ifndef BEE_CLOSURE_VM_HPP
+#define BEE_CLOSURE_VM_HPP
+
+#include "core.hpp"
+#include "error.hpp"
+#include "node.hpp"
+#include <fmt/format.h>
+#include <vector>
+
+namespace bee
+{
+
+// Slots of the stack shared by the frames of the calls, and calls in progress. Every call nests the native calls of
+// the nodes of its function
+const usize Cl_Stack_Size = 1 << 20;
+const usize Cl_Call_Limit = 1 << 12;
+
+// Runs the tree of Closure::gen(). The globals are the slots of the frame of the main scope at the bottom of the stack,
+// the frame of a call starts at the first free slot. 'returning' is set by a return until its call is left
+struct Cl_Vm
+{
+    const Cl_Function *root;
+    std::vector<u64> stack;
+    u64 *sp = NULL;
+    usize calls = 0;
+    bool returning = false;
+
+    Cl_Vm(const Cl_Function *root);
+    s32 run();
+
+    Error errorf(std::string_view fmt, auto... args)
+    {
+        return Error{"vm error", fmt::format(fmt::runtime(fmt), args...)};
+    }
+};
+
+} // namespace bee
+
+#endif
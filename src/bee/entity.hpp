@@ -4,7 +4,8 @@
 #include "bitset.hpp"
 #include "core.hpp"
 #include "error.hpp"
-#include <string>
+#include "symbol_table.hpp"
+#include <string_view>
 
 namespace bee
 {
@@ -22,9 +23,12 @@ enum Ast_Entity_Kind : u32
     Ast_Entity_Type = Ast_Entity_Void | Ast_Entity_Function | Ast_Entity_Atom | Ast_Entity_Struct | Ast_Entity_Enum,
 };
 
+// The name points into the interner of the ast, entities with the same name have the same symbol
+
 struct Ast_Entity
 {
-    std::string name;
+    std::string_view name;
+    u32 symbol = Symbol_None;
     virtual ~Ast_Entity() = default;
     virtual Ast_Entity_Kind kind() const = 0;
 };
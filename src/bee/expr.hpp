@@ -17,6 +17,9 @@ struct Function;
 struct Struct_Type;
 struct Enum_Type;
 
+// Declared as in vm/object.hpp, the front end does not depend on the Vm
+using Vm_Kernel = u32 (*)(u8 *result, u8 *prev, u8 *post);
+
 enum Ast_Expr_Kind : u32
 {
     Ast_Expr_None = bitset(0),
@@ -55,12 +58,15 @@ enum Order_Expr : u32
     Post_Expr,
 };
 
+// The type of an expression is cached by Type_System::type_exprs() once the source is parsed
+
 struct Ast_Expr
 {
     virtual ~Ast_Expr() = default;
     virtual Ast_Expr_Kind kind() const = 0;
 
     Token repr;
+    Ast_Entity *typed = NULL;
 };
 
 template <Ast_Expr_Kind K>
@@ -91,6 +97,9 @@ struct Binary_Expr : Ast_Expr_Impl<Ast_Expr_Binary>
     Ast_Entity *type;
     Ast_Expr *prev;
     Ast_Expr *post;
+
+    // Resolved by the Vm for the types of the operands the first time it runs
+    Vm_Kernel kernel = NULL;
 };
 
 struct Nested_Expr : Ast_Expr_Impl<Ast_Expr_Nested>
@@ -102,6 +111,10 @@ struct Scope_Expr : Ast_Expr_Impl<Ast_Expr_Scope>
 {
     Compound_Expr *compound;
     Frame *frame;
+
+    // The main scope and the bodies of the functions open an activation record of 'slots' bytes
+    u32 depth = 0;
+    u32 slots = 0;
 };
 
 struct Return_Expr : Ast_Expr_Impl<Ast_Expr_Return>
@@ -230,6 +243,67 @@ struct Struct_Expr : Ast_Expr_Impl<Ast_Expr_Struct>
     Member_Expr *members;
 };
 
+// Calls f on the child expressions of expr that are not NULL, in the order of the fields
+template <typename F>
+void ast_expr_children(Ast_Expr *expr, F &&f)
+{
+    auto child = [&f](Ast_Expr *expr) {
+        if (expr != NULL)
+            f(expr);
+    };
+
+    switch (expr->kind())
+    {
+    case Ast_Expr_Unary:
+        return child(((Unary_Expr *)expr)->expr);
+    case Ast_Expr_Binary:
+        return child(((Binary_Expr *)expr)->prev), child(((Binary_Expr *)expr)->post);
+    case Ast_Expr_Nested:
+        return child(((Nested_Expr *)expr)->expr);
+    case Ast_Expr_Scope: {
+        Scope_Expr *scope = (Scope_Expr *)expr;
+        if (scope->compound != NULL)
+        {
+            for (Ast_Expr *scope_expr : *scope->compound)
+                child(scope_expr);
+        }
+        return;
+    }
+    case Ast_Expr_Return:
+        return child(((Return_Expr *)expr)->expr);
+    case Ast_Expr_Var:
+        return child(((Var_Expr *)expr)->expr), child(((Var_Expr *)expr)->next);
+    case Ast_Expr_Signature:
+        return child(((Signature_Expr *)expr)->params);
+    case Ast_Expr_Function:
+        return child(((Function_Expr *)expr)->scope);
+    case Ast_Expr_Argument:
+        return child(((Argument_Expr *)expr)->expr), child(((Argument_Expr *)expr)->next);
+    case Ast_Expr_Invoke:
+        return child(((Invoke_Expr *)expr)->args);
+    case Ast_Expr_If: {
+        If_Expr *if_expr = (If_Expr *)expr;
+        return child(if_expr->condition), child(if_expr->scope_if), child(if_expr->scope_else);
+    }
+    case Ast_Expr_For: {
+        For_Expr *for_expr = (For_Expr *)expr;
+        return child(for_expr->start), child(for_expr->condition), child(for_expr->iteration), child(for_expr->scope);
+    }
+    case Ast_Expr_For_While:
+        return child(((For_While_Expr *)expr)->condition), child(((For_While_Expr *)expr)->scope);
+    case Ast_Expr_Record:
+        return child(((Record_Expr *)expr)->scope);
+    case Ast_Expr_Struct:
+        return child(((Struct_Expr *)expr)->members);
+    case Ast_Expr_Member: {
+        Member_Expr *member = (Member_Expr *)expr;
+        return child(member->id), child(member->expr), child(member->next);
+    }
+    default:
+        return;
+    }
+}
+
 constexpr std::string_view ast_expr_kind_name(Ast_Expr_Kind kind)
 {
     switch (kind)
@@ -0,0 +1,282 @@
+#include "flat_ast.hpp"
+#include "ast.hpp"
+#include "function.hpp"
+#include "var.hpp"
+#include <vector>
+
+namespace bee
+{
+
+Flat_Ast::Flat_Ast(const Ast &ast) : source{ast.source}
+{
+    // About one node every 5 characters on the examples, the nodes are only ever appended
+    usize reserve = source.size() / 4 + 1;
+    kinds.reserve(reserve);
+    ops.reserve(reserve);
+    ends.reserve(reserve);
+    offsets.reserve(reserve);
+    sizes.reserve(reserve);
+    payloads.reserve(reserve);
+    words.reserve(reserve);
+
+    push(ast.main_scope);
+}
+
+usize Flat_Ast::bytes() const
+{
+    return kinds.size() * (sizeof(u8) * 2 + sizeof(u32) * 4) + words.size() * sizeof(u64);
+}
+
+u32 Flat_Ast::push(const Ast_Expr *expr)
+{
+    if (!expr)
+    {
+        u32 n = push_node(Ast_Expr_None, Token{});
+        return ends[n] = size(), n;
+    }
+
+    u32 n = 0;
+    switch (expr->kind())
+    {
+    case Ast_Expr_Unary: {
+        const Unary_Expr *unary = (const Unary_Expr *)expr;
+        n = push_node(Ast_Expr_Unary, unary->op);
+        push_word(unary->order);
+        push(unary->expr);
+        break;
+    }
+
+    // A chain of left operands is pushed down as a run of binary nodes, the right operands close it back up
+    case Ast_Expr_Binary: {
+        std::vector<const Binary_Expr *> spine;
+        for (; expr != NULL and expr->kind() == Ast_Expr_Binary; expr = ((const Binary_Expr *)expr)->prev)
+        {
+            const Binary_Expr *binary = (const Binary_Expr *)expr;
+            push_node(Ast_Expr_Binary, binary->op);
+            push_word((u64)binary->type);
+            spine.push_back(binary);
+        }
+        n = size() - spine.size();
+        push(expr);
+
+        for (u32 m = n + spine.size() - 1; !spine.empty(); m--, spine.pop_back())
+        {
+            push(spine.back()->post);
+            ends[m] = size();
+        }
+        break;
+    }
+
+    case Ast_Expr_Nested: {
+        n = push_node(Ast_Expr_Nested, Token{});
+        push(((const Nested_Expr *)expr)->expr);
+        break;
+    }
+
+    case Ast_Expr_Scope: {
+        const Scope_Expr *scope = (const Scope_Expr *)expr;
+        n = push_node(Ast_Expr_Scope, Token{});
+        push_word((u64)scope->frame);
+        if (scope->compound != NULL)
+        {
+            for (const Ast_Expr *scope_expr : *scope->compound)
+                push(scope_expr);
+        }
+        break;
+    }
+
+    case Ast_Expr_Return: {
+        n = push_node(Ast_Expr_Return, Token{});
+        push(((const Return_Expr *)expr)->expr);
+        break;
+    }
+
+    case Ast_Expr_Id: {
+        const Id_Expr *id = (const Id_Expr *)expr;
+        n = push_node(Ast_Expr_Id, id->name);
+        push_word((u64)id->entity);
+        break;
+    }
+
+    case Ast_Expr_Var: {
+        const Var_Expr *var = (const Var_Expr *)expr;
+        n = push_node(Ast_Expr_Var, var->name);
+        push_word((u64)var->var);
+        push_span(var->op);
+        push(var->expr);
+        push(var->next);
+        break;
+    }
+
+    case Ast_Expr_Char: {
+        n = push_node(Ast_Expr_Char, Token{});
+        push_word((u8)((const Char_Expr *)expr)->data);
+        break;
+    }
+
+    case Ast_Expr_Str: {
+        const Str_Expr *str = (const Str_Expr *)expr;
+        n = push_node(Ast_Expr_Str, Token{});
+        push_word((u64)str->data.data());
+        push_word(str->data.size());
+        break;
+    }
+
+    case Ast_Expr_Int: {
+        const Int_Expr *int_expr = (const Int_Expr *)expr;
+        n = push_node(Ast_Expr_Int, Token{});
+        push_word(int_expr->data);
+        push_word(int_expr->size);
+        push_word((u64)int_expr->typed);
+        break;
+    }
+
+    case Ast_Expr_Float: {
+        const Float_Expr *float_expr = (const Float_Expr *)expr;
+        n = push_node(Ast_Expr_Float, Token{});
+        push_word(std::bit_cast<u64>(float_expr->data));
+        push_word(float_expr->size);
+        push_word((u64)float_expr->typed);
+        break;
+    }
+
+    case Ast_Expr_Signature: {
+        const Signature_Expr *signature = (const Signature_Expr *)expr;
+        n = push_node(Ast_Expr_Signature, Token{});
+        push_word((u64)signature->type);
+        push_word((u64)signature->frame);
+        push(signature->params);
+        break;
+    }
+
+    case Ast_Expr_Function: {
+        const Function_Expr *function = (const Function_Expr *)expr;
+        n = push_node(Ast_Expr_Function, Token{});
+        push_word((u64)function->function);
+        push_word((u64)function->scope);
+        bodies[function->scope] = push(function->scope);
+        break;
+    }
+
+    case Ast_Expr_Argument: {
+        const Argument_Expr *argument = (const Argument_Expr *)expr;
+        n = push_node(Ast_Expr_Argument, Token{});
+        push(argument->expr);
+        push(argument->next);
+        break;
+    }
+
+    case Ast_Expr_Invoke: {
+        const Invoke_Expr *invoke = (const Invoke_Expr *)expr;
+        n = push_node(Ast_Expr_Invoke, Token{});
+        push_word((u64)invoke->function);
+        push(invoke->args);
+        break;
+    }
+
+    case Ast_Expr_If: {
+        const If_Expr *if_expr = (const If_Expr *)expr;
+        n = push_node(Ast_Expr_If, Token{});
+        push_word((u64)if_expr->frame);
+        push(if_expr->condition);
+        push(if_expr->scope_if);
+        push(if_expr->scope_else);
+        break;
+    }
+
+    case Ast_Expr_For: {
+        const For_Expr *for_expr = (const For_Expr *)expr;
+        n = push_node(Ast_Expr_For, Token{});
+        push_word((u64)for_expr->frame);
+        push(for_expr->start);
+        push(for_expr->condition);
+        push(for_expr->iteration);
+        push(for_expr->scope);
+        break;
+    }
+
+    case Ast_Expr_For_While: {
+        const For_While_Expr *for_expr = (const For_While_Expr *)expr;
+        n = push_node(Ast_Expr_For_While, Token{});
+        push_word((u64)for_expr->frame);
+        push(for_expr->condition);
+        push(for_expr->scope);
+        break;
+    }
+
+    case Ast_Expr_Typedef: {
+        const Typedef_Expr *typedef_expr = (const Typedef_Expr *)expr;
+        n = push_node(Ast_Expr_Typedef, typedef_expr->name);
+        push_word((u64)typedef_expr->type);
+        push_span(typedef_expr->op);
+        break;
+    }
+
+    case Ast_Expr_Record: {
+        const Record_Expr *record = (const Record_Expr *)expr;
+        n = push_node(Ast_Expr_Record, record->kw);
+        push_word((u64)record->frame);
+        push(record->scope);
+        break;
+    }
+
+    case Ast_Expr_Struct: {
+        const Struct_Expr *struct_expr = (const Struct_Expr *)expr;
+        n = push_node(Ast_Expr_Struct, Token{});
+        push_word((u64)struct_expr->type);
+        push(struct_expr->members);
+        break;
+    }
+
+    case Ast_Expr_Member: {
+        const Member_Expr *member = (const Member_Expr *)expr;
+        n = push_node(Ast_Expr_Member, member->op);
+        push(member->id);
+        push(member->expr);
+        push(member->next);
+        break;
+    }
+
+    default: {
+        n = push_node(Ast_Expr_None, Token{});
+        break;
+    }
+    }
+
+    ends[n] = size();
+    return n;
+}
+
+u32 Flat_Ast::push_node(Ast_Expr_Kind kind, Token token)
+{
+    u64 span = span_word(token);
+
+    kinds.push_back(bit(kind));
+    ops.push_back(bit(token.type));
+    ends.push_back(0);
+    offsets.push_back(span >> 32);
+    sizes.push_back((u32)span);
+    payloads.push_back(words.size());
+    return size() - 1;
+}
+
+void Flat_Ast::push_word(u64 word)
+{
+    words.push_back(word);
+}
+
+void Flat_Ast::push_span(Token token)
+{
+    words.push_back(span_word(token));
+}
+
+// Tokens that are not part of the source (the empty token of a missing operator) get an empty span
+u64 Flat_Ast::span_word(Token token) const
+{
+    usize begin = (usize)token.expr.data() - (usize)source.data();
+    if (begin > source.size() or token.expr.size() > source.size() - begin)
+        return 0;
+    return (u64)begin << 32 | token.expr.size();
+}
+
+} // namespace bee
@@ -0,0 +1,187 @@
+#ifndef BEE_FLAT_AST_HPP
+#define BEE_FLAT_AST_HPP
+
+#include "core.hpp"
+#include "expr.hpp"
+#include <bit>
+#include <unordered_map>
+#include <vector>
+
+namespace bee
+{
+struct Ast;
+struct Flat_Ast;
+
+// Expressions addressed by u32 indices in pre-order: the children of a node follow it, each one ending where its
+// subtree ends. A missing child (no else scope, a var without expression) is a None node so that the children keep
+// their positions. The kind and the type of the main token of the node (the operator, the name or the keyword) are
+// stored as the index of their bit, the token itself as an offset into the source, everything else as payload words:
+//
+//   Unary      op     [order]                          Var        name   [var, op span]         (expr, next)
+//   Binary     op     [type]         (prev, post)      Signature         [type, frame]          (params)
+//   Nested                           (expr)            Function          [function, scope]      (scope)
+//   Scope             [frame]        (exprs...)        Argument                                 (expr, next)
+//   Return                           (expr)            Invoke            [function]             (args)
+//   Id         name   [entity]                         If                [frame]                (condition, if, else)
+//   Char              [data]                           For               [frame]                (start, ..., scope)
+//   Str               [data, size]                     For_While         [frame]                (condition, scope)
+//   Int               [data, size, type]               Typedef    name   [type, op span]
+//   Float             [data, size, type]               Record     kw     [frame]                (scope)
+//   Struct            [type]         (members)         Member     op                            (id, expr, next)
+
+struct Flat_Node;
+
+struct Flat_Children
+{
+    struct Iterator
+    {
+        const Flat_Ast *flat;
+        u32 n;
+
+        Flat_Node operator*() const;
+        Iterator &operator++();
+
+        bool operator!=(const Iterator &it) const
+        {
+            return n != it.n;
+        }
+    };
+
+    const Flat_Ast *flat;
+    u32 first;
+    u32 last;
+
+    Iterator begin() const
+    {
+        return Iterator{flat, first};
+    }
+
+    Iterator end() const
+    {
+        return Iterator{flat, last};
+    }
+};
+
+struct Flat_Node
+{
+    const Flat_Ast *flat;
+    u32 n;
+
+    Ast_Expr_Kind kind() const;
+    Token_Type op() const;
+    std::string_view token() const;
+    std::string_view span(u32 k) const;
+    u64 word(u32 k) const;
+    const u64 *data(u32 k) const;
+    Flat_Node child(u32 k) const;
+    Flat_Children children() const;
+
+    bool none() const
+    {
+        return kind() == Ast_Expr_None;
+    }
+
+    template <typename T>
+    T *ptr(u32 k) const
+    {
+        return (T *)word(k);
+    }
+};
+
+struct Flat_Ast
+{
+    std::string_view source;
+    std::vector<u8> kinds;
+    std::vector<u8> ops;
+    std::vector<u32> ends;
+    std::vector<u32> offsets;
+    std::vector<u32> sizes;
+    std::vector<u32> payloads;
+    std::vector<u64> words;
+    std::unordered_map<const Scope_Expr *, u32> bodies;
+
+    Flat_Ast(const Ast &ast);
+
+    usize size() const
+    {
+        return kinds.size();
+    }
+
+    Flat_Node root() const
+    {
+        return Flat_Node{this, 0};
+    }
+
+    usize bytes() const;
+
+    u32 push(const Ast_Expr *expr);
+    u32 push_node(Ast_Expr_Kind kind, Token token);
+    void push_word(u64 word);
+    void push_span(Token token);
+    u64 span_word(Token token) const;
+
+    static u8 bit(u64 bits)
+    {
+        return bits != 0 ? std::countr_zero(bits) : 64;
+    }
+};
+
+inline Flat_Node Flat_Children::Iterator::operator*() const
+{
+    return Flat_Node{flat, n};
+}
+
+inline Flat_Children::Iterator &Flat_Children::Iterator::operator++()
+{
+    n = flat->ends[n];
+    return *this;
+}
+
+inline Ast_Expr_Kind Flat_Node::kind() const
+{
+    return Ast_Expr_Kind{(u32)bitset(flat->kinds[n])};
+}
+
+inline Token_Type Flat_Node::op() const
+{
+    return flat->ops[n] < 64 ? Token_Type{bitset(flat->ops[n])} : Token_None;
+}
+
+inline std::string_view Flat_Node::token() const
+{
+    return flat->source.substr(flat->offsets[n], flat->sizes[n]);
+}
+
+// A token stored as a payload word, the offset in the high half and the size in the low one
+inline std::string_view Flat_Node::span(u32 k) const
+{
+    u64 span = word(k);
+    return flat->source.substr(span >> 32, (u32)span);
+}
+
+inline u64 Flat_Node::word(u32 k) const
+{
+    return flat->words[flat->payloads[n] + k];
+}
+
+inline const u64 *Flat_Node::data(u32 k) const
+{
+    return &flat->words[flat->payloads[n] + k];
+}
+
+inline Flat_Children Flat_Node::children() const
+{
+    return Flat_Children{flat, n + 1, flat->ends[n]};
+}
+
+inline Flat_Node Flat_Node::child(u32 k) const
+{
+    u32 c = n + 1;
+    while (k-- > 0)
+        c = flat->ends[c];
+    return Flat_Node{flat, c};
+}
+
+} // namespace bee
+
+#endif
@@ -0,0 +1,66 @@
+#include "interner.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace bee
+{
+
+u32 Interner::intern(std::string_view name)
+{
+    if ((names.size() + 1) * 2 > slots.size())
+        rehash(std::max<usize>(256, slots.size() * 2));
+
+    u32 h = hash(name);
+    u32 &slot = slots[probe(name, h)];
+    if (slot != Symbol_None)
+        return slot;
+
+    char *data = (char *)chars.allocate(name.size(), 1);
+    std::memcpy(data, name.data(), name.size());
+
+    names.push_back(std::string_view{data, name.size()});
+    hashes.push_back(h);
+    return slot = names.size() - 1;
+}
+
+u32 Interner::find(std::string_view name) const
+{
+    return !slots.empty() ? slots[probe(name, hash(name))] : Symbol_None;
+}
+
+// The hashes are kept by symbol, names of different hashes are never compared
+usize Interner::probe(std::string_view name, u32 hash) const
+{
+    usize mask = slots.size() - 1;
+    for (usize n = hash & mask;; n = (n + 1) & mask)
+    {
+        u32 slot = slots[n];
+        if (slot == Symbol_None or (hashes[slot] == hash and names[slot] == name))
+            return n;
+    }
+}
+
+void Interner::rehash(usize size)
+{
+    slots.assign(size, Symbol_None);
+
+    for (u32 symbol = 0; symbol < names.size(); symbol++)
+    {
+        usize mask = slots.size() - 1;
+        usize n = hashes[symbol] & mask;
+        while (slots[n] != Symbol_None)
+            n = (n + 1) & mask;
+        slots[n] = symbol;
+    }
+}
+
+// FNV-1a, identifiers are short
+u32 Interner::hash(std::string_view name)
+{
+    u32 hash = 2166136261u;
+    for (char c : name)
+        hash = (hash ^ (u8)c) * 16777619u;
+    return hash;
+}
+
+} // namespace bee
@@ -0,0 +1,43 @@
+#ifndef BEE_INTERNER_HPP
+#define BEE_INTERNER_HPP
+
+#include "arena.hpp"
+#include "core.hpp"
+#include "symbol_table.hpp"
+#include <string_view>
+#include <vector>
+
+namespace bee
+{
+
+// Dense u32 ids of the names, in the order they were first seen. The characters are copied in chunks that never
+// move, the views returned by str() are valid as long as the interner
+
+struct Interner
+{
+    Mem_Arena<4096> chars;
+    std::vector<std::string_view> names;
+    std::vector<u32> hashes;
+    std::vector<u32> slots;
+
+    u32 intern(std::string_view name);
+    u32 find(std::string_view name) const;
+
+    std::string_view str(u32 symbol) const
+    {
+        return names[symbol];
+    }
+
+    usize size() const
+    {
+        return names.size();
+    }
+
+    usize probe(std::string_view name, u32 hash) const;
+    void rehash(usize size);
+    static u32 hash(std::string_view name);
+};
+
+} // namespace bee
+
+#endif
@@ -10,16 +10,92 @@
 namespace bee
 {
 
-Parser::Parser(Scanner *scanner, Ast *ast) : scanner{scanner}, type_system{ast->type_system}, ast{ast} {}
+Parser::Parser(Scanner *scanner, Ast *ast) :
+    ast{ast},
+    type_system{ast->type_system},
+    buffer{std::in_place, *scanner},
+    cursor{&*buffer, 0}
+{
+    buffer->intern(ast->interner);
+}
+
+// A buffer that is not interned has its identifiers interned while parsing
+Parser::Parser(const Token_Buffer *tokens, Ast *ast) : ast{ast}, type_system{ast->type_system}, cursor{tokens, 0}
+{
+    if (tokens->interner != NULL and tokens->interner != &ast->interner)
+        throw Error{"parser error", "token buffer is interned with the names of another ast"};
+}
 
 void Parser::parse()
 {
-    ast->main_frame = ast->push_frame(new Frame{});
+    // The built-in types are defined once per ast, in the owner of the main frame which is kept by Ast::reset()
+    if (ast->builtins == NULL)
+    {
+        ast->builtins = ast->push_frame(&ast->builtin_frame);
+        type_system.std_types(ast);
+    }
+
+    depth = 0;
+    ast->source = cursor.buffer->source;
+    ast->main_frame = ast->push_frame(ast->new_frame());
     ast->main_scope = ast->push_expr(Scope_Expr{});
-    type_system.std_types(ast);
+    ast->main_scope->compound = ast->push_compound(Compound_Expr{});
 
-    ast->main_scope->compound = parse_compound(Token_NewLine, Token_Eof);
+    parse_units(ast->main_scope->compound);
     ast->pop_frame();
+
+    // The statements that failed are missing from an ast with errors, it is not typed
+    if (!diagnostics or diagnostics->empty())
+    {
+        type_system.type_exprs(ast->main_scope);
+        type_system.slot_vars(ast->main_scope);
+    }
+}
+
+// The main scope is parsed as parse_compound() does, recording the units of the ast on the way. A unit starts with
+// the first expression after a line break that ends a statement and ends past the next line break that does
+void Parser::parse_units(Compound_Expr *compound)
+{
+    Ast_Expr *expr = NULL;
+    bool open = false;
+    auto offset = [this](std::string_view::iterator at) {
+        return (u32)(at - ast->source.begin());
+    };
+
+    while (!eof())
+    {
+        Token token = peek(Token_None);
+        usize n = cursor.n;
+        usize defs = ast->frame->defs.size();
+        usize bytes = ast->exprs.size();
+
+        if (!(expr = parse_statement(expr, Token_NewLine, Token_None)))
+        {
+            if (open)
+                ast->units.back().end = offset(token.expr.end());
+            open = false;
+            continue;
+        }
+
+        if (!open)
+            ast->units.push_back(Ast_Unit{offset(token.expr.begin()), 0, {}, {}, {}, 0});
+        open = true;
+
+        Ast_Unit &unit = ast->units.back();
+        compound->push_back(expr);
+        unit.exprs.push_back(expr);
+        unit.bytes += ast->exprs.size() - bytes;
+        unit.defs.insert(unit.defs.end(), ast->frame->defs.begin() + defs, ast->frame->defs.end());
+        for (; n < cursor.n; n++)
+        {
+            if (cursor.buffer->type(n) == Token_Id)
+                unit.symbols.push_back(symbol(cursor.buffer->token(n)));
+        }
+    }
+
+    // The last unit takes what follows it up to the end of the source
+    if (open)
+        ast->units.back().end = offset(cursor.buffer->source.end());
 }
 
 Compound_Expr *Parser::parse_compound(u64 sep_types, u64 end_types)
@@ -30,7 +106,7 @@ Compound_Expr *Parser::parse_compound(u64 sep_types, u64 end_types)
 
     while (!(end = peek(end_types)).ok and !eof())
     {
-        expr = parse_one_expr(expr, sep_types);
+        expr = parse_statement(expr, sep_types, end_types);
         if (expr != NULL)
             compound->emplace_back(expr);
     }
@@ -43,56 +119,70 @@ Compound_Expr *Parser::parse_compound(u64 sep_types, u64 end_types)
     return compound;
 }
 
-Ast_Expr *Parser::parse_expr(u64 end_types)
+// Precedence climbing: the operand of a binary operator is parsed with the power of its operator and stops before
+// the first operator that binds less, which the caller then applies to the whole operand. Chains of left associative
+// operators are built by the loop and not by recursion
+Ast_Expr *Parser::parse_expr(u64 end_types, u32 power)
 {
     Token end;
     Ast_Expr *expr = NULL;
 
+    push_depth();
     while (!(end = peek(end_types)).ok and !eof())
     {
+        if (Token op = peek(Token_Binary); expr != NULL and op.ok and binary_power(op.type).left < power)
+            break;
         expr = parse_one_expr(expr, end_types);
     }
 
-    if (!end.ok)
+    if (!end.ok and eof())
     {
         throw error_expected(end, end_types);
     }
 
+    depth--;
     return expr;
 }
 
 Ast_Expr *Parser::parse_one_expr(Ast_Expr *prev, u64 end_types)
 {
-    // Prev-operand unary expression
-    if (!prev)
+    Token token;
+
+    // The line breaks (and the definition operators out of place) that do not end the expression are skipped
+    do
     {
-        if (Token sign = scan(Token_Add | Token_Sub); sign.ok)
+        // Prev-operand unary expression
+        if (!prev)
         {
-            Unary_Expr *unary_expr = ast->push_expr(Unary_Expr{});
-            unary_expr->op = sign;
-            unary_expr->order = Post_Expr;
-            unary_expr->expr = parse_one_expr(NULL, end_types);
-            unary_expr->repr = unary_expr->op | unary_expr->expr->repr;
-
-            if (type_system.expr_type(unary_expr->expr)->kind() != Ast_Entity_Atom)
+            if (Token sign = scan(Token_Add | Token_Sub); sign.ok)
             {
-                throw errorf(sign, "cannot sign a expression that does not reduce to an atom");
+                push_depth();
+                Unary_Expr *unary_expr = ast->push_expr(Unary_Expr{});
+                unary_expr->op = sign;
+                unary_expr->order = Post_Expr;
+                unary_expr->expr = parse_one_expr(NULL, end_types);
+                unary_expr->repr = unary_expr->op | unary_expr->expr->repr;
+                depth--;
+
+                if (type_system.expr_type(unary_expr->expr)->kind() != Ast_Entity_Atom)
+                {
+                    throw errorf(sign, "cannot sign a expression that does not reduce to an atom");
+                }
+
+                return unary_expr;
             }
-
-            return unary_expr;
         }
-    }
 
-    Token token =
-        scan(Token_Id | Token_Char | Token_Str | Token_Int_Bin | Token_Int_Dec | Token_Int_Hex | Token_Float |
-             Token_Increment | Token_Decrement | Token_Assign | Token_And | Token_Or | Token_Add | Token_Sub |
-             Token_Mul | Token_Div | Token_Mod | Token_Bin_Not | Token_Bin_And | Token_Bin_Or | Token_Bin_Xor |
-             Token_Shift_L | Token_Shift_R | Token_Eq | Token_Not_Eq | Token_Less | Token_Less_Eq | Token_Greater |
-             Token_Greater_Eq | Token_Scope_Begin | Token_Nested_Begin | Token_If | Token_For | Token_Define |
-             Token_Declare | Token_NewLine | Token_Return | Token_Struct | Token_Enum);
+        token = scan(Token_Id | Token_Char | Token_Str | Token_Int_Bin | Token_Int_Dec | Token_Int_Hex | Token_Float |
+                     Token_Increment | Token_Decrement | Token_Assign | Token_And | Token_Or | Token_Add | Token_Sub |
+                     Token_Mul | Token_Div | Token_Mod | Token_Bin_And | Token_Bin_Or | Token_Bin_Xor |
+                     Token_Shift_L | Token_Shift_R | Token_Eq | Token_Not_Eq | Token_Less | Token_Less_Eq |
+                     Token_Greater | Token_Greater_Eq | Token_Scope_Begin | Token_Nested_Begin | Token_If | Token_For |
+                     Token_Define | Token_Declare | Token_NewLine | Token_Return | Token_Struct | Token_Enum);
 
-    if (!token.ok)
-        throw error_expected(token, end_types);
+        if (!token.ok)
+            throw error_expected(token, end_types);
+    } while (token.type & (Token_NewLine | Token_Define | Token_Declare) and !(token.type & end_types));
 
     switch (token.type)
     {
@@ -101,7 +191,7 @@ Ast_Expr *Parser::parse_one_expr(Ast_Expr *prev, u64 end_types)
         {
             return parse_struct((Id_Expr *)prev, token);
         }
-        Frame *frame = ast->push_frame(new Frame{});
+        Frame *frame = ast->push_frame(ast->new_frame());
         Scope_Expr *scope = parse_scope(frame, Token_NewLine, Token_Scope_End);
         ast->pop_frame();
         return scope;
@@ -116,7 +206,7 @@ Ast_Expr *Parser::parse_one_expr(Ast_Expr *prev, u64 end_types)
             }
             return parse_invoke((Id_Expr *)prev, token);
         }
-        ast->push_frame(new Frame{});
+        ast->push_frame(ast->new_frame());
         Ast_Expr *expr = parse_expr(Token_Nested_End);
         scan(Token_Nested_End);
 
@@ -219,7 +309,6 @@ Ast_Expr *Parser::parse_one_expr(Ast_Expr *prev, u64 end_types)
     case Token_Mul:
     case Token_Div:
     case Token_Mod:
-    case Token_Bin_Not:
     case Token_Bin_And:
     case Token_Bin_Or:
     case Token_Bin_Xor:
@@ -231,7 +320,7 @@ Ast_Expr *Parser::parse_one_expr(Ast_Expr *prev, u64 end_types)
     case Token_Less_Eq:
     case Token_Greater:
     case Token_Greater_Eq:
-        return parse_binary_expr(prev, parse_expr(end_types), token);
+        return parse_binary_expr(prev, parse_expr(end_types, binary_power(token.type).right), token);
 
     case Token_Return: {
         Function_Expr *function_expr = (Function_Expr *)stack_find(Ast_Expr_Function);
@@ -257,11 +346,58 @@ Ast_Expr *Parser::parse_one_expr(Ast_Expr *prev, u64 end_types)
     case Token_Enum:
         return parse_record(token, end_types);
 
-    default: {
-        if (token.type & end_types)
-            return NULL;
-        return parse_one_expr(prev, end_types);
+    default:
+        return NULL;
+    }
+}
+
+// A statement of a compound. In recovery mode a statement that fails is dropped: its error is collected, the frames
+// and the expressions it opened are closed and the rest of its tokens skipped
+Ast_Expr *Parser::parse_statement(Ast_Expr *prev, u64 sep_types, u64 end_types)
+{
+    if (!diagnostics)
+        return parse_one_expr(prev, sep_types);
+
+    usize frames = ast->stack.size();
+    usize exprs = stack.size();
+    u32 statement_depth = depth;
+
+    try
+    {
+        return parse_one_expr(prev, sep_types);
     }
+    catch (Error &error)
+    {
+        diagnostics->push_back(std::move(error));
+    }
+
+    while (ast->stack.size() > frames)
+        ast->pop_frame();
+    stack.resize(exprs);
+    depth = statement_depth;
+    skip_statement(end_types);
+    return NULL;
+}
+
+// Skips past the line break that ends the statement, the scopes opened on the way are skipped whole. The end of the
+// compound is left for the compound to scan
+void Parser::skip_statement(u64 end_types)
+{
+    u32 scopes = 0;
+
+    while (!eof())
+    {
+        Token token = peek(Token_None);
+        if (scopes == 0 and token.type & end_types)
+            return;
+
+        scan(token.type);
+        if (token.type == Token_Scope_Begin)
+            scopes++;
+        else if (token.type == Token_Scope_End and scopes > 0)
+            scopes--;
+        else if (token.type == Token_NewLine and scopes == 0)
+            return;
     }
 }
 
@@ -308,10 +444,10 @@ Ast_Expr *Parser::parse_id(Token name, u64 end_types)
 {
     Id_Expr *id = ast->push_expr(Id_Expr{});
     id->name = name;
-    id->entity = ast->frame->find_def(name.expr);
+    id->entity = ast->defs.find(symbol(name));
 
     if (Token def = scan(Token_Define | Token_Declare); def.ok)
-        parse_def(id, def, end_types);
+        return parse_def(id, def, end_types);
     if (!id->entity)
         throw errorf(name, "use of unknown identifier");
     if (id->entity->kind() & Ast_Entity_Var)
@@ -323,7 +459,7 @@ Ast_Expr *Parser::parse_id(Token name, u64 end_types)
 If_Expr *Parser::parse_if(Token kw, u64 end_types)
 {
     If_Expr *expr = ast->push_expr(If_Expr{});
-    expr->frame = ast->push_frame(new Frame{});
+    expr->frame = ast->push_frame(ast->new_frame());
     expr->condition = parse_condition(kw, parse_expr(Token_Scope_Begin));
 
     if (!expr->condition)
@@ -358,7 +494,7 @@ If_Expr *Parser::parse_if(Token kw, u64 end_types)
 
 Ast_Expr *Parser::parse_for(Token kw, u64 end_types)
 {
-    Frame *frame = ast->push_frame(new Frame{});
+    Frame *frame = ast->push_frame(ast->new_frame());
     Ast_Expr *expr = parse_expr(Token_Semicolon | Token_Scope_Begin);
 
     // TODO!
@@ -497,7 +633,7 @@ Ast_Expr *Parser::parse_def(Id_Expr *id, Token op, u64 end_types)
     }
 
     Ast_Entity *type = NULL;
-    Ast_Expr *expr;
+    Ast_Expr *expr = NULL;
 
     if (op.type & Token_Define)
     {
@@ -539,9 +675,8 @@ Var_Expr *Parser::parse_var(Id_Expr *id, Token op, Ast_Expr *expr, Ast_Entity *t
     var_expr->expr = expr;
 
     var_expr->var = new Var{};
-    var_expr->var->name = id->name.expr;
     var_expr->var->type = type;
-    ast->frame->push_def(var_expr->var);
+    ast->push_def(var_expr->var, symbol(id->name));
 
     if (var_expr->expr != NULL)
         on_var_reference(var_expr->var);
@@ -563,15 +698,13 @@ Typedef_Expr *Parser::parse_typedef(Id_Expr *id, Token op, Record_Expr *record,
     switch (record->kw.type)
     {
     case Token_Struct: {
-        Struct_Type *type = ast->frame->push_def(new Struct_Type{});
-        type->name = id->name.expr;
+        Struct_Type *type = ast->push_def(new Struct_Type{}, symbol(id->name));
         type->frame = record->frame;
         typedef_expr->type = type;
     }
 
     case Token_Enum: {
-        Enum_Type *type = ast->frame->push_def(new Enum_Type{});
-        type->name = id->name.expr;
+        Enum_Type *type = ast->push_def(new Enum_Type{}, symbol(id->name));
         type->frame = record->frame;
         typedef_expr->type = type;
     }
@@ -589,8 +722,7 @@ Function_Expr *Parser::parse_function(Id_Expr *id, Token op, Signature_Expr *sig
     Function *function = new Function{};
     function->params = signature->params;
     function->type = signature->type;
-    function->name = id->name.expr;
-    ast->frame->push_def(function);
+    ast->push_def(function, symbol(id->name));
 
     Function_Expr *function_expr = ast->push_expr(Function_Expr{});
 
@@ -611,7 +743,6 @@ Function_Expr *Parser::parse_function(Id_Expr *id, Token op, Signature_Expr *sig
         throw errorf(id->name, "expected function scope after signature");
     }
     function_expr->scope = (Scope_Expr *)scope;
-    Register_Allocator{function_expr, regs, type_system}.allocate();
 
     return function_expr;
 }
@@ -709,7 +840,7 @@ Record_Expr *Parser::parse_record(Token kw, u64 end_types)
 {
     Record_Expr *record = ast->push_expr(Record_Expr{});
     record->kw = kw;
-    record->frame = ast->push_frame(new Frame{});
+    record->frame = ast->push_frame(ast->new_frame());
 
     if (Token scope_begin = scan(Token_Scope_Begin); !scope_begin.ok)
     {
@@ -771,6 +902,12 @@ Member_Expr *Parser::parse_member(Struct_Type *type, s32 n)
     return NULL;
 }
 
+void Parser::push_depth()
+{
+    if (++depth > Parser_Depth_Limit)
+        throw errorf(peek(Token_None), "expression nested deeper than {} levels", Parser_Depth_Limit);
+}
+
 Ast_Expr *Parser::stack_find(Ast_Expr_Kind kind) const
 {
     for (auto it = stack.rbegin(); it != stack.rend(); it++)
@@ -789,46 +926,24 @@ void Parser::on_var_reference(Var *var)
     var->end = ast->expr_count;
 }
 
+u32 Parser::symbol(Token token)
+{
+    return token.symbol != Symbol_None ? token.symbol : ast->interner.intern(token.expr);
+}
+
 bool Parser::eof() const
 {
-    return token_queue.empty() and scanner->eof();
+    return cursor.eof();
 }
 
 Token Parser::peek(u64 types)
 {
-    Token token;
-
-    if (token_queue.size() > 0)
-        token = token_queue.front();
-    else
-        token = token_queue.emplace_back(scanner->tokenize());
-
-    token.ok = token.type & types;
-    return token;
+    return cursor.peek(types);
 }
 
 Token Parser::scan(u64 types)
 {
-    Token token;
-
-    if (token_queue.size() > 0)
-    {
-        token = token_queue.front();
-        token_queue.pop_front();
-    }
-    else
-    {
-        token = scanner->tokenize();
-    }
-
-    token.ok = token.type & types;
-
-    if (!token.ok and token.type != Token_Eof)
-    {
-        token_queue.emplace_back(token);
-    }
-
-    return token;
+    return cursor.scan(types);
 }
 
 Error Parser::error_expected(Token token, u64 types)
@@ -845,7 +960,7 @@ Error Parser::error_expected(Token token, u64 types)
     }
     stream.print("got '{:s}'", token_typename(Token_Type{token.type}));
 
-    return bee_errorf("parser error", scanner->source, token, "{:s}", stream.str());
+    return bee_errorf("parser error", cursor.buffer->source, token, "{:s}", stream.str());
 }
 
 } // namespace bee
@@ -5,27 +5,80 @@
 #include "ast.hpp"
 #include "ast_dump.hpp"
 #include "scanner.hpp"
+#include "token_buffer.hpp"
 #include "type_system.hpp"
+#include <array>
+#include <bit>
 #include <deque>
+#include <optional>
 #include <unordered_set>
 
 namespace bee
 {
 
+// Binding power of the binary operators, an operator takes the operands on its right that bind tighter than 'right'.
+// Left associative operators have right = left + 1, the assignment is right associative
+
+struct Binary_Power
+{
+    u32 left;
+    u32 right;
+};
+
+constexpr auto binary_powers = [] {
+    std::array<Binary_Power, 64> powers = {};
+    auto power = [&powers](Token_Type type, u32 left, bool right_assoc = false) {
+        powers[std::countr_zero((u64)type)] = Binary_Power{left, right_assoc ? left : left + 1};
+    };
+
+    power(Token_Assign, 1, true);
+    power(Token_Or, 3);
+    power(Token_And, 5);
+    power(Token_Bin_Or, 7);
+    power(Token_Bin_Xor, 9);
+    power(Token_Bin_And, 11);
+    power(Token_Eq, 13), power(Token_Not_Eq, 13);
+    power(Token_Less, 15), power(Token_Less_Eq, 15), power(Token_Greater, 15), power(Token_Greater_Eq, 15);
+    power(Token_Shift_L, 17), power(Token_Shift_R, 17);
+    power(Token_Add, 19), power(Token_Sub, 19);
+    power(Token_Mul, 21), power(Token_Div, 21), power(Token_Mod, 21);
+    return powers;
+}();
+
+// '~' is a unary operator, it has no binary power
+constexpr u64 Token_Binary = (Token_Assign | Token_Arithmetic | Token_Logic) & ~(u64)Token_Bin_Not;
+
+// Expressions nested deeper (parentheses, signs, right associative operators) are rejected instead of overflowing the
+// stack of the recursive passes, chains of left associative operators have no depth and no limit
+const u32 Parser_Depth_Limit = 512;
+
+constexpr Binary_Power binary_power(Token_Type type)
+{
+    return binary_powers[std::countr_zero((u64)type)];
+}
+
 struct Parser
 {
     Ast *ast;
-    Scanner *scanner;
     Type_System &type_system;
-    std::deque<Token> token_queue;
+    std::optional<Token_Buffer> buffer;
+    Token_Cursor cursor;
     std::deque<Ast_Expr *> stack;
+    u32 depth = 0;
+    // Recovery mode when given: the errors of the statements are collected there and parsing goes on after them
+    std::vector<Error> *diagnostics = NULL;
 
+    // The source is scanned before parsing, either by the parser itself or into a buffer given by the caller
     Parser(Scanner *scanner, Ast *ast);
+    Parser(const Token_Buffer *tokens, Ast *ast);
     void parse();
 
+    void parse_units(Compound_Expr *compound);
     Compound_Expr *parse_compound(u64 sep_types, u64 end_types);
-    Ast_Expr *parse_expr(u64 end_types);
+    Ast_Expr *parse_expr(u64 end_types, u32 power = 0);
     Ast_Expr *parse_one_expr(Ast_Expr *prev, u64 end_types);
+    Ast_Expr *parse_statement(Ast_Expr *prev, u64 sep_types, u64 end_types);
+    void skip_statement(u64 end_types);
 
     Unary_Expr *parse_increment(Token op, Ast_Expr *prev, u64 end_types);
     Ast_Expr *parse_condition(Token kw, Ast_Expr *expr);
@@ -46,9 +99,11 @@ struct Parser
     Struct_Expr *parse_struct(Ast_Expr *prev, Token scope_begin);
     Member_Expr *parse_member(Struct_Type *type, s32 n);
 
+    void push_depth();
     Ast_Expr *stack_find(Ast_Expr_Kind kind) const;
     void on_var_reference(Var *var);
 
+    u32 symbol(Token token);
     bool eof() const;
     Token peek(u64 types);
     Token scan(u64 types);
@@ -57,8 +112,9 @@ struct Parser
 
     Error errorf(Token token, std::string_view fmt, auto... args)
     {
-        fmt::print("{}", Ast_Dump{ast}.str());
-        return bee_errorf("parser error", scanner->source, token, fmt, args...);
+        if (!diagnostics)
+            fmt::print("{}", Ast_Dump{ast}.str());
+        return bee_errorf("parser error", cursor.buffer->source, token, fmt, args...);
     }
 };
 
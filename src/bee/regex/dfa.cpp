@@ -0,0 +1,53 @@
+#include "dfa.hpp"
+
+namespace bee::regex
+{
+
+// Kept out of line, inlined in the scanner loop the acceleration slows down the short tokens
+
+Dfa_Match Dfa_Table::submit_runs(std::string_view expr) const
+{
+    Dfa_Match match = {npos, 0};
+    u32 state = start;
+    u32 steps = 0;
+
+    for (usize n = 0; n <= expr.size(); n++)
+    {
+        u32 symbol = n < expr.size() ? classes[(u8)expr[n]] : width - 1;
+        Dfa_Edge edge = table[state * width + symbol];
+
+        if (edge.accept != 0)
+            match = {n, edge.accept - 1u};
+
+        // Accelerated states are numbered right after the dead state, a single compare spots both
+        if ((state = edge.state) < accel_end)
+        {
+            if (state == Dfa_Dead)
+                break;
+
+            // Once a run lasts for a few characters the rest of it is skipped with a byte search, short blank
+            // runs are cheaper to walk through the table
+            if (++steps % Dfa_Accel_Steps == 0)
+            {
+                const Dfa_Accel &accel = accels[state - 1];
+                usize end = n + 1 + skip_run(accel, expr.substr(n + 1));
+
+                // Only the last loop edge of the run can be seen in the match
+                if (end != n + 1 and accel.accept != 0)
+                    match = {end - 1, accel.accept - 1u};
+                n = end - 1;
+            }
+        }
+    }
+
+    return match;
+}
+
+usize Dfa_Table::skip_run(const Dfa_Accel &accel, std::string_view run)
+{
+    if (accel.op == Dfa_Accel_Find)
+        return simd_find(run, accel.bytes, accel.size);
+    return simd_skip(run, accel.bytes, accel.size);
+}
+
+} // namespace bee::regex
@@ -0,0 +1,742 @@
+#ifndef BEE_REGEX_DFA_HPP
+#define BEE_REGEX_DFA_HPP
+
+#include "core.hpp"
+#include "node.hpp"
+#include "simd.hpp"
+#include <algorithm>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace bee::regex
+{
+
+constexpr u32 Nfa_Npos = (u32)-1;
+constexpr u32 Dfa_Eof = 256;
+constexpr u32 Dfa_Dead = 0;
+constexpr u32 Dfa_Accel_Steps = 8;
+
+struct Charset
+{
+    u64 bits[4] = {};
+
+    constexpr bool operator[](u32 c) const
+    {
+        return bits[c >> 6] >> (c & 63) & 1;
+    }
+
+    constexpr Charset &set(u32 c, bool value = true)
+    {
+        bits[c >> 6] = (bits[c >> 6] & ~((u64)1 << (c & 63))) | (u64)value << (c & 63);
+        return *this;
+    }
+
+    constexpr Charset &set()
+    {
+        std::fill(bits, bits + 4, ~(u64)0);
+        return *this;
+    }
+
+    constexpr Charset &reset()
+    {
+        std::fill(bits, bits + 4, 0);
+        return *this;
+    }
+
+    constexpr bool all() const
+    {
+        return (bits[0] & bits[1] & bits[2] & bits[3]) == ~(u64)0;
+    }
+
+    constexpr bool none() const
+    {
+        return (bits[0] | bits[1] | bits[2] | bits[3]) == 0;
+    }
+
+    constexpr Charset operator~() const
+    {
+        return Charset{{~bits[0], ~bits[1], ~bits[2], ~bits[3]}};
+    }
+
+    constexpr bool operator==(const Charset &) const = default;
+};
+
+// Hash-consing of u32 lists, numbers the dfa states and the minimization blocks in insertion order
+
+struct Dfa_Interner
+{
+    std::vector<std::vector<u32>> keys;
+    std::vector<u32> buckets;
+
+    constexpr u32 intern(const std::vector<u32> &key)
+    {
+        if (keys.size() * 2 >= buckets.size())
+            rehash(std::max<usize>(64, buckets.size() * 2));
+
+        for (usize n = hash(key);; n++)
+        {
+            u32 &bucket = buckets[n & (buckets.size() - 1)];
+            if (bucket == 0)
+            {
+                keys.push_back(key);
+                return (bucket = keys.size()) - 1;
+            }
+            if (keys[bucket - 1] == key)
+                return bucket - 1;
+        }
+    }
+
+    constexpr void rehash(usize size)
+    {
+        buckets.assign(size, 0);
+
+        for (u32 n = 0; n < keys.size(); n++)
+        {
+            usize bucket = hash(keys[n]);
+            while (buckets[bucket & (size - 1)] != 0)
+                bucket++;
+            buckets[bucket & (size - 1)] = n + 1;
+        }
+    }
+
+    constexpr static usize hash(const std::vector<u32> &key)
+    {
+        u64 hash = 0xcbf29ce484222325;
+        for (u32 x : key)
+            hash = (hash ^ x) * 0x100000001b3;
+        return hash ^ hash >> 29;
+    }
+};
+
+// Flat instruction form of a node graph, threads are ordered by priority the same way Node::submit() explores
+// the edges so that the first thread to reach a Nfa_Match is the match that backtracking would have returned
+
+enum Nfa_Op : u32
+{
+    Nfa_Consume,
+    Nfa_Assert,
+    Nfa_Split,
+    Nfa_Match,
+    Nfa_Fail,
+};
+
+struct Nfa_Inst
+{
+    Nfa_Op op;
+    u32 set;
+    u32 next;
+    u32 size;
+};
+
+struct Nfa_Step
+{
+    u32 accept;
+    std::vector<u32> next;
+};
+
+struct Nfa
+{
+    std::vector<Nfa_Inst> insts;
+    std::vector<u32> splits;
+    std::vector<Charset> sets;
+    std::vector<u32> marks;
+    std::vector<u32> queued;
+    std::vector<u32> stack;
+    u32 start;
+    u32 mark;
+
+    constexpr Nfa() : start{Nfa_Npos}, mark{0} {}
+
+    constexpr Nfa(Node *head) : Nfa()
+    {
+        start = compile(head, 0);
+    }
+
+    constexpr Nfa(std::span<Node *const> heads) : Nfa()
+    {
+        std::vector<u32> entries;
+
+        for (usize n = 0; n < heads.size(); n++)
+        {
+            u32 entry = compile(heads[n], n);
+            if (entry == Nfa_Npos)
+                return;
+            entries.push_back(entry);
+        }
+
+        start = push_inst(Nfa_Inst{Nfa_Split, 0, (u32)splits.size(), (u32)entries.size()});
+        splits.insert(splits.end(), entries.begin(), entries.end());
+    }
+
+    constexpr u32 compile(Node *head, u32 accept)
+    {
+        if (!head)
+            return Nfa_Npos;
+
+        std::vector<std::pair<Node *, u32>> entries;
+        std::vector<std::pair<Node *, u32>> pending;
+        u32 match = push_inst(Nfa_Inst{Nfa_Match, 0, accept, 0});
+        bool ok = true;
+
+        // Every node is lowered as: <state instructions> -> <split over its edges (+ match when not a branch)>
+        const auto entry = [&](Node *node) -> u32 {
+            for (const auto &[member, inst] : entries)
+            {
+                if (member == node)
+                    return inst;
+            }
+
+            u32 cont = push_inst(Nfa_Inst{Nfa_Split, 0, 0, 0});
+            u32 inst = cont;
+            const State &state = node->state;
+            Charset set;
+
+            switch (state.option)
+            {
+            case Regex_Eps:
+                break;
+
+            case Regex_Any:
+                inst = push_inst(Nfa_Inst{Nfa_Consume, push_set(set.set()), cont, 0});
+                break;
+
+            case Regex_Str:
+                if (state.str.empty())
+                {
+                    // An empty string still requires a character to be left in the expression
+                    inst = push_inst(Nfa_Inst{Nfa_Assert, push_set(set.set()), cont, 0});
+                }
+                for (usize n = state.str.size(); n > 0; n--)
+                {
+                    set.reset().set((u8)state.str[n - 1]);
+                    inst = push_inst(Nfa_Inst{Nfa_Consume, push_set(set), inst, 0});
+                }
+                break;
+
+            case Regex_Set:
+                for (char c : state.str)
+                    set.set((u8)c);
+                inst = push_inst(Nfa_Inst{Nfa_Consume, push_set(set), cont, 0});
+                break;
+
+            case Regex_Scope:
+                for (u32 c = 0; c < 256; c++)
+                    set.set(c, state.range[0] <= (char)c and (char)c <= state.range[1]);
+                inst = push_inst(Nfa_Inst{Nfa_Consume, push_set(set), cont, 0});
+                break;
+
+            case Regex_Not:
+                ok = ok and first_set(state.sequence, set);
+                if (set.all())
+                    inst = push_inst(Nfa_Inst{Nfa_Fail, 0, 0, 0});
+                else
+                    inst = push_inst(Nfa_Inst{Nfa_Consume, push_set(~set), cont, 0});
+                break;
+
+            case Regex_Dash:
+                ok = ok and first_set(state.sequence, set);
+                if (set.none())
+                    inst = push_inst(Nfa_Inst{Nfa_Fail, 0, 0, 0});
+                else
+                    inst = push_inst(Nfa_Inst{Nfa_Assert, push_set(set), cont, 0});
+                break;
+
+            default:
+                inst = push_inst(Nfa_Inst{Nfa_Fail, 0, 0, 0});
+                break;
+            }
+
+            pending.emplace_back(node, cont);
+            entries.emplace_back(node, inst);
+            return inst;
+        };
+
+        u32 head_inst = entry(head);
+        std::vector<u32> edges;
+
+        while (!pending.empty() and ok)
+        {
+            auto [node, cont] = pending.back();
+            pending.pop_back();
+            edges.clear();
+
+            for (Node *edge : node->edges)
+                edges.push_back(entry(edge));
+            if (!node->branch())
+                edges.push_back(match);
+
+            insts[cont].next = splits.size();
+            insts[cont].size = edges.size();
+            splits.insert(splits.end(), edges.begin(), edges.end());
+        }
+
+        return ok ? head_inst : Nfa_Npos;
+    }
+
+    constexpr void step(std::span<const u32> threads, u32 symbol, Nfa_Step &step)
+    {
+        step.accept = 0;
+        step.next.clear();
+        marks.resize(insts.size(), 0);
+        queued.resize(insts.size(), 0);
+        mark++;
+
+        // Every instruction is expanded at most once, the stack is sized upfront and indexed directly which is much
+        // cheaper than push_back() when the tables are built during constant evaluation (see static.hpp)
+        stack.resize(insts.size() + splits.size() + threads.size());
+        u32 size = 0;
+
+        for (u32 thread : threads)
+        {
+            stack[size++] = thread;
+
+            while (size != 0)
+            {
+                u32 n = stack[--size];
+
+                if (marks[n] == mark)
+                    continue;
+                marks[n] = mark;
+
+                const Nfa_Inst &inst = insts[n];
+                switch (inst.op)
+                {
+                case Nfa_Consume:
+                    if (symbol != Dfa_Eof and sets[inst.set][symbol] and queued[inst.next] != mark)
+                    {
+                        queued[inst.next] = mark;
+                        step.next.push_back(inst.next);
+                    }
+                    break;
+
+                case Nfa_Assert:
+                    if (symbol != Dfa_Eof and sets[inst.set][symbol])
+                        stack[size++] = inst.next;
+                    break;
+
+                case Nfa_Split:
+                    for (u32 i = inst.size; i > 0; i--)
+                        stack[size++] = splits[inst.next + i - 1];
+                    break;
+
+                case Nfa_Match:
+                    // Lower priority threads can never be reached by the backtracking matcher
+                    step.accept = inst.next + 1;
+                    return;
+
+                case Nfa_Fail:
+                    break;
+                }
+            }
+        }
+    }
+
+    constexpr bool first_set(Node *sequence, Charset &set)
+    {
+        // The lookahead is reduced to a character class when the first character alone decides the match
+        Nfa nfa{sequence};
+        if (nfa.start == Nfa_Npos)
+            return false;
+
+        u8 classes[256] = {}, symbols[256] = {};
+        u32 count = nfa.partition(classes);
+        u32 thread = nfa.start;
+        Nfa_Step first = {}, second = {};
+
+        for (u32 c = 256; c > 0; c--)
+            symbols[classes[c - 1]] = c - 1;
+
+        for (u32 symbol = 0; symbol < count; symbol++)
+        {
+            nfa.step(std::span{&thread, 1}, symbols[symbol], first);
+            bool result = first.accept != 0;
+
+            if (!first.accept and !first.next.empty())
+            {
+                // Every second character (and the end of the expression) must complete the match
+                std::vector<u32> threads = first.next;
+                for (u32 next = 0; next <= count; next++)
+                {
+                    nfa.step(threads, next < count ? symbols[next] : Dfa_Eof, second);
+                    if (!second.accept)
+                        return false;
+                }
+                result = true;
+            }
+
+            for (u32 c = 0; c < 256; c++)
+            {
+                if (classes[c] == symbol)
+                    set.set(c, result);
+            }
+        }
+
+        return true;
+    }
+
+    constexpr u32 partition(u8 classes[256]) const
+    {
+        std::fill(classes, classes + 256, 0);
+        std::vector<s32> remap;
+        u32 count = 1;
+
+        for (const Charset &set : sets)
+        {
+            remap.assign(count * 2, -1);
+            u32 next = 0;
+
+            for (u32 c = 0; c < 256; c++)
+            {
+                s32 &slot = remap[classes[c] * 2 + set[c]];
+                if (slot < 0)
+                    slot = next++;
+                classes[c] = slot;
+            }
+            count = next;
+        }
+
+        return count;
+    }
+
+    constexpr u32 push_inst(Nfa_Inst inst)
+    {
+        insts.push_back(inst);
+        return insts.size() - 1;
+    }
+
+    constexpr u32 push_set(const Charset &set)
+    {
+        auto it = std::find(sets.begin(), sets.end(), set);
+        if (it != sets.end())
+            return it - sets.begin();
+
+        sets.push_back(set);
+        return sets.size() - 1;
+    }
+};
+
+struct Dfa_Edge
+{
+    u16 state;
+    u16 accept;
+};
+
+struct Dfa_Match
+{
+    usize index;
+    u32 accept;
+};
+
+enum Dfa_Accel_Op : u8
+{
+    Dfa_Accel_None,
+    Dfa_Accel_Find,
+    Dfa_Accel_Skip,
+};
+
+// States that loop on themselves for most characters (comment and string bodies, blanks) skip the whole run with
+// a simd byte search: either find the few bytes leaving the state or skip the few bytes staying in it
+
+struct Dfa_Accel
+{
+    Dfa_Accel_Op op;
+    u8 size;
+    u16 accept;
+    u8 bytes[Simd_Needle_Max];
+};
+
+// Non-owning view on a transition table, shared by the runtime Dfa and the build-time Static_Dfa (static.hpp)
+
+struct Dfa_Table
+{
+    const u8 *classes = NULL;
+    const Dfa_Edge *table = NULL;
+    u32 width = 0;
+    u32 start = Dfa_Dead;
+    const Dfa_Accel *accels = NULL;
+    u32 accel_end = Dfa_Dead + 1;
+    Charset runs = {};
+
+    constexpr Dfa_Match submit(std::string_view expr) const
+    {
+        // Only the tokens starting with one of the runs characters can reach an accelerated state, the others take
+        // the plain loop which has no call to spill its registers around
+        if (!std::is_constant_evaluated() and !expr.empty() and runs[(u8)expr[0]])
+            return submit_runs(expr);
+
+        Dfa_Match match = {npos, 0};
+        u32 state = start;
+
+        for (usize n = 0; n <= expr.size(); n++)
+        {
+            u32 symbol = n < expr.size() ? classes[(u8)expr[n]] : width - 1;
+            Dfa_Edge edge = table[state * width + symbol];
+
+            if (edge.accept != 0)
+                match = {n, edge.accept - 1u};
+            if ((state = edge.state) == Dfa_Dead)
+                break;
+        }
+
+        return match;
+    }
+
+    Dfa_Match submit_runs(std::string_view expr) const;
+    static usize skip_run(const Dfa_Accel &accel, std::string_view run);
+
+    constexpr Dfa_Table scalar() const
+    {
+        return Dfa_Table{classes, table, width, start};
+    }
+
+    constexpr Dfa_Accel accel(u32 state) const
+    {
+        u8 stays[256] = {}, exits[256] = {};
+        u32 stay_count = 0, exit_count = 0;
+        u16 accept = 0;
+
+        if (state == Dfa_Dead)
+            return Dfa_Accel{};
+
+        for (u32 c = 0; c < 256; c++)
+        {
+            Dfa_Edge edge = table[state * width + classes[c]];
+            if (edge.state != state)
+            {
+                exits[exit_count++] = c;
+                continue;
+            }
+            if (stay_count != 0 and edge.accept != accept)
+                return Dfa_Accel{};
+
+            accept = edge.accept;
+            stays[stay_count++] = c;
+        }
+
+        Dfa_Accel accel = {Dfa_Accel_None, 0, accept, {}};
+        if (stay_count == 0)
+            return accel;
+
+        if (exit_count <= Simd_Needle_Max)
+        {
+            accel.op = Dfa_Accel_Find;
+            accel.size = exit_count;
+            std::copy_n(exits, exit_count, accel.bytes);
+        }
+        else if (stay_count <= Simd_Needle_Max)
+        {
+            accel.op = Dfa_Accel_Skip;
+            accel.size = stay_count;
+            std::copy_n(stays, stay_count, accel.bytes);
+        }
+
+        return accel;
+    }
+
+    constexpr bool empty() const
+    {
+        return table == NULL;
+    }
+};
+
+// Table-driven matcher built from a node graph with subset construction followed by minimization. Lookaheads are
+// only supported when they reduce to a single character class ('/!a', '/{Q|'\n'}'), otherwise the dfa stays
+// empty and the caller falls back on the backtracking matcher. When built from several graphs, the accept tag
+// of a match is the index of the first graph that matches, as if each graph was tried in order
+
+struct Dfa
+{
+    u8 classes[256] = {};
+    u32 width;
+    u32 start;
+    std::vector<Dfa_Edge> table;
+    std::vector<Dfa_Accel> accels;
+    u32 accel_end;
+    Charset runs;
+
+    constexpr Dfa() : width{0}, start{Dfa_Dead}, accel_end{Dfa_Dead + 1} {}
+
+    constexpr Dfa(Node *head) : Dfa()
+    {
+        Nfa nfa{head};
+        compile(nfa);
+    }
+
+    constexpr Dfa(std::span<Node *const> heads) : Dfa()
+    {
+        Nfa nfa{heads};
+        compile(nfa);
+    }
+
+    constexpr Dfa_Match submit(std::string_view expr) const
+    {
+        return view().submit(expr);
+    }
+
+    constexpr Dfa_Table view() const
+    {
+        return !empty() ? Dfa_Table{classes, table.data(), width, start, accels.data(), accel_end, runs} : Dfa_Table{};
+    }
+
+    constexpr bool empty() const
+    {
+        return table.empty();
+    }
+
+    constexpr void compile(Nfa &nfa)
+    {
+        if (nfa.start == Nfa_Npos)
+            return;
+
+        build(nfa);
+        if (empty())
+            return;
+
+        minimize();
+        accelerate();
+    }
+
+    constexpr void build(Nfa &nfa)
+    {
+        u32 count = nfa.partition(classes);
+        u8 symbols[256] = {};
+        width = count + 1;
+
+        for (u32 c = 256; c > 0; c--)
+            symbols[classes[c - 1]] = c - 1;
+
+        Dfa_Interner states;
+        states.intern({});
+        start = states.intern({nfa.start});
+        Nfa_Step step = {};
+
+        for (u32 state = 0; state < states.keys.size(); state++)
+        {
+            std::vector<u32> threads = states.keys[state];
+            table.resize(table.size() + width);
+
+            for (u32 symbol = 0; symbol < width; symbol++)
+            {
+                nfa.step(threads, symbol < count ? symbols[symbol] : Dfa_Eof, step);
+                u32 next = states.intern(step.next);
+                table[state * width + symbol] = Dfa_Edge{(u16)next, (u16)step.accept};
+            }
+
+            if (states.keys.size() > std::numeric_limits<u16>::max())
+            {
+                table.clear();
+                return;
+            }
+        }
+    }
+
+    constexpr void minimize()
+    {
+        // Moore partition refinement, the transition outputs (accept) are part of every state signature
+        u32 count = table.size() / width;
+        std::vector<u32> blocks(count, 0);
+        u32 block_count = 1;
+
+        while (true)
+        {
+            Dfa_Interner signatures;
+            std::vector<u32> refined(count);
+            std::vector<u32> signature(width + 1);
+
+            for (u32 state = 0; state < count; state++)
+            {
+                signature[0] = blocks[state];
+                for (u32 symbol = 0; symbol < width; symbol++)
+                {
+                    Dfa_Edge edge = table[state * width + symbol];
+                    signature[symbol + 1] = blocks[edge.state] | (u32)edge.accept << 16;
+                }
+                refined[state] = signatures.intern(signature);
+            }
+
+            blocks = std::move(refined);
+            if (signatures.keys.size() == block_count)
+                break;
+            block_count = signatures.keys.size();
+        }
+
+        std::vector<Dfa_Edge> minimized(block_count * width);
+        for (u32 state = 0; state < count; state++)
+        {
+            for (u32 symbol = 0; symbol < width; symbol++)
+            {
+                Dfa_Edge edge = table[state * width + symbol];
+                minimized[blocks[state] * width + symbol] = Dfa_Edge{(u16)blocks[edge.state], edge.accept};
+            }
+        }
+
+        start = blocks[start];
+        table = std::move(minimized);
+    }
+
+    constexpr void accelerate()
+    {
+        // The accelerated states are renumbered right after the dead state, see Dfa_Table::submit()
+        u32 count = table.size() / width;
+        std::vector<Dfa_Accel> found(count);
+        std::vector<u32> ids(count);
+        u32 next = Dfa_Dead + 1;
+
+        for (u32 state = 0; state < count; state++)
+        {
+            found[state] = view().accel(state);
+            if (found[state].op != Dfa_Accel_None)
+            {
+                ids[state] = next++;
+                accels.push_back(found[state]);
+            }
+        }
+
+        accel_end = next;
+        for (u32 state = 0; state < count; state++)
+        {
+            if (state != Dfa_Dead and found[state].op == Dfa_Accel_None)
+                ids[state] = next++;
+        }
+
+        std::vector<Dfa_Edge> renumbered(table.size());
+        for (u32 state = 0; state < count; state++)
+        {
+            for (u32 symbol = 0; symbol < width; symbol++)
+            {
+                Dfa_Edge edge = table[state * width + symbol];
+                renumbered[ids[state] * width + symbol] = Dfa_Edge{(u16)ids[edge.state], edge.accept};
+            }
+        }
+
+        start = ids[start];
+        table = std::move(renumbered);
+
+        // A state leads to a run when one of its edges does, iterated until no state is added
+        std::vector<u8> leads(count, 0);
+        for (u32 state = Dfa_Dead + 1; state < accel_end; state++)
+            leads[state] = true;
+
+        for (bool grown = true; grown;)
+        {
+            grown = false;
+            for (u32 state = accel_end; state < count; state++)
+            {
+                for (u32 symbol = 0; symbol < width and !leads[state]; symbol++)
+                {
+                    if (leads[table[state * width + symbol].state])
+                        leads[state] = grown = true;
+                }
+            }
+        }
+
+        for (u32 c = 0; c < 256; c++)
+            runs.set(c, leads[table[start * width + classes[c]].state]);
+    }
+};
+
+} // namespace bee::regex
+
+#endif
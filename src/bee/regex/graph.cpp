@@ -0,0 +1,294 @@
+#include "graph.hpp"
+#include <algorithm>
+
+namespace bee::regex
+{
+
+Graph::Graph(const Node *head) : Graph()
+{
+    if (!head)
+        return;
+
+    std::vector<const Node *> sources;
+
+    const auto intern = [&](const Node *node) -> u32 {
+        auto it = std::find(sources.begin(), sources.end(), node);
+        if (it != sources.end())
+            return it - sources.begin();
+
+        sources.push_back(node);
+        nodes.push_back(Graph_Node{node->state, Graph_Npos, Graph_Npos, 0, 0, node->branch()});
+        return sources.size() - 1;
+    };
+
+    // Breadth first, the nodes of a sequence end up next to each other
+    this->head = intern(head);
+
+    for (u32 n = 0; n < sources.size(); n++)
+    {
+        const Node *node = sources[n];
+
+        const State &state = node->state;
+        Charset set;
+
+        switch (state.option)
+        {
+        case Regex_Not:
+        case Regex_Dash: {
+            u32 sequence = intern(state.sequence);
+            nodes[n].sequence = sequence;
+            break;
+        }
+
+        case Regex_Set:
+            for (char c : state.str)
+                set.set((u8)c);
+            nodes[n].set = sets.size();
+            sets.push_back(set);
+            break;
+
+        case Regex_Scope:
+            for (u32 c = 0; c < 256; c++)
+                set.set(c, state.range[0] <= (char)c and (char)c <= state.range[1]);
+            nodes[n].set = sets.size();
+            sets.push_back(set);
+            break;
+
+        default:
+            break;
+        }
+
+        nodes[n].begin = edges.size();
+        for (const Node *edge : node->edges)
+        {
+            u32 index = intern(edge);
+            edges.push_back(index);
+        }
+        nodes[n].end = edges.size();
+    }
+}
+
+usize Graph::submit(u32 index, std::string_view expr, usize n) const
+{
+    const Graph_Node &node = nodes[index];
+    usize match = submit_state(node, expr, n);
+
+    if (match != npos)
+    {
+        if (!node.branch and match >= expr.size())
+            return match;
+
+        for (u32 edge = node.begin; edge < node.end; edge++)
+        {
+            usize match_fwd = submit(edges[edge], expr, match);
+            if (match_fwd != npos)
+                return match_fwd;
+        }
+
+        if (!node.branch)
+            return match;
+    }
+
+    return npos;
+}
+
+usize Graph::submit_memo(std::string_view expr) const
+{
+    static thread_local Graph_Memo memo;
+    return submit_memo(expr, memo);
+}
+
+usize Graph::submit_memo(std::string_view expr, Graph_Memo &memo) const
+{
+    using Frame = Graph_Memo::Frame;
+
+    if (head == Graph_Npos)
+        return npos;
+
+    memo.clear();
+    memo.stack.clear();
+    memo.stack.push_back(Frame{head, Graph_Npos, 0, 0});
+
+    const auto key = [&](u32 node, usize n) -> u64 {
+        return (u64)n * nodes.size() + node;
+    };
+
+    usize result = npos;
+
+    while (!memo.stack.empty())
+    {
+        Frame &frame = memo.stack.back();
+        const Graph_Node &node = nodes[frame.node];
+
+        if (frame.edge == Graph_Npos)
+        {
+            // A pair is stored as failed while it is explored, a loop that consumes nothing fails instead of
+            // recursing forever
+            const usize *memoized = memo.find(key(frame.node, frame.n));
+            if (memoized != NULL)
+            {
+                result = *memoized;
+                memo.stack.pop_back();
+                continue;
+            }
+
+            usize match = npos;
+            if (node.state.option == Regex_Not or node.state.option == Regex_Dash)
+            {
+                if (frame.n < expr.size())
+                {
+                    const usize *sequence = memo.find(key(node.sequence, frame.n));
+                    if (sequence == NULL)
+                    {
+                        memo.stack.push_back(Frame{node.sequence, Graph_Npos, frame.n, 0});
+                        continue;
+                    }
+
+                    if (node.state.option == Regex_Not)
+                        match = *sequence != npos ? npos : frame.n + 1;
+                    else
+                        match = *sequence != npos ? frame.n : npos;
+                }
+            }
+            else
+            {
+                match = submit_state(node, expr, frame.n);
+            }
+
+            memo.store(key(frame.node, frame.n), npos);
+
+            if (match == npos or (!node.branch and match >= expr.size()))
+            {
+                memo.store(key(frame.node, frame.n), match);
+                result = match;
+                memo.stack.pop_back();
+                continue;
+            }
+
+            frame.match = match;
+            frame.edge = node.begin;
+        }
+        else if (result != npos)
+        {
+            memo.store(key(frame.node, frame.n), result);
+            memo.stack.pop_back();
+            continue;
+        }
+        else
+        {
+            frame.edge++;
+        }
+
+        if (frame.edge < node.end)
+        {
+            Frame next = Frame{edges[frame.edge], Graph_Npos, frame.match, 0};
+            memo.stack.push_back(next);
+        }
+        else
+        {
+            result = !node.branch ? frame.match : npos;
+            memo.store(key(frame.node, frame.n), result);
+            memo.stack.pop_back();
+        }
+    }
+
+    return result;
+}
+
+// Same as State::submit() with the lookaheads on the flat graph, kept in this unit so that it can be inlined
+usize Graph::submit_state(const Graph_Node &node, std::string_view expr, usize n) const
+{
+    const State &state = node.state;
+
+    if (state.option != Regex_Eps and n >= expr.size())
+        return npos;
+
+    switch (state.option)
+    {
+    case Regex_Eps:
+        return n;
+
+    case Regex_Any:
+        return n + 1;
+
+    case Regex_Not:
+        return submit(node.sequence, expr, n) != npos ? npos : n + 1;
+
+    case Regex_Dash:
+        return submit(node.sequence, expr, n) != npos ? n : npos;
+
+    case Regex_Str:
+        return expr.substr(n, state.str.size()) == state.str ? n + state.str.size() : npos;
+
+    case Regex_Set:
+    case Regex_Scope:
+        return sets[node.set][(u8)expr[n]] ? n + 1 : npos;
+
+    default:
+        return npos;
+    }
+}
+
+void Graph_Memo::clear()
+{
+    size = 0;
+
+    // Every entry is empty again once the epoch wraps around
+    if (++epoch == 0 or entries.empty())
+    {
+        entries.assign(std::max<usize>(entries.size(), 256), Entry{0, 0, 0});
+        epoch = 1;
+    }
+}
+
+const usize *Graph_Memo::find(u64 key) const
+{
+    usize mask = entries.size() - 1;
+
+    for (usize n = hash(key) & mask; entries[n].epoch == epoch; n = (n + 1) & mask)
+    {
+        if (entries[n].key == key)
+            return &entries[n].value;
+    }
+
+    return NULL;
+}
+
+void Graph_Memo::store(u64 key, usize value)
+{
+    usize mask = entries.size() - 1;
+    usize n = hash(key) & mask;
+
+    for (; entries[n].epoch == epoch; n = (n + 1) & mask)
+    {
+        if (entries[n].key == key)
+        {
+            entries[n].value = value;
+            return;
+        }
+    }
+
+    entries[n] = Entry{key, value, epoch};
+
+    // Kept at most half full, the entries of the current match are moved to a table twice as large
+    if (++size * 2 > entries.size())
+    {
+        std::vector<Entry> old = std::move(entries);
+        entries.assign(old.size() * 2, Entry{0, 0, 0});
+        size = 0;
+
+        for (const Entry &entry : old)
+        {
+            if (entry.epoch == epoch)
+                store(entry.key, entry.value);
+        }
+    }
+}
+
+usize Graph_Memo::hash(u64 key)
+{
+    key *= 0x9e3779b97f4a7c15;
+    return key ^ key >> 32;
+}
+
+} // namespace bee::regex
@@ -0,0 +1,88 @@
+#ifndef BEE_REGEX_GRAPH_HPP
+#define BEE_REGEX_GRAPH_HPP
+
+#include "core.hpp"
+#include "dfa.hpp"
+#include "node.hpp"
+#include "state.hpp"
+#include <vector>
+
+namespace bee::regex
+{
+
+constexpr u32 Graph_Npos = (u32)-1;
+
+// Flat form of a parsed node graph for the backtracking matcher: the nodes are stored in the order they are first
+// reached and their edges are index ranges of one array, already sorted by Parser::parse(). Sets and scopes are
+// tested against a charset instead of searching the characters of the pattern
+
+struct Graph_Node
+{
+    State state;
+    u32 sequence;
+    u32 set;
+    u32 begin;
+    u32 end;
+    bool branch;
+};
+
+// Results of the (node, position) pairs already explored by Graph::submit_memo(), the table is reused from one match
+// to the next and an entry only belongs to the current match when it has the current epoch
+
+struct Graph_Memo
+{
+    struct Entry
+    {
+        u64 key;
+        usize value;
+        u32 epoch;
+    };
+
+    struct Frame
+    {
+        u32 node;
+        u32 edge;
+        usize n;
+        usize match;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<Frame> stack;
+    usize size;
+    u32 epoch;
+
+    Graph_Memo() : size{0}, epoch{0} {}
+
+    void clear();
+    const usize *find(u64 key) const;
+    void store(u64 key, usize value);
+    static usize hash(u64 key);
+};
+
+struct Graph
+{
+    std::vector<Graph_Node> nodes;
+    std::vector<u32> edges;
+    std::vector<Charset> sets;
+    u32 head;
+
+    Graph() : head{Graph_Npos} {}
+    Graph(const Node *head);
+
+    usize submit(std::string_view expr) const
+    {
+        return head != Graph_Npos ? submit(head, expr, 0) : npos;
+    }
+
+    usize submit(u32 node, std::string_view expr, usize n) const;
+    usize submit_state(const Graph_Node &node, std::string_view expr, usize n) const;
+
+    // Same result as submit() but every (node, position) pair is explored at most once, nested quantifiers cannot
+    // blow up and the time is bound by O(nodes x input). The recursion is unrolled on the memo stack
+    usize submit_memo(std::string_view expr) const;
+    usize submit_memo(std::string_view expr, Graph_Memo &memo) const;
+};
+
+} // namespace bee::regex
+
+#endif
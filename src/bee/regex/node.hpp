@@ -3,21 +3,31 @@
 
 #include "arena.hpp"
 #include "state.hpp"
-#include <set>
-#include <vector>
+#include <algorithm>
 
 namespace bee::regex
 {
 
-using Node_Arena = Arena<struct Node, 32>;
+constexpr usize Node_Arena_Size = 32;
+constexpr usize Node_Edge_Max = 8;
+
+using Node_Arena = Dyn_Arena<struct Node, Node_Arena_Size>;
+
+// Graph construction is constexpr so that patterns can be compiled at build time (see static.hpp). The arenas only
+// allocate for patterns of more than Node_Arena_Size nodes, the edges are appended while parsing and sorted by index
+// once the parser is done (see Node::sort()), matching is done on the flat form of graph.hpp
 
 struct Node
 {
     struct Cmp
     {
-        bool operator()(const Node *a, const Node *b) const;
+        constexpr bool operator()(const Node *a, const Node *b) const
+        {
+            return a->index < b->index;
+        }
     };
-    using Set = std::set<Node *, Cmp>;
+    using Set = Arena<Node *, Node_Edge_Max>;
+    using Members = Dyn_Arena<Node *, Node_Arena_Size>;
 
     State state;
     s32 index;
@@ -25,16 +35,96 @@ struct Node
 
     usize submit(std::string_view expr, usize n) const;
 
-    Node *push(Node *node);
-    Node *merge(Node *node);
-    Node *concat(Node *node);
-    void map(s32 base);
-    Node *end();
-    Node *max_edge() const;
-    bool branch() const;
+    constexpr Node *push(Node *node)
+    {
+        node->map(end()->index + 1);
+        return insert(edges, node);
+    }
+
+    constexpr Node *merge(Node *node)
+    {
+        node->map(end()->index + 1);
+        return concat(node);
+    }
+
+    constexpr Node *concat(Node *node)
+    {
+        for (Node *member : members())
+        {
+            if (!member->branch())
+                insert(member->edges, node);
+        }
+        return node;
+    }
+
+    constexpr void map(s32 base)
+    {
+        for (Node *member : members())
+            member->index += base;
+    }
+
+    constexpr Node *end()
+    {
+        Node *end = this;
+
+        for (Node *member : members())
+            end = end->index > member->index ? end : member;
+
+        return end;
+    }
+
+    constexpr Node *max_edge() const
+    {
+        Node *max = NULL;
+
+        for (Node *edge : edges)
+            max = max != NULL and max->index > edge->index ? max : edge;
+
+        return max;
+    }
+
+    constexpr bool branch() const
+    {
+        return std::any_of(edges.begin(), edges.end(), [this](const Node *edge) {
+            return edge->index > index;
+        });
+    }
+
+    constexpr void sort()
+    {
+        std::sort(edges.begin(), edges.end(), Cmp{});
+    }
 
-    Set &make_members(Set &set);
-    Set members();
+    constexpr Members &make_members(Members &set, Members &visited)
+    {
+        insert(set, this);
+        visited.push((Node *)this);
+
+        for (Node *edge : edges)
+        {
+            if (edge->index > index and std::find(visited.begin(), visited.end(), edge) == visited.end())
+                edge->make_members(set, visited);
+        }
+
+        return set;
+    }
+
+    constexpr Members members()
+    {
+        Members set{}, visited{};
+        make_members(set, visited);
+        return set;
+    }
+
+    // Like an ordered set the nodes are compared by index
+    template <typename S>
+    constexpr static Node *insert(S &set, Node *node)
+    {
+        auto it = std::find_if(set.begin(), set.end(), [node](const Node *member) {
+            return member->index == node->index;
+        });
+        return it != set.end() ? *it : set.push((Node *)node);
+    }
 };
 
 } // namespace bee::regex
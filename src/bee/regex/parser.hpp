@@ -3,10 +3,10 @@
 
 #include "core.hpp"
 #include "error.hpp"
+#include "node.hpp"
 #include "state.hpp"
+#include <algorithm>
 #include <fmt/format.h>
-#include <vector>
-#include "node.hpp"
 
 namespace bee::regex
 {
@@ -16,32 +16,284 @@ struct Parser
     std::string_view src;
     Node_Arena &arena;
     const char *token;
-    std::vector<Node *> sequences;
-
-    Parser(std::string_view src, Node_Arena &arena);
-    Node *parse();
-
-    Node *parse_new_token();
-    std::string_view parse_subsequence();
-
-    std::pair<Node *, Node *> parse_binary_op(char op);
-    Node *parse_pre_op(char op);
-    Node *parse_post_op(char op);
-
-    Node *parse_set(std::string_view set);
-    Node *parse_scope();
-    Node *parse_any();
-    Node *parse_str(char quote);
-    Node *parse_sequence();
-    Node *parse_dash();
-    Node *parse_not();
-    Node *parse_or();
-    Node *parse_quest();
-    Node *parse_star();
-    Node *parse_plus();
-    Node *parse_wave();
-	
-    Node *def(const State &&state, s32 index = 0);
+    Node::Members sequences;
+
+    constexpr Parser(std::string_view src, Node_Arena &arena) : src{src}, arena{arena}, token{src.end()} {}
+
+    constexpr Node *parse()
+    {
+        Node *head = parse_tokens();
+
+        // The indices keep moving until the whole pattern is parsed, the edges are only sorted once at the end
+        for (Node &node : arena)
+            node.sort();
+
+        return head;
+    }
+
+    constexpr Node *parse_tokens()
+    {
+        for (token = src.begin(); token < src.end(); token++)
+        {
+            Node *sequence = parse_new_token();
+            if (sequence != NULL)
+            {
+                sequences.push((Node *)sequence);
+            }
+        }
+
+        for (usize i = 1; i < sequences.size; i++)
+        {
+            (*sequences.front())->merge(*sequences.at(i));
+        }
+        return sequences.front() != NULL ? *sequences.front() : NULL;
+    }
+
+    constexpr Node *parse_new_token()
+    {
+        if (token >= src.end())
+            return NULL;
+
+        switch (*token)
+        {
+        case ' ':
+        case '\f':
+        case '\n':
+        case '\r':
+        case '\t':
+        case '\v':
+            token++;
+            return parse_new_token();
+
+        case '_':
+            return parse_set(" \v\b\f\t");
+        case 'a':
+            return parse_set("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz");
+        case 'o':
+            return parse_set("!#$%&()*+,-./:;<=>?@[\\]^`{|}~");
+        case 'n':
+            return parse_set("0123456789");
+        case 'Q':
+            return parse_set("\"");
+        case 'q':
+            return parse_set("'");
+
+        case '[':
+            return parse_scope();
+        case '^':
+            return parse_any();
+        case '!':
+            return parse_not();
+        case '/':
+            return parse_dash();
+        case '\'':
+            return parse_str('\'');
+        case '`':
+            return parse_str('`');
+        case '{':
+            return parse_sequence();
+        case '|':
+            return parse_or();
+        case '?':
+            return parse_quest();
+        case '*':
+            return parse_star();
+        case '+':
+            return parse_plus();
+        case '~':
+            return parse_wave();
+
+        case '}':
+            throw errorf("unmatched sequence brace, missing <{{> token");
+
+        case ']':
+            throw errorf("unmatched scope brace, missing <[> token");
+
+        default:
+            throw errorf("unknown token in regex, none of [_aonQq^'`{{}}!|?*+~]");
+        }
+    }
+
+    constexpr std::string_view parse_subsequence()
+    {
+        s32 depth = 1;
+        const char *begin = token + 1;
+        const char *end = token + 1;
+
+        while (depth > 0 and end < src.end())
+        {
+            switch (*end)
+            {
+            case '{':
+                depth++;
+                break;
+
+            case '}':
+                depth--;
+                break;
+            }
+            end++;
+        }
+
+        if (depth > 0)
+        {
+            throw errorf("unmatched sequence brace, missing <}}> token");
+        }
+
+        token = end - 1;
+        return std::string_view{begin, end - 1};
+    }
+
+    constexpr std::pair<Node *, Node *> parse_binary_op(char op)
+    {
+        return std::make_pair(parse_pre_op(op), parse_post_op(op));
+    }
+
+    constexpr Node *parse_pre_op(char op)
+    {
+        if (sequences.size == 0)
+            throw errorf("missing pre-operand for <{:c}> operator", op);
+
+        Node *sequence = *sequences.back();
+        sequences.pop();
+        return sequence;
+    }
+
+    constexpr Node *parse_post_op(char op)
+    {
+        token++;
+        Node *sequence = parse_new_token();
+
+        if (!sequence)
+            throw errorf("missing post-operand for <{:c}> operator", op);
+        return sequence;
+    }
+
+    constexpr Node *parse_set(std::string_view set)
+    {
+        return def(State{.option = Regex_Set, .str = set}, 0);
+    }
+
+    constexpr Node *parse_scope()
+    {
+        constexpr std::string_view scope_format = "'[' ^ '-' ^ ']'";
+
+        if (src.end() - token < 5 or token[2] != '-' or token[4] != ']')
+            throw errorf("scope does not match the format '{:s}'", scope_format);
+
+        char a = token[1];
+        char b = token[3];
+        token = &token[4];
+
+        return def(State{.option = Regex_Scope, .range = {a, b}}, 0);
+    }
+
+    constexpr Node *parse_any()
+    {
+        return def(State{Regex_Any}, 0);
+    }
+
+    constexpr Node *parse_str(char quote)
+    {
+        const char *begin = token + 1;
+        const char *end = std::find(begin, src.end(), quote);
+
+        if (end == src.end())
+            throw errorf("unmatched string quote, missing ending <{:c}> token", quote);
+
+        std::string_view str{begin, token = end};
+        return def(State{.option = Regex_Str, .str = str}, 0);
+    }
+
+    constexpr Node *parse_sequence()
+    {
+        Parser parser{parse_subsequence(), arena};
+        return parser.parse_tokens();
+    }
+
+    constexpr Node *parse_dash()
+    {
+        return def(State{.option = Regex_Dash, .sequence = parse_post_op('/')}, 0);
+    }
+
+    constexpr Node *parse_not()
+    {
+        return def(State{.option = Regex_Not, .sequence = parse_post_op('!')}, 0);
+    }
+
+    // Control flow structures:
+    // a: 1st binary operand
+    // b: 2nd binary operand
+    // o: unary operand
+    // $: epsilon
+    // ^: any
+    // x: none
+    // >: edge
+
+    constexpr Node *parse_or()
+    {
+        //   > a
+        // $
+        //   > b
+        auto [a, b] = parse_binary_op('|');
+        Node *sequence = def(State{Regex_Eps}, 0);
+        sequence->push(a);
+        sequence->push(b);
+
+        return sequence;
+    }
+
+    constexpr Node *parse_quest()
+    {
+        //   > o
+        // $
+        //   > '$
+        Node *sequence = def(State{Regex_Eps}, 0);
+        sequence->merge(parse_pre_op('?'));
+        sequence->push(def(State{Regex_Eps}));
+
+        return sequence;
+    }
+
+    constexpr Node *parse_star()
+    {
+        //   > o > $
+        // $
+        //   > $'
+        Node *sequence = def(State{Regex_Eps}, 0);
+        sequence->merge(parse_pre_op('*'));
+        sequence->concat(sequence);
+        sequence->push(def(State{Regex_Eps}));
+
+        return sequence;
+    }
+
+    constexpr Node *parse_plus()
+    {
+        // $ > e > $
+        Node *sequence = parse_pre_op('+');
+        return sequence->concat(sequence);
+    }
+
+    constexpr Node *parse_wave()
+    {
+        //   > b
+        // $
+        //   > a > $
+        //       > x
+        auto [a, b] = parse_binary_op('~');
+        auto sequence = def(State{Regex_Eps}, 0);
+        sequence->push(b);
+        sequence->push(a)->concat(sequence);
+        a->merge(def(State{Regex_None}));
+
+        return sequence;
+    }
+
+    constexpr Node *def(const State &&state, s32 index = 0)
+    {
+        return &arena.push(Node{state, index, {}});
+    }
 
     Error errorf(std::string_view fmt, auto... args) const
     {
@@ -2,6 +2,8 @@
 #define BEE_REGEX_HPP
 
 #include "core.hpp"
+#include "dfa.hpp"
+#include "graph.hpp"
 #include "match.hpp"
 #include "node.hpp"
 #include "parser.hpp"
@@ -9,14 +11,30 @@
 namespace bee::regex
 {
 
+// Matcher used by Regex::match()
+//  - Engine_Dfa: the automaton when the pattern has one, the memoized graph otherwise
+//  - Engine_Backtrack: plain backtracking on the graph, exponential on nested quantifiers
+//  - Engine_Memo: memoized backtracking on the graph, linear in the input
+
+enum Engine : u32
+{
+    Engine_Dfa,
+    Engine_Backtrack,
+    Engine_Memo,
+};
+
 struct Regex
 {
     std::string_view src;
+    Engine engine;
     Node *head;
     Node_Arena arena;
+    Graph graph;
+    Dfa dfa;
 
-    Regex(std::string_view src) :
+    Regex(std::string_view src, Engine engine = Engine_Dfa) :
         src{src},
+        engine{engine},
         arena(Node{
             State{.option = Regex_Monostate, .monostate{}},
             0,
@@ -24,13 +42,27 @@ struct Regex
         })
     {
         head = Parser{src, arena}.parse();
+        graph = Graph{head};
+        dfa = Dfa{head};
     }
 
     Regex(const char *src) : Regex(std::string_view{src}) {}
 
     Match match(std::string_view expr) const
     {
-        return head != NULL ? Match{expr, head->submit(expr, 0)} : Match{expr, npos};
+        switch (engine)
+        {
+        case Engine_Dfa:
+            if (!dfa.empty())
+                return Match{expr, dfa.submit(expr).index};
+            return Match{expr, graph.submit_memo(expr)};
+
+        case Engine_Backtrack:
+            return Match{expr, graph.submit(expr)};
+
+        default:
+            return Match{expr, graph.submit_memo(expr)};
+        }
     }
 
     Match match(auto begin, auto end) const
@@ -27,9 +27,9 @@ struct Monostate
 
 struct State
 {
-    Option option;
+    Option option = Regex_Monostate;
     union {
-        Monostate monostate;
+        Monostate monostate = {};
         char range[2];
         std::string_view str;
         Node *sequence;
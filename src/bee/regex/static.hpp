@@ -0,0 +1,131 @@
+#ifndef BEE_REGEX_STATIC_HPP
+#define BEE_REGEX_STATIC_HPP
+
+#include "core.hpp"
+#include "dfa.hpp"
+#include "match.hpp"
+#include "parser.hpp"
+#include <algorithm>
+#include <span>
+
+namespace bee::regex
+{
+
+template <usize N>
+struct Fixed_String
+{
+    char data[N];
+
+    constexpr Fixed_String(const char (&src)[N])
+    {
+        std::copy_n(src, N, data);
+    }
+
+    constexpr std::string_view view() const
+    {
+        return std::string_view{data, N - 1};
+    }
+};
+
+template <usize States, usize Width>
+struct Static_Dfa
+{
+    u8 classes[256];
+    u32 start;
+    u32 accel_end;
+    Charset runs;
+    Dfa_Edge table[States * Width];
+    Dfa_Accel accels[States];
+
+    constexpr Dfa_Table view() const
+    {
+        return Dfa_Table{classes, table, Width, start, accels, accel_end, runs};
+    }
+
+    constexpr Dfa_Match submit(std::string_view expr) const
+    {
+        return view().submit(expr);
+    }
+};
+
+// Fused automaton of the patterns, the graphs only live during the (constant) evaluation
+constexpr Dfa compile_patterns(std::span<const std::string_view> patterns)
+{
+    std::vector<Node_Arena> arenas(patterns.size());
+    std::vector<Node *> heads;
+
+    for (usize n = 0; n < patterns.size(); n++)
+        heads.push_back(Parser{patterns[n], arenas[n]}.parse());
+
+    return Dfa{heads};
+}
+
+// The tables cannot leave the constant evaluation as vectors, they are first copied in a buffer of fixed capacity
+// and then into a Static_Dfa of the exact size, compiling the patterns twice would double the build time
+template <usize Capacity>
+struct Dfa_Buffer
+{
+    u8 classes[256];
+    u32 width;
+    u32 start;
+    u32 accel_end;
+    Charset runs;
+    usize size;
+    Dfa_Edge table[Capacity];
+};
+
+template <const auto &Patterns, usize Capacity = 1 << 14>
+consteval auto static_dfa()
+{
+    constexpr Dfa_Buffer<Capacity> buffer = [] {
+        Dfa dfa = compile_patterns(Patterns);
+        Dfa_Buffer<Capacity> buffer = {};
+
+        if (!dfa.empty() and dfa.table.size() <= Capacity)
+        {
+            std::copy_n(dfa.classes, 256, buffer.classes);
+            std::copy(dfa.table.begin(), dfa.table.end(), buffer.table);
+            buffer.width = dfa.width;
+            buffer.start = dfa.start;
+            buffer.accel_end = dfa.accel_end;
+            buffer.runs = dfa.runs;
+            buffer.size = dfa.table.size();
+        }
+        return buffer;
+    }();
+    static_assert(buffer.size != 0,
+                  "cannot compile static regex: lookaheads must reduce to a character class and the table must fit");
+
+    Static_Dfa<buffer.size / buffer.width, buffer.width> result = {};
+    std::copy_n(buffer.classes, 256, result.classes);
+    std::copy_n(buffer.table, buffer.size, result.table);
+    result.start = buffer.start;
+    result.accel_end = buffer.accel_end;
+    result.runs = buffer.runs;
+
+    for (u32 state = Dfa_Dead + 1; state < buffer.accel_end; state++)
+        result.accels[state - 1] = result.view().accel(state);
+    return result;
+}
+
+// Regex compiled during the build, match() is a loop over a constant table that the compiler can inline
+template <Fixed_String Src>
+struct Static_Regex
+{
+    static constexpr std::string_view patterns[] = {Src.view()};
+    static constexpr auto dfa = static_dfa<patterns>();
+
+    static constexpr usize submit(std::string_view expr)
+    {
+        return dfa.submit(expr).index;
+    }
+
+    static Match match(std::string_view expr)
+    {
+        return Match{expr, submit(expr)};
+    }
+};
+
+} // namespace bee::regex
+
+#endif
@@ -1,6 +1,7 @@
 #include "register_system.hpp"
 #include "ast.hpp"
 #include "expr.hpp"
+#include "flat_ast.hpp"
 #include "frame.hpp"
 #include "var.hpp"
 #include <ranges>
@@ -84,13 +85,6 @@ void Register_Allocator::parse_intervals(Ast_Expr *expr)
         return;
     time++;
 
-    const auto report_var = [&](Var *var) {
-        vars.insert(var);
-        if (var->begin == (u32)-1)
-            var->begin = time;
-        var->end = time;
-    };
-
     switch (expr->kind())
     {
     case Ast_Expr_Id: {
@@ -118,10 +112,20 @@ void Register_Allocator::parse_intervals(Ast_Expr *expr)
     case Ast_Expr_Unary:
         return parse_intervals(((Unary_Expr *)expr)->expr);
 
+    // Chains of left operands are walked down without recursion, their right operands are visited back up
     case Ast_Expr_Binary: {
-        Binary_Expr *binary = (Binary_Expr *)expr;
-        parse_intervals(binary->prev);
-        parse_intervals(binary->post);
+        usize base = spine.size();
+        spine.push_back((Binary_Expr *)expr);
+        for (Ast_Expr *prev; (prev = spine.back()->prev) != NULL and prev->kind() == Ast_Expr_Binary; time++)
+            spine.push_back((Binary_Expr *)prev);
+        parse_intervals(spine.back()->prev);
+
+        while (spine.size() > base)
+        {
+            Binary_Expr *binary = spine.back();
+            spine.pop_back();
+            parse_intervals(binary->post);
+        }
         return;
     }
 
@@ -177,4 +181,81 @@ void Register_Allocator::parse_intervals(Ast_Expr *expr)
     }
 }
 
+// Visits the same nodes in the same order as the expressions the flat ast was built from. The nodes are in that order
+// already, the walk is a scan that steps over the subtrees it does not visit. A variable is reported when the scan
+// leaves the subtree of its expression, the pending ones are on a stack with the node where the scan resumes
+void Register_Allocator::parse_intervals(Flat_Node node)
+{
+    const Flat_Ast *flat = node.flat;
+    std::vector<u32> pending;
+
+    for (u32 n = node.n, end = flat->ends[node.n]; n < end;)
+    {
+        if (!pending.empty() and n == flat->ends[pending.back() + 1])
+        {
+            n = flat->ends[pending.back()];
+            report_var(Flat_Node{flat, pending.back()}.ptr<Var>(0));
+            pending.pop_back();
+            continue;
+        }
+
+        Flat_Node at{flat, n};
+        if (at.none())
+        {
+            n++;
+            continue;
+        }
+        time++;
+
+        switch (at.kind())
+        {
+        case Ast_Expr_Id: {
+            Ast_Entity *entity = at.ptr<Ast_Entity>(0);
+            if (entity != NULL and entity->kind() & Ast_Entity_Var)
+            {
+                report_var((Var *)entity);
+            }
+            n = flat->ends[n];
+            break;
+        }
+
+        case Ast_Expr_Var: {
+            if (!at.child(0).none())
+                pending.push_back(n++);
+            else
+                n = flat->ends[n];
+            break;
+        }
+
+        case Ast_Expr_Nested:
+        case Ast_Expr_Unary:
+        case Ast_Expr_Binary:
+        case Ast_Expr_Scope:
+        case Ast_Expr_Return:
+        case Ast_Expr_Invoke:
+        case Ast_Expr_Argument:
+        case Ast_Expr_If:
+        case Ast_Expr_For:
+        case Ast_Expr_For_While:
+            n++;
+            break;
+
+        default:
+            n = flat->ends[n];
+            break;
+        }
+    }
+
+    for (; !pending.empty(); pending.pop_back())
+        report_var(Flat_Node{flat, pending.back()}.ptr<Var>(0));
+}
+
+void Register_Allocator::report_var(Var *var)
+{
+    vars.insert(var);
+    if (var->begin == (u32)-1)
+        var->begin = time;
+    var->end = time;
+}
+
 } // namespace bee
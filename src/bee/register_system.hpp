@@ -22,6 +22,7 @@ struct Var_Expr;
 struct Var;
 struct Function_Expr;
 struct Type_System;
+struct Flat_Node;
 
 struct Register_Allocator
 {
@@ -40,14 +41,17 @@ struct Register_Allocator
     std::set<Register *> regs_free;
     std::set<Var *, Sort_By_Start> vars;
     std::set<Var *, Sort_By_End> active;
-    u32 time;
-    u32 sp;
+    std::vector<Binary_Expr *> spine;
+    u32 time = 0;
+    u32 sp = 0;
 
     Register_Allocator(Function_Expr *function, std::span<Register> regs, Type_System &type_system);
     void allocate();
     void expire_vars(Var *v);
     void spill_var(Var *v);
     void parse_intervals(Ast_Expr *expr);
+    void parse_intervals(Flat_Node node);
+    void report_var(Var *var);
 };
 
 } // namespace bee
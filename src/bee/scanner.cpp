@@ -3,7 +3,11 @@
 namespace bee
 {
 
-Scanner::Scanner(std::string_view src, Syntax_Map map) : source{src}, next{src}, map{map}
+Scanner::Scanner(std::string_view src, Syntax_Map map, const regex::Dfa_Table *dfa) :
+    source{src},
+    next{src},
+    map{map},
+    dfa{dfa}
 {
     if (!src.ends_with('\n'))
     {
@@ -21,16 +25,7 @@ Token Scanner::tokenize()
             return dummy_token(Token_Eof);
         }
 
-        for (const auto &[type, regex] : map)
-        {
-            if (regex::Match match = regex.match(next))
-            {
-                next = match.next();
-                token.expr = match.view();
-                token.type = type;
-                break;
-            }
-        }
+        token = dfa != NULL and !dfa->empty() ? scan_dfa() : scan_map();
     } while (token.type & (Token_Blank | Token_Comment));
 
     if (!token.type)
@@ -41,6 +36,40 @@ Token Scanner::tokenize()
     return token;
 }
 
+Token Scanner::scan_map()
+{
+    Token token = {};
+
+    for (const auto &[type, regex] : map)
+    {
+        if (regex::Match match = regex.match(next))
+        {
+            next = match.next();
+            token.expr = match.view();
+            token.type = type;
+            break;
+        }
+    }
+
+    return token;
+}
+
+// One pass over the fused automaton, the accept tag gives back the first regex of the map that matches
+Token Scanner::scan_dfa()
+{
+    Token token = {};
+    regex::Dfa_Match match = dfa->submit(next);
+
+    if (match.index != npos)
+    {
+        token.expr = next.substr(0, match.index);
+        token.type = map[match.accept].first;
+        next = next.substr(match.index);
+    }
+
+    return token;
+}
+
 Token Scanner::dummy_token(Token_Type type) const
 {
     return Token{std::string_view{&source.back(), 1}, type, true};
@@ -51,4 +80,65 @@ bool Scanner::eof() const
     return next.empty();
 }
 
+Stream_Scanner::Stream_Scanner(std::istream &stream, Syntax_Map map, const regex::Dfa_Table *dfa, usize chunk_size) :
+    stream{stream},
+    map{map},
+    dfa{dfa},
+    chunk_size{std::max<usize>(chunk_size, 1)}
+{
+}
+
+Token Stream_Scanner::tokenize()
+{
+    // Windows end with a '\n' which is a token, a window that is not empty always has one left. The Eof token of the
+    // last window is returned once the stream is exhausted
+    if ((scanner and !scanner->eof()) or refill())
+        return scanner->tokenize();
+    return scanner ? scanner->tokenize() : Token{{}, Token_Eof, true};
+}
+
+bool Stream_Scanner::refill()
+{
+    std::string next = std::move(carry);
+    usize size = next.size();
+    usize newline = next.rfind('\n');
+
+    // A line may be longer than a chunk, chunks are read until one of them holds a '\n'
+    while (newline == npos and stream)
+    {
+        next.resize(size + chunk_size);
+        stream.read(&next[size], chunk_size);
+        usize read = stream.gcount();
+
+        newline = std::string_view{&next[size], read}.rfind('\n');
+        if (newline != npos)
+            newline += size;
+        next.resize(size += read);
+    }
+
+    if (next.empty())
+    {
+        carry = std::move(next);
+        return false;
+    }
+
+    if (newline == npos)
+    {
+        // The last line of the stream does not end with a '\n'
+        next.push_back('\n');
+        newline = next.size() - 1;
+    }
+
+    carry.assign(next, newline + 1);
+    next.resize(newline + 1);
+    window = std::move(next);
+    scanner.emplace(window, map, dfa);
+    return true;
+}
+
+bool Stream_Scanner::eof() const
+{
+    return (!scanner or scanner->eof()) and carry.empty() and !stream;
+}
+
 } // namespace bee
@@ -3,6 +3,9 @@
 
 #include "bee_error.hpp"
 #include "token.hpp"
+#include <istream>
+#include <optional>
+#include <string>
 
 namespace bee
 {
@@ -12,10 +15,13 @@ struct Scanner
     std::string_view source;
     std::string_view next;
     Syntax_Map map;
+    const regex::Dfa_Table *dfa;
 
-    Scanner(std::string_view src, Syntax_Map map);
+    Scanner(std::string_view src, Syntax_Map map, const regex::Dfa_Table *dfa = NULL);
 
     Token tokenize();
+    Token scan_map();
+    Token scan_dfa();
     Token dummy_token(Token_Type type) const;
     bool eof() const;
 
@@ -25,6 +31,30 @@ struct Scanner
     }
 };
 
+constexpr usize Stream_Chunk_Size = 1 << 16;
+
+// Scanner pulling the source out of a stream in chunks, so that the whole input never has to be in memory. No token
+// spans a '\n': a window of the input ends after the last '\n' read and the rest of the chunk is carried over to the
+// next window. Tokens are views into the current window, they are valid until a token of the next window is returned
+
+struct Stream_Scanner
+{
+    std::istream &stream;
+    Syntax_Map map;
+    const regex::Dfa_Table *dfa;
+    usize chunk_size;
+    std::string window;
+    std::string carry;
+    std::optional<Scanner> scanner;
+
+    Stream_Scanner(std::istream &stream, Syntax_Map map, const regex::Dfa_Table *dfa = NULL,
+                   usize chunk_size = Stream_Chunk_Size);
+
+    Token tokenize();
+    bool refill();
+    bool eof() const;
+};
+
 } // namespace bee
 
 #endif
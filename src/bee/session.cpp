@@ -0,0 +1,178 @@
+#include "session.hpp"
+#include "parser.hpp"
+#include "token_buffer.hpp"
+#include <algorithm>
+#include <optional>
+#include <unordered_set>
+
+namespace bee
+{
+
+Ast &Session::compile(std::string_view src)
+{
+    ast.reset();
+    sources++;
+    dead = 0;
+    parsed = false;
+    diagnostics.clear();
+
+    Scanner scanner{src, bee_syntax_map(), &bee_syntax_dfa()};
+    Parser parser{&scanner, &ast};
+    if (recover)
+        parser.diagnostics = &diagnostics;
+    parser.parse();
+    parsed = diagnostics.empty();
+    return ast;
+}
+
+// The units the edit touches are parsed again from one scan of their lines, then the units after them that use a name
+// defined by a unit parsed again. The others keep their expressions and entities, their tokens move onto the new
+// source. The expressions replaced stay in the arena until the next full compile, a failed parse leaves the session
+// to a full compile, which collects the errors in recovery mode
+Ast &Session::compile(std::string_view src, Source_Edit edit)
+{
+    if (!parsed or dead > std::max(Session_Dead_Limit, ast.exprs.size() - dead))
+        return compile(src);
+
+    // A unit ends past its line break, or at the end of the source which an edit at its end extends
+    std::vector<Ast_Unit> units = std::move(ast.units);
+    usize first = 0;
+    while (first < units.size() and units[first].end <= edit.begin and src[units[first].end - 1] == '\n')
+        first++;
+    usize last = first;
+    while (last < units.size() and units[last].begin <= edit.old_end)
+        last++;
+
+    s64 delta = (s64)edit.new_end - edit.old_end;
+    usize begin = first > 0 ? units[first - 1].end : 0;
+    usize end = last < units.size() ? units[last].begin + delta : src.size();
+
+    // The lines scanned again end where the next unit kept starts, unless a token of the edit runs into it. An edit
+    // that only adds or removes bytes between units, or none at the end of the source, leaves no lines to scan
+    std::optional<Token_Buffer> tokens;
+    if (end > begin)
+    {
+        Scanner scanner{src.substr(begin, end - begin), bee_syntax_map(), &bee_syntax_dfa()};
+        tokens.emplace(scanner);
+        usize n = tokens->size() - 2;
+        if (last < units.size() and (tokens->size() < 2 or tokens->type(n) != Token_NewLine or
+                                     tokens->offsets[n] + tokens->sizes[n] != end - begin))
+            return compile(src);
+    }
+
+    sources++;
+    reparsed++;
+    parsed = false;
+    s64 shift = src.data() - ast.source.data();
+    ast.source = src;
+    if (tokens)
+        tokens->intern(ast.interner);
+
+    // The main frame owns the entities of the units kept, the ones replaced are deleted once the parse succeeds
+    Frame *main_frame = ast.main_frame;
+    main_frame->defs.clear();
+    ast.main_scope->compound->clear();
+    ast.push_frame(main_frame);
+
+    std::vector<bool> kept(units.size());
+    std::unordered_set<u32> changed;
+    std::unordered_set<Ast_Expr *> moved;
+    auto replace = [&](const Ast_Unit &unit) {
+        for (Ast_Entity *entity : unit.defs)
+            changed.insert(entity->symbol);
+    };
+    // In recovery mode the errors of the parse are collected aside, the first one leaves the edit to a full compile
+    std::vector<Error> errors;
+    auto parse = [&](Token_Buffer &tokens) {
+        usize n = ast.units.size();
+        Parser parser{&tokens, &ast};
+        if (recover)
+            parser.diagnostics = &errors;
+        parser.parse_units(ast.main_scope->compound);
+        if (!errors.empty())
+            throw errors.front();
+        for (; n < ast.units.size(); n++)
+        {
+            for (Ast_Entity *entity : ast.units[n].defs)
+                changed.insert(entity->symbol);
+            for (Ast_Expr *expr : ast.units[n].exprs)
+                ast.type_system.type_exprs(expr);
+        }
+    };
+    auto keep = [&](usize n, s64 shift) {
+        if (shift != 0)
+        {
+            for (Ast_Expr *expr : units[n].exprs)
+                ast.move_tokens(expr, shift, moved);
+        }
+        kept[n] = true;
+        ast.push_unit(std::move(units[n]));
+    };
+
+    try
+    {
+        for (usize n = 0; n < first; n++)
+            keep(n, shift);
+        for (usize n = first; n < last; n++)
+            replace(units[n]);
+        if (tokens)
+            parse(*tokens);
+
+        for (usize n = last; n < units.size(); n++)
+        {
+            Ast_Unit &unit = units[n];
+            unit.begin += delta, unit.end += delta;
+            auto uses_changed = [&changed](u32 symbol) {
+                return changed.contains(symbol);
+            };
+            if (std::none_of(unit.symbols.begin(), unit.symbols.end(), uses_changed))
+            {
+                keep(n, shift + delta);
+                continue;
+            }
+
+            replace(unit);
+            Scanner unit_scanner{src.substr(unit.begin, unit.end - unit.begin), bee_syntax_map(), &bee_syntax_dfa()};
+            Token_Buffer unit_tokens{unit_scanner};
+            unit_tokens.intern(ast.interner);
+            parse(unit_tokens);
+        }
+    }
+    catch (...)
+    {
+        for (usize n = 0; n < units.size(); n++)
+        {
+            if (!kept[n])
+                main_frame->defs.insert(main_frame->defs.end(), units[n].defs.begin(), units[n].defs.end());
+        }
+        ast.pop_frame();
+        if (recover)
+            return compile(src);
+        throw;
+    }
+
+    for (usize n = 0; n < units.size(); n++)
+    {
+        if (kept[n])
+            continue;
+        for (Ast_Entity *entity : units[n].defs)
+            delete entity;
+        dead += units[n].bytes;
+    }
+    ast.pop_frame();
+    // The globals of the units parsed again can move the ones of the units kept
+    ast.type_system.slot_vars(ast.main_scope);
+    parsed = true;
+    return ast;
+}
+
+Ast &Session::compile_file(std::string_view path)
+{
+    // The nodes of the previous source are destroyed before its mapping
+    ast.reset();
+    source.reset();
+    source.emplace(path);
+    return compile(source->src);
+}
+
+} // namespace bee
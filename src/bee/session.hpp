@@ -0,0 +1,51 @@
+#ifndef BEE_SESSION_HPP
+#define BEE_SESSION_HPP
+
+#include "ast.hpp"
+#include "core.hpp"
+#include "source.hpp"
+#include <optional>
+#include <vector>
+
+namespace bee
+{
+
+const usize Session_Dead_Limit = 64 * 1024;
+
+// Front-end state kept between the sources compiled by one process: the expression arena, the frames and the
+// built-in types of the ast are reused by each compile(), which only resets what the previous source left. The ast
+// returned points into the source and is valid until the next compile().
+// A source edited from the one compiled last is compiled again with the edit, only the units of the ast it changes
+// are parsed again. The expressions of the units replaced stay in the arena, once they take more than the ones in use
+// and than 'Session_Dead_Limit' bytes the next edit is compiled from scratch.
+// In recovery mode the errors of a source are collected in 'diagnostics' instead of thrown, an ast with errors is
+// only good for reporting them
+
+// The bytes [begin, old_end) of the previous source are replaced by the bytes [begin, new_end) of the new one
+
+struct Source_Edit
+{
+    u32 begin;
+    u32 old_end;
+    u32 new_end;
+};
+
+struct Session
+{
+    Ast ast = {};
+    std::optional<Source> source;
+    usize sources = 0;
+    usize reparsed = 0;
+    usize dead = 0;
+    bool parsed = false;
+    bool recover = false;
+    std::vector<Error> diagnostics;
+
+    Ast &compile(std::string_view src);
+    Ast &compile(std::string_view src, Source_Edit edit);
+    Ast &compile_file(std::string_view path);
+};
+
+} // namespace bee
+
+#endif
@@ -0,0 +1,156 @@
+#include "simd.hpp"
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BEE_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace bee
+{
+
+template <bool Skip>
+static usize search_scalar(std::string_view expr, usize n, const u8 *needles, u32 count)
+{
+    for (; n < expr.size(); n++)
+    {
+        bool found = false;
+        for (u32 i = 0; i < count; i++)
+            found |= (u8)expr[n] == needles[i];
+
+        if (found != Skip)
+            return n;
+    }
+
+    return expr.size();
+}
+
+#ifdef BEE_SIMD_X86
+
+// SSE2 is part of x86-64, only AVX2 has to be checked at runtime
+
+template <bool Skip>
+static usize search_sse2(std::string_view expr, const u8 *needles, u32 count)
+{
+    __m128i splats[Simd_Needle_Max];
+    for (u32 i = 0; i < count; i++)
+        splats[i] = _mm_set1_epi8((char)needles[i]);
+
+    usize n = 0;
+    for (; n + 16 <= expr.size(); n += 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)&expr[n]);
+        __m128i found = _mm_setzero_si128();
+
+        for (u32 i = 0; i < count; i++)
+            found = _mm_or_si128(found, _mm_cmpeq_epi8(chunk, splats[i]));
+
+        u32 mask = _mm_movemask_epi8(found);
+        if (Skip)
+            mask = ~mask & 0xffff;
+        if (mask != 0)
+            return n + std::countr_zero(mask);
+    }
+
+    return search_scalar<Skip>(expr, n, needles, count);
+}
+
+template <bool Skip>
+__attribute__((target("avx2"))) static usize search_avx2(std::string_view expr, const u8 *needles, u32 count)
+{
+    __m256i splats[Simd_Needle_Max];
+    for (u32 i = 0; i < count; i++)
+        splats[i] = _mm256_set1_epi8((char)needles[i]);
+
+    usize n = 0;
+    for (; n + 32 <= expr.size(); n += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)&expr[n]);
+        __m256i found = _mm256_setzero_si256();
+
+        for (u32 i = 0; i < count; i++)
+            found = _mm256_or_si256(found, _mm256_cmpeq_epi8(chunk, splats[i]));
+
+        u32 mask = _mm256_movemask_epi8(found);
+        if (Skip)
+            mask = ~mask;
+        if (mask != 0)
+            return n + std::countr_zero(mask);
+    }
+
+    return search_scalar<Skip>(expr, n, needles, count);
+}
+
+#endif
+
+template <bool Skip>
+static usize search(Simd_Level level, std::string_view expr, const u8 *needles, u32 count)
+{
+    count = std::min(count, Simd_Needle_Max);
+
+    switch (std::min(level, simd_level()))
+    {
+#ifdef BEE_SIMD_X86
+    case Simd_Avx2:
+        return search_avx2<Skip>(expr, needles, count);
+    case Simd_Sse2:
+        return search_sse2<Skip>(expr, needles, count);
+#endif
+    default:
+        return search_scalar<Skip>(expr, 0, needles, count);
+    }
+}
+
+usize simd_find(std::string_view expr, const u8 *needles, u32 count)
+{
+    return search<false>(simd_level(), expr, needles, count);
+}
+
+usize simd_skip(std::string_view expr, const u8 *needles, u32 count)
+{
+    return search<true>(simd_level(), expr, needles, count);
+}
+
+usize simd_find(Simd_Level level, std::string_view expr, const u8 *needles, u32 count)
+{
+    return search<false>(level, expr, needles, count);
+}
+
+usize simd_skip(Simd_Level level, std::string_view expr, const u8 *needles, u32 count)
+{
+    return search<true>(level, expr, needles, count);
+}
+
+static Simd_Level simd_detect()
+{
+#ifdef BEE_SIMD_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? Simd_Avx2 : Simd_Sse2;
+#else
+    return Simd_Scalar;
+#endif
+}
+
+Simd_Level simd_level()
+{
+    static const Simd_Level level = simd_detect();
+    return level;
+}
+
+std::string_view simd_level_name(Simd_Level level)
+{
+    switch (level)
+    {
+    case Simd_Scalar:
+        return "scalar";
+    case Simd_Sse2:
+        return "sse2";
+    case Simd_Avx2:
+        return "avx2";
+    default:
+        return "?";
+    }
+}
+
+} // namespace bee
@@ -0,0 +1,34 @@
+#ifndef BEE_SIMD_HPP
+#define BEE_SIMD_HPP
+
+#include "core.hpp"
+
+namespace bee
+{
+
+constexpr u32 Simd_Needle_Max = 8;
+
+enum Simd_Level : u32
+{
+    Simd_Scalar,
+    Simd_Sse2,
+    Simd_Avx2,
+};
+
+// Byte search over runs of the source, the widest level supported by the cpu is picked on the first call
+//  - simd_find() returns the index of the first byte that is one of the needles
+//  - simd_skip() returns the index of the first byte that is not one of the needles
+// Both return expr.size() when there is no such byte
+
+usize simd_find(std::string_view expr, const u8 *needles, u32 count);
+usize simd_skip(std::string_view expr, const u8 *needles, u32 count);
+
+usize simd_find(Simd_Level level, std::string_view expr, const u8 *needles, u32 count);
+usize simd_skip(Simd_Level level, std::string_view expr, const u8 *needles, u32 count);
+
+Simd_Level simd_level();
+std::string_view simd_level_name(Simd_Level level);
+
+} // namespace bee
+
+#endif
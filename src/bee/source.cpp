@@ -0,0 +1,124 @@
+#include "source.hpp"
+#include <fmt/format.h>
+#include <fstream>
+
+#if __has_include(<sys/mman.h>)
+#define BEE_SOURCE_MMAP 1
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace bee
+{
+
+Source::Source(std::string_view path) : path{path}, map{NULL}, map_size{0}
+{
+#ifdef BEE_SOURCE_MMAP
+    s32 fd = open(this->path.c_str(), O_RDONLY);
+    struct stat stat = {};
+
+    if (fd < 0 or fstat(fd, &stat) != 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        throw errorf("cannot open source");
+    }
+
+    // Pipes and devices have no size to map, they are read until their end into the buffer
+    if (!S_ISREG(stat.st_mode))
+    {
+        char chunk[64 * 1024];
+        ssize_t n;
+        while ((n = read(fd, chunk, sizeof(chunk))) != 0)
+        {
+            if (n < 0 and errno != EINTR)
+            {
+                close(fd);
+                throw errorf("cannot read source");
+            }
+            if (n > 0)
+                buffer.append(chunk, n);
+        }
+        close(fd);
+
+        if (!buffer.ends_with('\n'))
+            buffer.push_back('\n');
+        src = buffer;
+        return;
+    }
+
+    // One more byte than the file for the '\n', the pages after the file come from an anonymous mapping so that the
+    // byte can be written even when the file ends on a page boundary
+    usize size = stat.st_size;
+    usize page = sysconf(_SC_PAGESIZE);
+    map_size = (size + 1 + page - 1) / page * page;
+    map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (map == MAP_FAILED or (size != 0 and mmap(map, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd,
+                                                    0) == MAP_FAILED))
+    {
+        if (map != MAP_FAILED)
+            munmap(map, map_size);
+        close(fd);
+        map = NULL;
+        throw errorf("cannot map source");
+    }
+    close(fd);
+
+    // Writing the '\n' only copies the last page, the mapping is private
+    char *data = (char *)map;
+    if (size == 0 or data[size - 1] != '\n')
+        data[size++] = '\n';
+
+    madvise(map, size, MADV_SEQUENTIAL);
+    src = std::string_view{data, size};
+#else
+    std::ifstream fstream{this->path, std::ios::binary};
+    if (!fstream.is_open())
+        throw errorf("cannot open source");
+
+    buffer.assign(std::istreambuf_iterator{fstream}, {});
+    if (!buffer.ends_with('\n'))
+        buffer.push_back('\n');
+    src = buffer;
+#endif
+}
+
+Source::Source(Source &&source) :
+    path{std::move(source.path)},
+    src{source.src},
+    map{source.map},
+    map_size{source.map_size},
+    buffer{std::move(source.buffer)}
+{
+    // The buffer of a moved string may be a small string stored inline
+    if (!map)
+        src = buffer;
+
+    source.src = {};
+    source.map = NULL;
+    source.map_size = 0;
+}
+
+Source::~Source()
+{
+#ifdef BEE_SOURCE_MMAP
+    if (map != NULL)
+        munmap(map, map_size);
+#endif
+}
+
+bool Source::mapped() const
+{
+    return map != NULL;
+}
+
+Error Source::errorf(std::string_view desc) const
+{
+    return Error{"source error", fmt::format("{:s} from: '{:s}'", desc, path)};
+}
+
+} // namespace bee
@@ -0,0 +1,37 @@
+#ifndef BEE_SOURCE_HPP
+#define BEE_SOURCE_HPP
+
+#include "core.hpp"
+#include "error.hpp"
+#include <string>
+
+namespace bee
+{
+
+// Source file mapped read-only in memory, the scanner requires the source to end with a '\n' which is appended in the
+// mapping when the file does not. Views into the source (and the tokens scanned from it) are valid as long as the
+// source is alive
+
+struct Source
+{
+    std::string path;
+    std::string_view src;
+    void *map;
+    usize map_size;
+    std::string buffer;
+
+    Source(std::string_view path);
+    Source(Source &&source);
+    Source(const Source &) = delete;
+    ~Source();
+
+    Source &operator=(Source &&) = delete;
+    Source &operator=(const Source &) = delete;
+
+    bool mapped() const;
+    Error errorf(std::string_view desc) const;
+};
+
+} // namespace bee
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef BEE_SYMBOL_TABLE_HPP
+#define BEE_SYMBOL_TABLE_HPP
+
+#include "core.hpp"
+#include <algorithm>
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace bee
+{
+
+constexpr u32 Symbol_None = ~(u32)0;
+
+// Scoped symbol table: each key has one slot of a flat open-addressing table that holds its innermost binding, the
+// bindings are stacked by scope and each one keeps the binding it shadows. A lookup is a single probe, popping a
+// scope puts back the bindings its keys shadowed. Slots are never removed, a key left without binding stays in the
+// table until clear()
+
+template <typename K, typename V>
+struct Symbol_Table
+{
+    struct Slot
+    {
+        K key;
+        u32 binding;
+        bool used;
+    };
+
+    struct Binding
+    {
+        K key;
+        V value;
+        u32 shadow;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<Binding> bindings;
+    std::vector<u32> scopes;
+    usize count = 0;
+
+    V find(const K &key) const
+    {
+        u32 binding = find_binding(key);
+        return binding != Symbol_None ? bindings[binding].value : V{};
+    }
+
+    // Only looks into the innermost scope
+    V find_scope(const K &key) const
+    {
+        u32 binding = find_binding(key);
+        return binding != Symbol_None and binding >= scope_begin() ? bindings[binding].value : V{};
+    }
+
+    u32 find_binding(const K &key) const
+    {
+        if (slots.empty())
+            return Symbol_None;
+
+        const Slot &slot = slots[probe(key)];
+        return slot.used ? slot.binding : Symbol_None;
+    }
+
+    V insert(const K &key, V value)
+    {
+        if ((count + 1) * 2 > slots.size())
+            rehash(std::max<usize>(64, slots.size() * 2));
+
+        Slot &slot = slots[probe(key)];
+        if (!slot.used)
+        {
+            slot = Slot{key, Symbol_None, true};
+            count++;
+        }
+
+        bindings.push_back(Binding{key, value, slot.binding});
+        slot.binding = bindings.size() - 1;
+        return value;
+    }
+
+    void push_scope()
+    {
+        scopes.push_back(bindings.size());
+    }
+
+    void pop_scope()
+    {
+        u32 begin = scope_begin();
+        if (!scopes.empty())
+            scopes.pop_back();
+
+        for (; bindings.size() > begin; bindings.pop_back())
+            slots[probe(bindings.back().key)].binding = bindings.back().shadow;
+    }
+
+    u32 scope_begin() const
+    {
+        return scopes.empty() ? 0 : scopes.back();
+    }
+
+    std::span<const Binding> scope() const
+    {
+        return std::span<const Binding>{bindings}.subspan(scope_begin());
+    }
+
+    // Empties the table, the memory is kept
+    void clear()
+    {
+        std::fill(slots.begin(), slots.end(), Slot{});
+        bindings.clear();
+        scopes.clear();
+        count = 0;
+    }
+
+    usize probe(const K &key) const
+    {
+        usize mask = slots.size() - 1;
+        for (usize n = hash(key) & mask;; n = (n + 1) & mask)
+        {
+            if (!slots[n].used or slots[n].key == key)
+                return n;
+        }
+    }
+
+    void rehash(usize size)
+    {
+        std::vector<Slot> old = std::move(slots);
+        slots.assign(size, Slot{});
+
+        for (const Slot &slot : old)
+        {
+            if (slot.used)
+                slots[probe(slot.key)] = slot;
+        }
+    }
+
+    static usize hash(const K &key)
+    {
+        u64 hash = std::hash<K>{}(key) * 0x9e3779b97f4a7c15;
+        return hash ^ hash >> 32;
+    }
+};
+
+} // namespace bee
+
+#endif
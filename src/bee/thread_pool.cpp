@@ -0,0 +1,73 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+namespace bee
+{
+
+Thread_Pool::Thread_Pool(usize size) : pending{0}, stop{false}
+{
+    for (usize n = 0; n < std::max<usize>(size, 1); n++)
+        threads.emplace_back(&Thread_Pool::run, this);
+}
+
+Thread_Pool::~Thread_Pool()
+{
+    {
+        std::lock_guard lock{mutex};
+        stop = true;
+    }
+    task_cv.notify_all();
+
+    for (std::thread &thread : threads)
+        thread.join();
+}
+
+void Thread_Pool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard lock{mutex};
+        tasks.push_back(std::move(task));
+        pending++;
+    }
+    task_cv.notify_one();
+}
+
+void Thread_Pool::wait()
+{
+    std::unique_lock lock{mutex};
+    done_cv.wait(lock, [this] {
+        return pending == 0;
+    });
+}
+
+usize Thread_Pool::size() const
+{
+    return threads.size();
+}
+
+void Thread_Pool::run()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock{mutex};
+            task_cv.wait(lock, [this] {
+                return stop or !tasks.empty();
+            });
+
+            if (tasks.empty())
+                return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+
+        std::lock_guard lock{mutex};
+        if (--pending == 0)
+            done_cv.notify_all();
+    }
+}
+
+} // namespace bee
@@ -0,0 +1,40 @@
+#ifndef BEE_THREAD_POOL_HPP
+#define BEE_THREAD_POOL_HPP
+
+#include "core.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bee
+{
+
+// Fixed set of worker threads taking the tasks in the order they were submitted, wait() blocks until every submitted
+// task is done. Tasks must not throw, errors are handed back through their own results
+
+struct Thread_Pool
+{
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable task_cv;
+    std::condition_variable done_cv;
+    usize pending;
+    bool stop;
+
+    Thread_Pool(usize size = std::thread::hardware_concurrency());
+    Thread_Pool(const Thread_Pool &) = delete;
+    ~Thread_Pool();
+
+    void submit(std::function<void()> task);
+    void wait();
+    usize size() const;
+    void run();
+};
+
+} // namespace bee
+
+#endif
@@ -0,0 +1,15 @@
+#include "token.hpp"
+#include "regex/static.hpp"
+
+namespace bee
+{
+
+// The fused table is evaluated in this translation unit only, it is the slowest constant of the build
+const regex::Dfa_Table &bee_syntax_dfa()
+{
+    static constexpr auto dfa = regex::static_dfa<bee_syntax_patterns>();
+    static constexpr regex::Dfa_Table table = dfa.view();
+    return table;
+}
+
+} // namespace bee
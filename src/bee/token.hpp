@@ -4,7 +4,10 @@
 #include "bitset.hpp"
 #include "core.hpp"
 #include "regex/regex.hpp"
+#include "symbol_table.hpp"
+#include <array>
 #include <span>
+#include <utility>
 
 namespace bee
 {
@@ -17,6 +20,7 @@ struct Token
     std::string_view expr;
     Token_Type type;
     bool ok;
+    u32 symbol = Symbol_None;
 };
 
 enum Token_Type : u64
@@ -112,88 +116,121 @@ static Token operator|(Token a, Token b)
     return token;
 }
 
-static Syntax_Map bee_syntax_map()
+struct Syntax_Rule
 {
-    static const std::pair<Token_Type, Regex> map[] = {
-        {Token_Blank, "_+"},
-        {Token_Comment, "'//' {{{'\\'^}|^} ~ /'\n'}? /'\n'"},
-        {Token_NewLine, "'\n'"},
-
-        // Every token has the same regex pattern "'<name>' /!a"
-        {Token_Enum, "'enum' /!a"},
-        {Token_Union, "'union' /!a"},
-        {Token_Struct, "'struct' /!a"},
-        {Token_Break, "'break' /!a"},
-        {Token_Case, "'case' /!a"},
-        {Token_Continue, "'continue' /!a"},
-        {Token_Else, "'else' /!a"},
-        {Token_For, "'for' /!a"},
-        {Token_If, "'if' /!a"},
-        {Token_Return, "'return' /!a"},
-        {Token_Switch, "'switch' /!a"},
-        {Token_In, "'in' /!a"},
-        {Token_And, "'and' /!a"},
-        {Token_Or, "'or' /!a"},
-
-        {Token_Scope_Begin, "'{'"},
-        {Token_Scope_End, "'}'"},
-        {Token_Nested_Begin, "'('"},
-        {Token_Nested_End, "')'"},
-        {Token_Crochet_Begin, "']'"},
-        {Token_Crochet_End, "'['"},
-
-        {Token_Arrow, "'->'"},
-        {Token_Increment, "'++'"},
-        {Token_Decrement, "'--'"},
-        {Token_Add, "'+'"},
-        {Token_Sub, "'-'"},
-
-        {Token_Float, "{[0-9]+ '.' [0-9]*} |"
-                      "{[0-9]* '.' [0-9]+}  "
-                      "{'e'|'E' {'+'|'-'}? [0-9]+}?"},
-
-        {Token_Int_Bin, "'0b'{[0-1]      }+"},
-        {Token_Int_Hex, "'0x'{[0-9]|[a-f]}+"},
-        {Token_Int_Dec, "    {[0-9]      }+"},
-
-        {Token_Str, "Q {{{'\\'^}|^} ~ /{Q|'\n'}} ? {Q|'\n'}"},
-        {Token_Char, "q {{{'\\'^}|^} ~ /{q|'\n'}} {q|'\n'}"},
-        {Token_Id, "{a|'_'} {a|'_'|n}*"},
-
-        {Token_Declare, "'::'"},
-        {Token_Define, "':'"},
-
-        {Token_Mul, "'*'"},
-        {Token_Div, "'/'"},
-        {Token_Mod, "'%'"},
-        {Token_Semicolon, "';'"},
-        {Token_Comma, "','"},
-        {Token_Dot, "'.'"},
-        {Token_And, "'&&'"},
-        {Token_Or, "'||'"},
-        {Token_Bin_Not, "'~'"},
-        {Token_Bin_Or, "'|'"},
-        {Token_Bin_Xor, "'^'"},
-        {Token_Shift_L, "'<<'"},
-        {Token_Shift_R, "'>>'"},
-        {Token_Div, "'/'"},
-        {Token_Mod, "'%'"},
-        {Token_Eq, "'=='"},
-        {Token_Not_Eq, "'!='"},
-        {Token_Less_Eq, "'<='"},
-        {Token_Greater_Eq, "'>='"},
-        {Token_Less, "'<'"},
-        {Token_Greater, "'>'"},
-        {Token_Not, "'!'"},
-        {Token_Assign, "'='"},
-        {Token_Ref, "'&'"},
-
-        {Token_None, "^~/{_?}"},
-    };
+    Token_Type type;
+    std::string_view pattern;
+};
+
+constexpr Syntax_Rule bee_syntax[] = {
+    {Token_Blank, "_+"},
+    {Token_Comment, "'//' {{{'\\'^}|^} ~ /'\n'}? /'\n'"},
+    {Token_NewLine, "'\n'"},
+
+    // Every token has the same regex pattern "'<name>' /!a"
+    {Token_Enum, "'enum' /!a"},
+    {Token_Union, "'union' /!a"},
+    {Token_Struct, "'struct' /!a"},
+    {Token_Break, "'break' /!a"},
+    {Token_Case, "'case' /!a"},
+    {Token_Continue, "'continue' /!a"},
+    {Token_Else, "'else' /!a"},
+    {Token_For, "'for' /!a"},
+    {Token_If, "'if' /!a"},
+    {Token_Return, "'return' /!a"},
+    {Token_Switch, "'switch' /!a"},
+    {Token_In, "'in' /!a"},
+    {Token_And, "'and' /!a"},
+    {Token_Or, "'or' /!a"},
+
+    {Token_Scope_Begin, "'{'"},
+    {Token_Scope_End, "'}'"},
+    {Token_Nested_Begin, "'('"},
+    {Token_Nested_End, "')'"},
+    {Token_Crochet_Begin, "']'"},
+    {Token_Crochet_End, "'['"},
+
+    {Token_Arrow, "'->'"},
+    {Token_Increment, "'++'"},
+    {Token_Decrement, "'--'"},
+    {Token_Add, "'+'"},
+    {Token_Sub, "'-'"},
+
+    {Token_Float, "{[0-9]+ '.' [0-9]*} |"
+                  "{[0-9]* '.' [0-9]+}  "
+                  "{'e'|'E' {'+'|'-'}? [0-9]+}?"},
+
+    {Token_Int_Bin, "'0b'{[0-1]      }+"},
+    {Token_Int_Hex, "'0x'{[0-9]|[a-f]}+"},
+    {Token_Int_Dec, "    {[0-9]      }+"},
+
+    {Token_Str, "Q {{{'\\'^}|^} ~ /{Q|'\n'}} ? {Q|'\n'}"},
+    {Token_Char, "q {{{'\\'^}|^} ~ /{q|'\n'}} {q|'\n'}"},
+    {Token_Id, "{a|'_'} {a|'_'|n}*"},
+
+    {Token_Declare, "'::'"},
+    {Token_Define, "':'"},
+
+    {Token_Mul, "'*'"},
+    {Token_Div, "'/'"},
+    {Token_Mod, "'%'"},
+    {Token_Semicolon, "';'"},
+    {Token_Comma, "','"},
+    {Token_Dot, "'.'"},
+    {Token_And, "'&&'"},
+    {Token_Or, "'||'"},
+    {Token_Bin_Not, "'~'"},
+    {Token_Bin_Or, "'|'"},
+    {Token_Bin_Xor, "'^'"},
+    {Token_Shift_L, "'<<'"},
+    {Token_Shift_R, "'>>'"},
+    {Token_Div, "'/'"},
+    {Token_Mod, "'%'"},
+    {Token_Eq, "'=='"},
+    {Token_Not_Eq, "'!='"},
+    {Token_Less_Eq, "'<='"},
+    {Token_Greater_Eq, "'>='"},
+    {Token_Less, "'<'"},
+    {Token_Greater, "'>'"},
+    {Token_Not, "'!'"},
+    {Token_Assign, "'='"},
+    {Token_Ref, "'&'"},
 
+    {Token_None, "^~/{_?}"},
+};
+
+inline constexpr auto bee_syntax_patterns = [] {
+    std::array<std::string_view, std::size(bee_syntax)> patterns = {};
+    for (usize n = 0; n < patterns.size(); n++)
+        patterns[n] = bee_syntax[n].pattern;
+    return patterns;
+}();
+
+template <usize... N>
+static Syntax_Map syntax_map(std::index_sequence<N...>)
+{
+    // Regexes point into their own arena, they are constructed in place from the rules
+    static const std::pair<Token_Type, Regex> map[] = {{bee_syntax[N].type, bee_syntax[N].pattern}...};
     return map;
 }
 
+static Syntax_Map bee_syntax_map()
+{
+    return syntax_map(std::make_index_sequence<std::size(bee_syntax)>{});
+}
+
+// Fused automaton of every regex in the map, accept tags are indices into the map
+inline regex::Dfa syntax_dfa(Syntax_Map map)
+{
+    std::vector<regex::Node *> heads;
+    for (const auto &[type, regex] : map)
+        heads.push_back(regex.head);
+    return regex::Dfa{heads};
+}
+
+// Same automaton as syntax_dfa(bee_syntax_map()) but compiled during the build (see token.cpp)
+const regex::Dfa_Table &bee_syntax_dfa();
+
 constexpr std::string_view token_typename(Token_Type type)
 {
     switch (type)
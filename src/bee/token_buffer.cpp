@@ -0,0 +1,184 @@
+#include "token_buffer.hpp"
+#include <exception>
+#include <limits>
+
+namespace bee
+{
+
+Token_Buffer::Token_Buffer(Scanner &scanner) : source{scanner.source}
+{
+    if (source.size() > std::numeric_limits<u32>::max())
+        throw scanner.errorf(scanner.dummy_token(Token_Eof), "source is too large for a token buffer");
+
+    // About one token every 2.7 characters on the examples, growing the arrays past the estimate copies them all
+    usize reserve = scanner.next.size() / 2 + 1;
+    types.reserve(reserve);
+    offsets.reserve(reserve);
+    sizes.reserve(reserve);
+
+    Token token;
+    do
+    {
+        push(token = scanner.tokenize());
+    } while (token.type != Token_Eof);
+}
+
+Token_Buffer::Token_Buffer(Scanner &scanner, Thread_Pool &pool, usize chunk_size) : source{scanner.source}
+{
+    std::string_view next = scanner.next;
+    std::optional<regex::Charset> guards;
+
+    if (next.size() > chunk_size and scanner.dfa != NULL and !scanner.dfa->empty())
+        guards = newline_guards(*scanner.dfa);
+    if (!guards)
+    {
+        *this = Token_Buffer{scanner};
+        return;
+    }
+    if (source.size() > std::numeric_limits<u32>::max())
+        throw scanner.errorf(scanner.dummy_token(Token_Eof), "source is too large for a token buffer");
+
+    std::vector<std::string_view> views;
+    while (!next.empty())
+    {
+        usize end = std::min(chunk_size, next.size()) - 1;
+        while ((end = next.find('\n', end)) != npos and end != 0 and (*guards)[(u8)next[end - 1]])
+            end++;
+
+        end = end != npos ? end : next.size() - 1;
+        views.push_back(next.substr(0, end + 1));
+        next.remove_prefix(end + 1);
+    }
+
+    // The chunk scanners keep the whole source so that the errors report the lines of the source
+    std::vector<std::optional<Token_Buffer>> chunks(views.size());
+    std::vector<std::exception_ptr> errors(views.size());
+
+    for (usize n = 0; n < views.size(); n++)
+    {
+        pool.submit([&, n] {
+            try
+            {
+                Scanner chunk = scanner;
+                chunk.next = views[n];
+                chunks[n].emplace(chunk);
+            }
+            catch (...)
+            {
+                errors[n] = std::current_exception();
+            }
+        });
+    }
+    pool.wait();
+
+    // The first error of the source is the one a serial scan would throw
+    for (std::exception_ptr &error : errors)
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    usize size = 1;
+    for (std::optional<Token_Buffer> &chunk : chunks)
+        size += chunk->size() - 1;
+
+    types.reserve(size);
+    offsets.reserve(size);
+    sizes.reserve(size);
+
+    for (std::optional<Token_Buffer> &chunk : chunks)
+        append(*chunk);
+
+    scanner.next = next;
+    push(scanner.dummy_token(Token_Eof));
+}
+
+void Token_Buffer::push(Token token)
+{
+    types.push_back(std::countr_zero((u64)token.type));
+    offsets.push_back(token.expr.data() - source.data());
+    sizes.push_back(token.expr.size());
+}
+
+// Appends the tokens of a chunk of the same source without its Eof token
+void Token_Buffer::append(const Token_Buffer &chunk)
+{
+    types.insert(types.end(), chunk.types.begin(), chunk.types.end() - 1);
+    offsets.insert(offsets.end(), chunk.offsets.begin(), chunk.offsets.end() - 1);
+    sizes.insert(sizes.end(), chunk.sizes.begin(), chunk.sizes.end() - 1);
+}
+
+void Token_Buffer::intern(Interner &names)
+{
+    u8 id = std::countr_zero((u64)Token_Id);
+
+    symbols.assign(size(), Symbol_None);
+    for (usize n = 0; n < size(); n++)
+    {
+        if (types[n] == id)
+            symbols[n] = names.intern(source.substr(offsets[n], sizes[n]));
+    }
+    interner = &names;
+}
+
+// A '\n' ends the token when the state reading it goes to a state that is dead on every symbol and accepts the same way
+// on all of them as at the end of the input, the scan then goes on from the start state as for a new source. The
+// guards are the characters leading to a state where this does not hold, a '\n' following any other character is
+// the end of a token. The start state must not be such a state, a token could then begin with a '\n' and go on
+std::optional<regex::Charset> Token_Buffer::newline_guards(const regex::Dfa_Table &dfa)
+{
+    std::vector<u32> states = {dfa.start};
+    std::vector<bool> visited(dfa.start + 1), open;
+    visited[dfa.start] = true;
+
+    for (usize n = 0; n < states.size(); n++)
+    {
+        const regex::Dfa_Edge *row = &dfa.table[states[n] * dfa.width];
+
+        for (u32 symbol = 0; symbol < dfa.width; symbol++)
+        {
+            u32 state = row[symbol].state;
+            if (state >= visited.size())
+                visited.resize(state + 1);
+            if (state != regex::Dfa_Dead and !visited[state])
+            {
+                visited[state] = true;
+                states.push_back(state);
+            }
+        }
+    }
+
+    open.resize(visited.size());
+    for (u32 state : states)
+    {
+        u32 next = dfa.table[state * dfa.width + dfa.classes[(u8)'\n']].state;
+        if (next == regex::Dfa_Dead)
+            continue;
+
+        const regex::Dfa_Edge *row = &dfa.table[next * dfa.width];
+        for (u32 symbol = 0; symbol < dfa.width; symbol++)
+        {
+            if (row[symbol].state != regex::Dfa_Dead or row[symbol].accept != row[dfa.width - 1].accept)
+                open[state] = true;
+        }
+    }
+
+    if (open[dfa.start])
+        return std::nullopt;
+
+    regex::Charset guards = {};
+    for (u32 state : states)
+    {
+        for (u32 c = 0; c < 256; c++)
+        {
+            if (open[dfa.table[state * dfa.width + dfa.classes[c]].state])
+                guards.set(c);
+        }
+    }
+
+    if (guards['\n'])
+        return std::nullopt;
+    return guards;
+}
+
+} // namespace bee
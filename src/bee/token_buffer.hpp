@@ -0,0 +1,91 @@
+#ifndef BEE_TOKEN_BUFFER_HPP
+#define BEE_TOKEN_BUFFER_HPP
+
+#include "core.hpp"
+#include "interner.hpp"
+#include "scanner.hpp"
+#include "thread_pool.hpp"
+#include "token.hpp"
+#include <bit>
+#include <optional>
+#include <vector>
+
+namespace bee
+{
+
+constexpr usize Token_Chunk_Size = 1 << 18;
+
+// Every token of a source scanned in one pass, stored as a structure of arrays: 9 bytes per token instead of the 32
+// bytes of a Token. The type is stored as the index of its bit and the expression as an offset into the source. The
+// last token is always the Eof token of the scanner.
+// The source is split in chunks ending after a '\n' that are tokenized on the pool and appended in order. A '\n' can
+// be inside of a token (a string escaping it), newline_guards() gives the characters that may precede such a '\n', a
+// chunk only ends after a '\n' that does not follow one of them. Without a provable split the scan is serial.
+// intern() gives the identifiers their symbol in one pass after the scan, the chunks never touch the interner
+
+struct Token_Buffer
+{
+    std::string_view source;
+    std::vector<u8> types;
+    std::vector<u32> offsets;
+    std::vector<u32> sizes;
+    std::vector<u32> symbols;
+    const Interner *interner = NULL;
+
+    Token_Buffer(Scanner &scanner);
+    Token_Buffer(Scanner &scanner, Thread_Pool &pool, usize chunk_size = Token_Chunk_Size);
+
+    usize size() const
+    {
+        return types.size();
+    }
+
+    Token_Type type(usize n) const
+    {
+        return types[n] < 64 ? Token_Type{bitset(types[n])} : Token_None;
+    }
+
+    Token token(usize n) const
+    {
+        return Token{source.substr(offsets[n], sizes[n]), type(n), true, !symbols.empty() ? symbols[n] : Symbol_None};
+    }
+
+    void push(Token token);
+    void append(const Token_Buffer &chunk);
+    void intern(Interner &names);
+
+    static std::optional<regex::Charset> newline_guards(const regex::Dfa_Table &dfa);
+};
+
+// Lookahead over a token buffer with the semantics of the parser: scan() only moves past the token when it is one of
+// the expected types, the cursor never moves past the Eof token
+
+struct Token_Cursor
+{
+    const Token_Buffer *buffer;
+    usize n;
+
+    Token peek(u64 types) const
+    {
+        Token token = buffer->token(n);
+        token.ok = token.type & types;
+        return token;
+    }
+
+    Token scan(u64 types)
+    {
+        Token token = peek(types);
+        if (token.ok and n + 1 < buffer->size())
+            n++;
+        return token;
+    }
+
+    bool eof() const
+    {
+        return buffer->types[n] == std::countr_zero((u64)Token_Eof);
+    }
+};
+
+} // namespace bee
+
+#endif
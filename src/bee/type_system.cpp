@@ -3,6 +3,9 @@
 #include "type.hpp"
 #include "var.hpp"
 #include "ast.hpp"
+#include "flat_ast.hpp"
+#include <algorithm>
+#include <vector>
 
 namespace bee
 {
@@ -33,8 +36,8 @@ u32 Type_System::cast_type(Ast_Entity *from, Ast_Entity *into)
             if (from_def != NULL ^ into_def != NULL)
                 return Type_Cast_Error;
 
-            Ast_Entity *from_type = expr_type(from_def->expr);
-            Ast_Entity *into_type = expr_type(into_def->expr);
+            Ast_Entity *from_type = typed(from_def->expr);
+            Ast_Entity *into_type = typed(into_def->expr);
 
             if (cast_type(from_type, into_type) != Type_Cast_Same)
                 return Type_Cast_Error;
@@ -96,13 +99,13 @@ Ast_Entity *Type_System::expr_type(Ast_Expr *ast_expr)
     switch (ast_expr->kind())
     {
     case Ast_Expr_Unary:
-        return expr_type(((Unary_Expr *)ast_expr)->expr);
+        return typed(((Unary_Expr *)ast_expr)->expr);
 
     case Ast_Expr_Binary:
         return ((Binary_Expr *)ast_expr)->type;
 
     case Ast_Expr_Nested:
-        return expr_type(((Nested_Expr *)ast_expr)->expr);
+        return typed(((Nested_Expr *)ast_expr)->expr);
 
     case Ast_Expr_Id:
         return entity_type(((Id_Expr *)ast_expr)->entity);
@@ -147,6 +150,161 @@ Ast_Entity *Type_System::expr_type(Ast_Expr *ast_expr)
     }
 }
 
+// Cached type of the expression. expr_type() alone walks the right-leaning chain under an expression again on every
+// call (signs, parentheses, right associative operators), the cache types each node once. The expressions of a source
+// still being parsed are not cached yet, they are typed on demand
+Ast_Entity *Type_System::typed(Ast_Expr *ast_expr)
+{
+    return ast_expr->typed != NULL ? ast_expr->typed : expr_type(ast_expr);
+}
+
+// Children first, the type of an expression is derived from the cached types of its children. The parameters of a
+// function are typed with it, strings have no type yet. The expressions wait on an explicit stack until their children
+// are typed, the depth of the ast does not reach the native stack
+void Type_System::type_exprs(Ast_Expr *ast_expr)
+{
+    std::vector<std::pair<Ast_Expr *, bool>> stack{{ast_expr, false}};
+
+    while (!stack.empty())
+    {
+        auto [expr, children] = stack.back();
+        if (children)
+        {
+            stack.pop_back();
+            if (expr->kind() != Ast_Expr_Str)
+                expr->typed = expr_type(expr);
+            continue;
+        }
+
+        stack.back().second = true;
+        ast_expr_children(expr, [&stack](Ast_Expr *child) {
+            stack.emplace_back(child, false);
+        });
+        if (expr->kind() == Ast_Expr_Function)
+        {
+            Function *function = ((Function_Expr *)expr)->function;
+            if (function->params != NULL)
+                stack.emplace_back(function->params, false);
+        }
+    }
+}
+
+// Every variable gets a fixed offset in the record of the function it belongs to, the parameters first, the globals are
+// in the record of the main scope. The variables of a scope take the bytes after the ones of the scopes around it until
+// the scope ends, a record is sized for its deepest scope. The expressions wait on an explicit stack like in
+// type_exprs()
+void Type_System::slot_vars(Scope_Expr *main_scope)
+{
+    struct Visit
+    {
+        Ast_Expr *expr;
+        u32 top;
+        bool children;
+    };
+
+    std::vector<Scope_Expr *> records{main_scope};
+    std::vector<u32> tops{0};
+    std::vector<Visit> stack{{main_scope, 0, false}};
+    main_scope->depth = 0;
+    main_scope->slots = 0;
+
+    auto slot = [&](Var *var) {
+        u32 size = size_type(var->type);
+        u32 align = std::clamp<u32>(size, 1, sizeof(u64));
+        u32 &top = tops.back();
+        var->depth = records.size() - 1;
+        var->offset = (top + align - 1) / align * align;
+        top = var->offset + size;
+        records.back()->slots = std::max(records.back()->slots, top);
+    };
+
+    while (!stack.empty())
+    {
+        Visit visit = stack.back();
+        if (visit.children)
+        {
+            stack.pop_back();
+            if (visit.expr->kind() == Ast_Expr_Scope)
+                tops.back() = visit.top;
+            else if (visit.expr->kind() == Ast_Expr_Function)
+                records.pop_back(), tops.pop_back();
+            continue;
+        }
+
+        stack.back().children = true;
+        stack.back().top = tops.back();
+        if (visit.expr->kind() == Ast_Expr_Var)
+            slot(((Var_Expr *)visit.expr)->var);
+        else if (visit.expr->kind() == Ast_Expr_Function)
+        {
+            Function_Expr *def = (Function_Expr *)visit.expr;
+            def->scope->depth = records.size();
+            def->scope->slots = 0;
+            records.push_back(def->scope);
+            tops.push_back(0);
+            for (Var_Expr *param = def->function->params; param != NULL; param = param->next)
+                slot(param->var);
+        }
+
+        // The children are visited in order, the scopes before a variable do not take its bytes
+        usize n = stack.size();
+        ast_expr_children(visit.expr, [&stack](Ast_Expr *child) {
+            stack.push_back(Visit{child, 0, false});
+        });
+        std::reverse(stack.begin() + n, stack.end());
+    }
+}
+
+Ast_Entity *Type_System::expr_type(Flat_Node node)
+{
+    while (node.kind() & (Ast_Expr_Unary | Ast_Expr_Nested))
+        node = node.child(0);
+
+    switch (node.kind())
+    {
+
+    case Ast_Expr_Binary:
+        return node.ptr<Ast_Entity>(0);
+
+    case Ast_Expr_Id:
+    case Ast_Expr_Var:
+    case Ast_Expr_Function:
+        return entity_type(node.ptr<Ast_Entity>(0));
+
+    case Ast_Expr_Char:
+        return char_type;
+
+    case Ast_Expr_Str:
+        throw errorf("TODO! Ast_Expr_Str type deduction must implement pointers/arrays");
+
+    case Ast_Expr_Invoke:
+        return node.ptr<Function>(0)->type;
+
+    case Ast_Expr_Int: {
+        if (Ast_Entity *type = node.ptr<Ast_Entity>(2))
+            return type;
+        Ast_Entity *type = compose_atom(Atom_Signed, node.word(1));
+
+        if (!type)
+            throw errorf("cannot create integer type of size '{:d}'", node.word(1));
+        return type;
+    }
+
+    case Ast_Expr_Float: {
+        if (Ast_Entity *type = node.ptr<Ast_Entity>(2))
+            return type;
+        Ast_Entity *type = compose_atom(Atom_Float, node.word(1));
+
+        if (!type)
+            throw errorf("cannot create float type of size '{:d}'", node.word(1));
+        return type;
+    }
+
+    default:
+        return void_type;
+    }
+}
+
 Ast_Entity *Type_System::entity_type(Ast_Entity *ast_entity)
 {
 
@@ -170,10 +328,9 @@ void Type_System::std_types(Ast *ast)
 {
     auto atom = [ast](std::string_view name, Atom_Desc desc, u32 size) -> Ast_Entity * {
         Atom_Type *atom = new Atom_Type;
-        atom->name = name;
         atom->desc = desc;
         atom->size = size;
-        return ast->frame->push_def(atom);
+        return ast->push_def(atom, ast->interner.intern(name));
     };
 
     f16_type = atom("f16", Atom_Float, 2);
@@ -193,8 +350,7 @@ void Type_System::std_types(Ast *ast)
     usize_type = atom("usize", Atom_Raw, sizeof(usize));
 
     void_type = new Void_Type;
-    void_type->name = "void";
-    ast->frame->push_def(void_type);
+    ast->push_def(void_type, ast->interner.intern("void"));
 }
 
 Ast_Entity *Type_System::compose_atom(u32 desc, u32 size)
@@ -8,6 +8,8 @@ namespace bee
 struct Ast;
 struct Ast_Expr;
 struct Ast_Entity;
+struct Scope_Expr;
+struct Flat_Node;
 
 enum Type_Cast : u32
 {
@@ -40,6 +42,10 @@ struct Type_System
     u32 cast_type(Ast_Entity *from, Ast_Entity *into);
     u32 size_type(Ast_Entity *ast_entity);
     Ast_Entity *expr_type(Ast_Expr *ast_expr);
+    Ast_Entity *expr_type(Flat_Node node);
+    Ast_Entity *typed(Ast_Expr *ast_expr);
+    void type_exprs(Ast_Expr *ast_expr);
+    void slot_vars(Scope_Expr *main_scope);
     Ast_Entity *entity_type(Ast_Entity *ast_entity);
 
     void std_types(Ast *ast);
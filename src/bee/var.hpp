@@ -13,6 +13,12 @@ struct Var : Ast_Entity_Impl<Ast_Entity_Var>
     Ast_Entity *type;
     u32 begin;
     u32 end;
+    // Set by Register_Allocator, NULL when the variable is spilled
+    Register *reg = NULL;
+
+    // Place in the activation record 'depth' functions deep from the main scope, set by Type_System::slot_vars()
+    u32 depth = 0;
+    u32 offset = 0;
 };
 
 } // namespace bee
@@ -0,0 +1,211 @@
+#include "kernel.hpp"
+#include "type.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+namespace bee
+{
+
+// The operations of the table of kernels, a block of kernels for each one
+enum Vm_Op : u32
+{
+    Vm_Op_Assign,
+    Vm_Op_And,
+    Vm_Op_Or,
+    Vm_Op_Add,
+    Vm_Op_Sub,
+    Vm_Op_Mul,
+    Vm_Op_Div,
+    Vm_Op_Mod,
+    Vm_Op_Bin_And,
+    Vm_Op_Bin_Or,
+    Vm_Op_Bin_Xor,
+    Vm_Op_Shift_L,
+    Vm_Op_Shift_R,
+    Vm_Op_Eq,
+    Vm_Op_Not_Eq,
+    Vm_Op_Less,
+    Vm_Op_Less_Eq,
+    Vm_Op_Greater,
+    Vm_Op_Greater_Eq,
+    Vm_Op_Count,
+};
+
+const usize Vm_Atom_Count = std::variant_size_v<Vm_Atom>;
+
+constexpr bool vm_int_op(u32 op)
+{
+    return op >= Vm_Op_Mod and op <= Vm_Op_Shift_R;
+}
+
+constexpr Vm_Op vm_op(Token_Type op)
+{
+    switch (op)
+    {
+    case Token_Assign:
+        return Vm_Op_Assign;
+    case Token_And:
+        return Vm_Op_And;
+    case Token_Or:
+        return Vm_Op_Or;
+    case Token_Add:
+        return Vm_Op_Add;
+    case Token_Sub:
+        return Vm_Op_Sub;
+    case Token_Mul:
+        return Vm_Op_Mul;
+    case Token_Div:
+        return Vm_Op_Div;
+    case Token_Mod:
+        return Vm_Op_Mod;
+    case Token_Bin_And:
+        return Vm_Op_Bin_And;
+    case Token_Bin_Or:
+        return Vm_Op_Bin_Or;
+    case Token_Bin_Xor:
+        return Vm_Op_Bin_Xor;
+    case Token_Shift_L:
+        return Vm_Op_Shift_L;
+    case Token_Shift_R:
+        return Vm_Op_Shift_R;
+    case Token_Eq:
+        return Vm_Op_Eq;
+    case Token_Not_Eq:
+        return Vm_Op_Not_Eq;
+    case Token_Less:
+        return Vm_Op_Less;
+    case Token_Less_Eq:
+        return Vm_Op_Less_Eq;
+    case Token_Greater:
+        return Vm_Op_Greater;
+    case Token_Greater_Eq:
+        return Vm_Op_Greater_Eq;
+    default:
+        return Vm_Op_Count;
+    }
+}
+
+// The alternative of Vm_Atom for the type, or Vm_Atom_Count
+inline usize vm_atom_index(Atom_Type *type)
+{
+    usize width = type->size == 1 ? 0 : type->size == 2 ? 1 : type->size == 4 ? 2 : type->size == 8 ? 3 : 4;
+    switch (type->desc)
+    {
+    case Atom_Raw:
+        return width < 4 ? width : Vm_Atom_Count;
+    case Atom_Signed:
+        return width < 4 ? 4 + width : Vm_Atom_Count;
+    case Atom_Float:
+        return width == 2 or width == 3 ? 6 + width : Vm_Atom_Count;
+    }
+    return Vm_Atom_Count;
+}
+
+// The atom the type system composes for two operands: the largest size, float over signed over raw
+template <usize S>
+using vm_raw_t = std::conditional_t<S == 1, u8, std::conditional_t<S == 2, u16, std::conditional_t<S == 4, u32, u64>>>;
+
+template <typename P, typename Q, usize S = std::max(sizeof(P), sizeof(Q))>
+using vm_compose_t = std::conditional_t<
+    std::is_floating_point_v<P> or std::is_floating_point_v<Q>, std::conditional_t<S == sizeof(f32), f32, f64>,
+    std::conditional_t<std::is_signed_v<P> or std::is_signed_v<Q>, std::make_signed_t<vm_raw_t<S>>, vm_raw_t<S>>>;
+
+// The operands are converted to their composed atom, the type of the expression as Bytecode and Closure compute it,
+// and the result is written once both are read, it may take the place of one of them. An assignment writes the
+// operand on the left and results in its new value, the logical operations result in a bool
+template <u32 Op, typename P, typename Q>
+u32 vm_binary_kernel(u8 *result, u8 *prev, u8 *post)
+{
+    using C = vm_compose_t<P, Q>;
+    P p;
+    Q q;
+    std::memcpy(&p, prev, sizeof(P));
+    std::memcpy(&q, post, sizeof(Q));
+    C a = (C)p;
+    C b = (C)q;
+
+    auto x = [&] {
+        if constexpr (Op == Vm_Op_Assign)
+        {
+            p = q;
+            std::memcpy(prev, &p, sizeof(P));
+            return p;
+        }
+        else if constexpr (Op == Vm_Op_And)
+            return p && q;
+        else if constexpr (Op == Vm_Op_Or)
+            return p || q;
+        else if constexpr (Op == Vm_Op_Add)
+            return (C)(a + b);
+        else if constexpr (Op == Vm_Op_Sub)
+            return (C)(a - b);
+        else if constexpr (Op == Vm_Op_Mul)
+            return (C)(a * b);
+        else if constexpr (Op == Vm_Op_Div)
+            return (C)(a / b);
+        else if constexpr (Op == Vm_Op_Mod)
+            return (C)(a % b);
+        else if constexpr (Op == Vm_Op_Bin_And)
+            return (C)(a & b);
+        else if constexpr (Op == Vm_Op_Bin_Or)
+            return (C)(a | b);
+        else if constexpr (Op == Vm_Op_Bin_Xor)
+            return (C)(a ^ b);
+        else if constexpr (Op == Vm_Op_Shift_L)
+            return (C)(a << b);
+        else if constexpr (Op == Vm_Op_Shift_R)
+            return (C)(a >> b);
+        else if constexpr (Op == Vm_Op_Eq)
+            return a == b;
+        else if constexpr (Op == Vm_Op_Not_Eq)
+            return a != b;
+        else if constexpr (Op == Vm_Op_Less)
+            return a < b;
+        else if constexpr (Op == Vm_Op_Less_Eq)
+            return a <= b;
+        else if constexpr (Op == Vm_Op_Greater)
+            return a > b;
+        else
+            return a >= b;
+    }();
+
+    std::memcpy(result, &x, sizeof(x));
+    return sizeof(x);
+}
+
+// The kernels are laid out by operation, then by the alternative of the left operand, then of the right one
+template <usize N>
+constexpr Vm_Kernel vm_kernel_at()
+{
+    constexpr u32 op = N / (Vm_Atom_Count * Vm_Atom_Count);
+    using P = std::remove_pointer_t<std::variant_alternative_t<N / Vm_Atom_Count % Vm_Atom_Count, Vm_Atom>>;
+    using Q = std::remove_pointer_t<std::variant_alternative_t<N % Vm_Atom_Count, Vm_Atom>>;
+
+    if constexpr (vm_int_op(op) and !(std::is_integral_v<P> and std::is_integral_v<Q>))
+        return NULL;
+    else
+        return &vm_binary_kernel<op, P, Q>;
+}
+
+template <usize... N>
+constexpr std::array<Vm_Kernel, sizeof...(N)> vm_kernel_table(std::index_sequence<N...>)
+{
+    return {vm_kernel_at<N>()...};
+}
+
+constexpr auto vm_kernels = vm_kernel_table(std::make_index_sequence<Vm_Op_Count * Vm_Atom_Count * Vm_Atom_Count>{});
+
+Vm_Kernel vm_kernel(Token_Type op, Atom_Type *prev, Atom_Type *post)
+{
+    usize n = vm_op(op);
+    usize p = vm_atom_index(prev);
+    usize q = vm_atom_index(post);
+    if (n == Vm_Op_Count or p == Vm_Atom_Count or q == Vm_Atom_Count)
+        return NULL;
+    return vm_kernels[(n * Vm_Atom_Count + p) * Vm_Atom_Count + q];
+}
+
+} // namespace bee
@@ -0,0 +1,17 @@
+#ifndef BEE_VM_KERNEL_HPP
+#define BEE_VM_KERNEL_HPP
+
+#include "core.hpp"
+#include "object.hpp"
+#include "token.hpp"
+
+namespace bee
+{
+struct Atom_Type;
+
+// The kernel of a binary operation on atoms of the two types, NULL when the operation does not apply to them
+Vm_Kernel vm_kernel(Token_Type op, Atom_Type *prev, Atom_Type *post);
+
+} // namespace bee
+
+#endif
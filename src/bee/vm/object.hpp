@@ -25,6 +25,9 @@ struct Vm_Object
 
 using Vm_Atom = std::variant<u8 *, u16 *, u32 *, u64 *, s8 *, s16 *, s32 *, s64 *, f32 *, f64 *>;
 
+// Writes the result of a binary operation on the values of 'prev' and 'post', and returns its size
+using Vm_Kernel = u32 (*)(u8 *result, u8 *prev, u8 *post);
+
 } // namespace bee
 
 #endif
@@ -1,9 +1,15 @@
 #include "vm.hpp"
 #include "ast.hpp"
+#include "flat_ast.hpp"
+#include "kernel.hpp"
 #include "type.hpp"
 #include "var.hpp"
+#include <algorithm>
+#include <bit>
 #include <cmath>
+#include <cstring>
 #include <type_traits>
+#include <utility>
 
 namespace bee
 {
@@ -21,16 +27,28 @@ Vm::Vm(Ast *ast) :
 
 s32 Vm::run()
 {
+    // A run starts from an empty stack, the same Vm can run again
+    sp = 0;
+    bases.assign(1, 0);
+    push_record(ast->main_scope);
+
+    // The functions defined by the program are bound again while it runs
+    ast->push_frame(ast->main_frame);
+
     for (Ast_Expr *expr : *ast->main_scope->compound)
     {
         run_expr(expr);
     }
 
-    Ast_Entity *main = ast->main_frame->find_def("main");
+    Ast_Entity *main = ast->defs.find(ast->interner.find("main"));
     if (!main or main->kind() != Ast_Entity_Function)
         throw errorf("no entry point defined in program, consider the implementation of 'main :: () -> s32'");
-    Scope_Expr *main_scope = ast->main_frame->find_function((Function *)main);
-    return *(s32 *)run_scope(main_scope).ref;
+    Scope_Expr *main_scope = ast->binds.find((Function *)main);
+    bases[main_scope->depth] = push_record(main_scope);
+    s32 result = run_result(run_scope(main_scope));
+
+    ast->pop_frame();
+    return result;
 
     // Ast_Entity *main = ast->main_frame->find_def("main");
     // if (!main or main->kind() != Ast_Entity_Function)
@@ -64,17 +82,17 @@ Vm_Object Vm::run_expr(Ast_Expr *expr)
 
     case Ast_Expr_Char: {
         Char_Expr *char_expr = (Char_Expr *)expr;
-        return run_atom(type_system.expr_type(char_expr), &char_expr->data);
+        return run_atom(type_system.typed(char_expr), &char_expr->data);
     }
 
     case Ast_Expr_Int: {
         Int_Expr *int_expr = (Int_Expr *)expr;
-        return run_atom(type_system.expr_type(int_expr), &int_expr->data);
+        return run_atom(type_system.typed(int_expr), &int_expr->data);
     }
 
     case Ast_Expr_Float: {
         Float_Expr *float_expr = (Float_Expr *)expr;
-        return run_atom(type_system.expr_type(float_expr), &float_expr->data);
+        return run_float(type_system.typed(float_expr), float_expr->data);
     }
 
     case Ast_Expr_Return:
@@ -147,7 +165,11 @@ Vm_Atom Vm::vm_atom(Atom_Type *type, u8 *ref)
 
 Vm_Object Vm::run_unary(Unary_Expr *unary)
 {
-    Vm_Object object = run_expr(unary->expr);
+    return run_unary(unary->op.type, unary->order, run_expr(unary->expr));
+}
+
+Vm_Object Vm::run_unary(Token_Type op, Order_Expr order, Vm_Object object)
+{
     if (object.type->kind() != Ast_Entity_Atom)
     {
         throw errorf("cannot perform unary operation on non-atom expression of type '{:s}'", object.type->name);
@@ -166,7 +188,7 @@ Vm_Object Vm::run_unary(Unary_Expr *unary)
         return Vm_Object{object.type, stack_push((u8 *)&w, sizeof(w))}; \
     }
 
-    switch (unary->op.type)
+    switch (op)
     {
     case Token_Add:
         return std::visit(vm_prev_op(+), atom);
@@ -175,7 +197,7 @@ Vm_Object Vm::run_unary(Unary_Expr *unary)
         return std::visit(vm_prev_op(-), atom);
 
     case Token_Decrement: {
-        switch (unary->order)
+        switch (order)
         {
         case Prev_Expr:
             return std::visit(vm_prev_op(--), atom);
@@ -185,7 +207,7 @@ Vm_Object Vm::run_unary(Unary_Expr *unary)
     }
 
     case Token_Increment: {
-        switch (unary->order)
+        switch (order)
         {
         case Prev_Expr:
             return std::visit(vm_prev_op(++), atom);
@@ -195,153 +217,147 @@ Vm_Object Vm::run_unary(Unary_Expr *unary)
     }
 
     default:
-        throw errorf("TODO! run_unary() not implemented for '{:s}'", token_typename(unary->op.type));
+        throw errorf("TODO! run_unary() not implemented for '{:s}'", token_typename(op));
     }
 
 #undef vm_prev_op
 #undef vm_post_op
 }
 
-template <typename T>
-concept Any = true;
+// A chain of left operands (a + b + c ...) runs from its innermost operand back up on an explicit stack instead of
+// recursing into it. The result of each operation takes the place of the ones of the operands, the chain runs in the
+// stack space of one operation
+Vm_Object Vm::run_binary(Binary_Expr *binary)
+{
+    u64 bsp = sp;
+    usize base = spine.size();
+    spine.push_back(binary);
+    for (Ast_Expr *prev; (prev = spine.back()->prev)->kind() == Ast_Expr_Binary;)
+        spine.push_back((Binary_Expr *)prev);
 
-template <typename T>
-concept Is_Int = std::integral<std::decay_t<T>>;
+    Vm_Object object = run_expr(spine.back()->prev);
+    while (spine.size() > base)
+    {
+        binary = spine.back();
+        spine.pop_back();
 
-template <class... Ts>
-struct Visit_Pack : Ts...
-{
-    using Ts::operator()...;
-};
-template <class... Ts>
-Visit_Pack(Ts...) -> Visit_Pack<Ts...>;
+        Vm_Object post = run_expr(binary->post);
+        if (binary->kernel == NULL)
+            binary->kernel = binary_kernel(binary->op.type, object, post);
+        object = run_kernel(binary->kernel, binary->type, bsp, object, post);
+    }
+    return object;
+}
 
-Vm_Object Vm::run_binary(Binary_Expr *binary)
+Vm_Kernel Vm::binary_kernel(Token_Type op, Vm_Object object_prev, Vm_Object object_post)
 {
-    Vm_Object object_prev = run_expr(binary->prev);
-    Vm_Object object_post = run_expr(binary->post);
     if ((object_prev.type->kind() & object_post.type->kind()) != Ast_Entity_Atom)
     {
         throw errorf("cannot perform binary operation on non-atom expression of type '{:s}', '{:s}'",
                      object_prev.type->name, object_post.type->name);
     }
-    Vm_Atom atom_prev = vm_atom((Atom_Type *)object_prev.type, object_prev.ref);
-    Vm_Atom atom_post = vm_atom((Atom_Type *)object_post.type, object_post.ref);
-
-#define vm_op(op, V, W)                                                  \
-    [&](V auto &&v, W auto &&w) -> Vm_Object {                           \
-        auto x = (*v)op(*w);                                             \
-        return Vm_Object{binary->type, stack_push((u8 *)&x, sizeof(x))}; \
-    }
-
-    auto vm_op_error = [&](auto, auto) -> Vm_Object {
-        throw errorf("cannot perform binary operation '{:s}' with expressions of type '{:s}', '{:s}'",
-                     token_typename(binary->op.type), object_prev.type->name, object_post.type->name);
-    };
-
-    switch (binary->op.type)
+    Vm_Kernel kernel = vm_kernel(op, (Atom_Type *)object_prev.type, (Atom_Type *)object_post.type);
+    if (kernel == NULL)
     {
-    case Token_Assign:
-        return std::visit(vm_op(=, Any, Any), atom_prev, atom_post);
-
-    case Token_And:
-        return std::visit(vm_op(&&, Any, Any), atom_prev, atom_post);
-    case Token_Or:
-        return std::visit(vm_op(||, Any, Any), atom_prev, atom_post);
-    case Token_Add:
-        return std::visit(vm_op(+, Any, Any), atom_prev, atom_post);
-    case Token_Sub:
-        return std::visit(vm_op(-, Any, Any), atom_prev, atom_post);
-    case Token_Mul:
-        return std::visit(vm_op(*, Any, Any), atom_prev, atom_post);
-    case Token_Div:
-        return std::visit(vm_op(/, Any, Any), atom_prev, atom_post);
-    case Token_Mod:
-        return std::visit(Visit_Pack{vm_op(&, Is_Int, Is_Int), vm_op_error}, atom_prev, atom_post);
-
-    case Token_Bin_And:
-        return std::visit(Visit_Pack{vm_op(&, Is_Int, Is_Int), vm_op_error}, atom_prev, atom_post);
-    case Token_Bin_Or:
-        return std::visit(Visit_Pack{vm_op(|, Is_Int, Is_Int), vm_op_error}, atom_prev, atom_post);
-    case Token_Bin_Xor:
-        return std::visit(Visit_Pack{vm_op(^, Is_Int, Is_Int), vm_op_error}, atom_prev, atom_post);
-    case Token_Shift_L:
-        return std::visit(Visit_Pack{vm_op(<<, Is_Int, Is_Int), vm_op_error}, atom_prev, atom_post);
-    case Token_Shift_R:
-        return std::visit(Visit_Pack{vm_op(>>, Is_Int, Is_Int), vm_op_error}, atom_prev, atom_post);
-
-    case Token_Eq:
-        return std::visit(vm_op(==, Any, Any), atom_prev, atom_post);
-    case Token_Not_Eq:
-        return std::visit(vm_op(!=, Any, Any), atom_prev, atom_post);
-    case Token_Less:
-        return std::visit(vm_op(<, Any, Any), atom_prev, atom_post);
-    case Token_Less_Eq:
-        return std::visit(vm_op(<=, Any, Any), atom_prev, atom_post);
-    case Token_Greater:
-        return std::visit(vm_op(>, Any, Any), atom_prev, atom_post);
-    case Token_Greater_Eq:
-        return std::visit(vm_op(>=, Any, Any), atom_prev, atom_post);
-
-    default:
-        throw errorf("TODO! run_binary() not implemented for '{:s}'", token_typename(binary->op.type));
+        throw errorf("cannot perform binary operation '{:s}' with expressions of type '{:s}', '{:s}'",
+                     token_typename(op), object_prev.type->name, object_post.type->name);
     }
-#undef vm_op
+    return kernel;
 }
 
+// The result is written at 'bsp', over the operands when they were pushed
+Vm_Object Vm::run_kernel(Vm_Kernel kernel, Ast_Entity *type, u64 bsp, Vm_Object object_prev, Vm_Object object_post)
+{
+    if (bsp + sizeof(u64) > std::size(stack))
+        throw errorf("stack overflow (sp > {})", std::size(stack));
+    sp = bsp + kernel(&stack[bsp], object_prev.ref, object_post.ref);
+    return Vm_Object{type, &stack[bsp]};
+}
+
+// The variables of the scope are in their records already, only the functions it defines are bound to it
 Vm_Object Vm::run_scope(Scope_Expr *scope)
 {
     Vm_Object object = vm_none;
     u64 bsp = sp;
-    ast->push_frame(scope->frame);
+    ast->binds.push_scope();
 
     for (Ast_Expr *expr : *scope->compound)
     {
+        // An invoke statement follows the name of its function, which is a statement of its own and is not run
+        if (expr->kind() == Ast_Expr_Id)
+            continue;
         object = run_expr(expr);
         if (object.interrupt != Vm_Interrupt_None)
             break;
     }
 
-    ast->pop_frame();
+    ast->binds.pop_scope();
     sp = bsp;
     return object;
 }
 
 Vm_Object Vm::run_var(Var_Expr *def)
 {
-    Vm_Object object = run_expr(def->expr);
-    if (type_system.cast_type(object.type, def->var->type) >= Type_Cast_Transmuted)
-    {
-        throw errorf("variable definition expression reduces to '{:s}' instead of '{:s}'", object.type->name,
-                     def->var->type->name);
-    }
-    ast->frame->push_ref(def->var, object.ref);
+    Vm_Object object = run_var(def->var, def->expr != NULL ? run_expr(def->expr) : run_zero(def->var->type));
 
     if (def->next != NULL)
         return run_var(def->next);
     return object;
 }
 
-Vm_Object Vm::run_var_id(Id_Expr *id)
+// A variable defined without expression is zero
+Vm_Object Vm::run_zero(Ast_Entity *type)
+{
+    u64 zero = 0;
+    return Vm_Object{type, stack_push((u8 *)&zero, std::min<usize>(type_system.size_type(type), sizeof(zero)))};
+}
+
+Vm_Object Vm::run_var(Var *var, Vm_Object object)
 {
-    if (id->entity->kind() != Ast_Entity_Var)
+    if (type_system.cast_type(object.type, var->type) >= Type_Cast_Transmuted)
     {
-        throw errorf("'{:s}' does not reference a variable", id->name.expr);
+        throw errorf("variable definition expression reduces to '{:s}' instead of '{:s}'", object.type->name,
+                     var->type->name);
     }
+    return store_var(var->type, &stack[bases[var->depth] + var->offset], object);
+}
 
-    Var *var = (Var *)id->entity;
-    u8 *ref = ast->frame->find_ref(var);
-    if (!ref)
+// The value is converted into the type of the variable when they differ
+Vm_Object Vm::store_var(Ast_Entity *type, u8 *ref, Vm_Object object)
+{
+    if (object.type == type)
+        std::memcpy(ref, object.ref, type_system.size_type(type));
+    else
+        binary_kernel(Token_Assign, Vm_Object{type, ref}, object)(ref, ref, object.ref);
+    return Vm_Object{type, ref};
+}
+
+Vm_Object Vm::run_var_id(Id_Expr *id)
+{
+    return run_var_id(id->entity, id->name.expr);
+}
+
+Vm_Object Vm::run_var_id(Ast_Entity *entity, std::string_view name)
+{
+    if (entity->kind() != Ast_Entity_Var)
     {
-        throw errorf("cannot get the reference for '{:s}'", var->name);
+        throw errorf("'{:s}' does not reference a variable", name);
     }
 
-    return Vm_Object{var->type, ref};
+    Var *var = (Var *)entity;
+    return Vm_Object{var->type, &stack[bases[var->depth] + var->offset]};
 }
 
 Vm_Object Vm::run_function(Function_Expr *def)
 {
-    ast->frame->push_function(def->function, def->scope);
+    return run_function(def->function, def->scope);
+}
+
+Vm_Object Vm::run_function(Function *function, Scope_Expr *scope)
+{
+    if (ast->binds.find_scope(function) != NULL)
+        throw errorf("redefinition of function '{:s}'", function->name);
+    ast->binds.insert(function, scope);
     return vm_none;
 }
 
@@ -350,38 +366,56 @@ Vm_Object Vm::run_invoke(Invoke_Expr *invoke)
     u64 bsp = sp;
     Function *function = invoke->function;
 
-    Scope_Expr *scope = ast->frame->find_function(function);
+    Scope_Expr *scope = ast->binds.find(function);
     if (!scope)
     {
         throw errorf("no definition found for function '{:s}'", function->name);
     }
 
-    ast->push_frame(new Frame{});
-    init_params(function->params, invoke->args);
-    // run_var(function->params);
+    // The arguments are run in the records of the caller
+    u64 base = push_record(scope);
+    init_params(function->params, invoke->args, base);
+    u64 caller = std::exchange(bases[scope->depth], base);
     Vm_Object return_object = run_scope(scope);
+    bases[scope->depth] = caller;
+    return return_invoke(function, bsp, return_object);
+}
 
-    for (auto [entity, ref] : ast->frame->refs)
+// The record of the call is left, the value returned takes its place on the stack
+Vm_Object Vm::return_invoke(Function *function, u64 bsp, Vm_Object return_object)
+{
+    for (Var_Expr *param = function->params; trace and param != NULL; param = param->next)
     {
-        Ast_Entity *type = type_system.entity_type(entity);
+        Ast_Entity *type = param->var->type;
         if (type->kind() & Ast_Entity_Atom)
         {
             std::visit(
                 [&](auto &&v) {
-                    fmt::print("{}: {} = {}\n", entity->name, type->name, *v);
+                    fmt::print("{}: {} = {}\n", param->var->name, type->name, *v);
                 },
-                vm_atom((Atom_Type *)type, ref));
+                vm_atom((Atom_Type *)type, &stack[bsp + param->var->offset]));
         }
     }
 
-    for (auto [function, scope] : ast->frame->binds)
-    {
-        fmt::print("'{:s}'\n{:p}", function->name, fmt::ptr(scope));
-    }
-
-    ast->pop_frame();
     sp = bsp;
-    return function->type->kind() != Ast_Entity_Void ? return_object : vm_none;
+    if (function->type->kind() == Ast_Entity_Void or return_object.ref == NULL)
+        return vm_none;
+
+    u32 size = type_system.size_type(return_object.type);
+    u8 *ref = (u8 *)std::memmove(&stack[bsp], return_object.ref, size);
+    sp += size;
+    return Vm_Object{return_object.type, ref};
+}
+
+u64 Vm::push_record(Scope_Expr *scope)
+{
+    u64 base = sp;
+    if (base + scope->slots > std::size(stack))
+        throw errorf("stack overflow (sp > {})", std::size(stack));
+    if (scope->depth >= bases.size())
+        bases.resize(scope->depth + 1);
+    sp += scope->slots;
+    return base;
 }
 
 Vm_Object Vm::run_return(Return_Expr *return_expr)
@@ -394,7 +428,6 @@ Vm_Object Vm::run_if(If_Expr *if_expr)
 {
     Vm_Object return_object = vm_none;
     u32 bsp = sp;
-    ast->push_frame(if_expr->frame);
 
     Vm_Object object = run_expr(if_expr->condition);
     Vm_Atom atom = vm_atom((Atom_Type *)object.type, object.ref);
@@ -411,7 +444,6 @@ Vm_Object Vm::run_if(If_Expr *if_expr)
     else if (if_expr->scope_else != NULL)
         return_object = run_scope(if_expr->scope_else);
 
-    ast->pop_frame();
     sp = bsp;
     return return_object;
 }
@@ -423,8 +455,28 @@ Vm_Object Vm::run_atom(Ast_Entity *entity, void *data)
     return Vm_Object{entity, ref};
 }
 
+// 'main' gives 0 when it ends without a return, the value it returns is converted to s32 otherwise
+s32 Vm::run_result(Vm_Object object)
+{
+    s32 result = 0;
+    if (object.interrupt == Vm_Return)
+        store_var(type_system.s32_type, (u8 *)&result, object);
+    return result;
+}
+
+// A float literal is parsed as f64, it is narrowed when its type is f32
+Vm_Object Vm::run_float(Ast_Entity *type, f64 data)
+{
+    if (type_system.size_type(type) == sizeof(f32))
+    {
+        f32 narrow = (f32)data;
+        return run_atom(type, &narrow);
+    }
+    return run_atom(type, &data);
+}
+
 // TODO! Implement default argument parameters
-void Vm::init_params(Var_Expr *param, Argument_Expr *argument)
+void Vm::init_params(Var_Expr *param, Argument_Expr *argument, u64 base)
 {
     if (!param or !argument)
         return;
@@ -436,8 +488,189 @@ void Vm::init_params(Var_Expr *param, Argument_Expr *argument)
                      param->var->type->name);
     }
 
-    ast->frame->push_ref(param->var, object.ref);
-    init_params(param->next, argument->next);
+    store_var(param->var->type, &stack[base + param->var->offset], object);
+    init_params(param->next, argument->next, base);
+}
+
+s32 Vm::run(const Flat_Ast &flat)
+{
+    // A run starts from an empty stack, the same Vm can run again
+    sp = 0;
+    bases.assign(1, 0);
+    push_record(ast->main_scope);
+    ast->push_frame(ast->main_frame);
+
+    for (Flat_Node node : flat.root().children())
+    {
+        run_expr(node);
+    }
+
+    Ast_Entity *main = ast->defs.find(ast->interner.find("main"));
+    if (!main or main->kind() != Ast_Entity_Function)
+        throw errorf("no entry point defined in program, consider the implementation of 'main :: () -> s32'");
+    Scope_Expr *main_scope = ast->binds.find((Function *)main);
+    bases[main_scope->depth] = push_record(main_scope);
+    s32 result = run_result(run_scope(Flat_Node{&flat, flat.bodies.at(main_scope)}));
+
+    ast->pop_frame();
+    return result;
+}
+
+Vm_Object Vm::run_expr(Flat_Node node)
+{
+    switch (node.kind())
+    {
+    case Ast_Expr_Unary:
+        return run_unary(node.op(), (Order_Expr)node.word(0), run_expr(node.child(0)));
+
+    case Ast_Expr_Binary:
+        return run_binary(node);
+
+    case Ast_Expr_Nested:
+        return run_expr(node.child(0));
+
+    case Ast_Expr_Scope:
+        return run_scope(node);
+
+    case Ast_Expr_Id:
+        return run_var_id(node.ptr<Ast_Entity>(0), node.token());
+
+    case Ast_Expr_Var:
+        return run_var(node);
+
+    case Ast_Expr_Char:
+    case Ast_Expr_Int:
+        return run_atom(type_system.expr_type(node), (void *)node.data(0));
+
+    case Ast_Expr_Float:
+        return run_float(type_system.expr_type(node), std::bit_cast<f64>(node.word(0)));
+
+    case Ast_Expr_Return: {
+        Vm_Object object = run_expr(node.child(0));
+        return Vm_Object{object.type, object.ref, Vm_Return};
+    }
+
+    case Ast_Expr_Function:
+        return run_function(node.ptr<Function>(0), node.ptr<Scope_Expr>(1));
+
+    case Ast_Expr_Invoke:
+        return run_invoke(node);
+
+    case Ast_Expr_If:
+        return run_if(node);
+
+    default:
+        throw errorf("TODO! run_expr() not implemented for '{:s}'", ast_expr_kind_name(node.kind()));
+    }
+}
+
+Vm_Object Vm::run_scope(Flat_Node scope)
+{
+    Vm_Object object = vm_none;
+    u64 bsp = sp;
+    ast->binds.push_scope();
+
+    for (Flat_Node node : scope.children())
+    {
+        if (node.kind() == Ast_Expr_Id)
+            continue;
+        object = run_expr(node);
+        if (object.interrupt != Vm_Interrupt_None)
+            break;
+    }
+
+    ast->binds.pop_scope();
+    sp = bsp;
+    return object;
+}
+
+Vm_Object Vm::run_var(Flat_Node def)
+{
+    Flat_Node expr = def.child(0);
+    Var *var = def.ptr<Var>(0);
+    Vm_Object object = run_var(var, !expr.none() ? run_expr(expr) : run_zero(var->type));
+
+    if (Flat_Node next = def.child(1); !next.none())
+        return run_var(next);
+    return object;
+}
+
+// The chain of left operands of a binary node is the run of binary nodes that follows it
+Vm_Object Vm::run_binary(Flat_Node binary)
+{
+    u64 bsp = sp;
+    u32 n = binary.n;
+    while (Flat_Node{binary.flat, n}.kind() == Ast_Expr_Binary)
+        n++;
+
+    Vm_Object object = run_expr(Flat_Node{binary.flat, n});
+    while (n-- > binary.n)
+    {
+        Flat_Node op{binary.flat, n};
+        Vm_Object post = run_expr(op.child(1));
+        object = run_kernel(binary_kernel(op.op(), object, post), op.ptr<Ast_Entity>(0), bsp, object, post);
+    }
+    return object;
+}
+
+Vm_Object Vm::run_invoke(Flat_Node invoke)
+{
+    u64 bsp = sp;
+    Function *function = invoke.ptr<Function>(0);
+
+    Scope_Expr *scope = ast->binds.find(function);
+    if (!scope)
+    {
+        throw errorf("no definition found for function '{:s}'", function->name);
+    }
+
+    u64 base = push_record(scope);
+    init_params(function->params, invoke.child(0), base);
+    u64 caller = std::exchange(bases[scope->depth], base);
+    Vm_Object return_object = run_scope(Flat_Node{invoke.flat, invoke.flat->bodies.at(scope)});
+    bases[scope->depth] = caller;
+    return return_invoke(function, bsp, return_object);
+}
+
+Vm_Object Vm::run_if(Flat_Node if_expr)
+{
+    Vm_Object return_object = vm_none;
+    u32 bsp = sp;
+
+    Vm_Object object = run_expr(if_expr.child(0));
+    Vm_Atom atom = vm_atom((Atom_Type *)object.type, object.ref);
+    bool condition;
+
+    std::visit(
+        [&condition](auto &&v) {
+            condition = static_cast<bool>(*v);
+        },
+        atom);
+
+    if (condition)
+        return_object = run_scope(if_expr.child(1));
+    else if (Flat_Node scope_else = if_expr.child(2); !scope_else.none())
+        return_object = run_scope(scope_else);
+
+    sp = bsp;
+    return return_object;
+}
+
+// The arguments are the flat nodes, the parameters are the ones of the function entity
+void Vm::init_params(Var_Expr *param, Flat_Node argument, u64 base)
+{
+    if (!param or argument.none())
+        return;
+
+    Vm_Object object = run_expr(argument.child(0));
+    if (type_system.cast_type(object.type, param->var->type) >= Type_Cast_Transmuted)
+    {
+        throw errorf("cannot cast argument of type '{}' to parameter '{}: {}'", object.type->name, param->var->name,
+                     param->var->type->name);
+    }
+
+    store_var(param->var->type, &stack[base + param->var->offset], object);
+    init_params(param->next, argument.child(1), base);
 }
 
 u8 *Vm::stack_push(u8 *data, usize size)
@@ -450,7 +683,7 @@ u8 *Vm::stack_push(u8 *data, usize size)
 
 u8 *Vm::stack_pop(usize size)
 {
-    if (sp - size < 0)
+    if (size > sp)
         throw errorf("stack underflow (sp < 0)");
     return &stack[sp -= size];
 }
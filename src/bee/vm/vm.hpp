@@ -3,9 +3,11 @@
 
 #include "core.hpp"
 #include "error.hpp"
+#include "expr.hpp"
 #include "object.hpp"
 #include <fmt/core.h>
 #include <unordered_map>
+#include <vector>
 
 namespace bee
 {
@@ -23,8 +25,14 @@ struct Return_Expr;
 struct Var_Expr;
 struct If_Expr;
 struct Atom_Type;
+struct Var;
+struct Function;
 struct Type_System;
+struct Flat_Ast;
+struct Flat_Node;
 
+// The variables live in the activation records of the calls on the stack, at the offsets Type_System::slot_vars()
+// gives them once the source is parsed. 'bases' holds the record in use at each depth, the globals are the record at the bottom
 struct Vm
 {
     Ast *ast;
@@ -32,6 +40,10 @@ struct Vm
     u64 sp;
     u8 stack[1024];
     Vm_Object vm_none;
+    std::vector<Binary_Expr *> spine;
+    std::vector<u64> bases;
+    // Prints the parameters of every call that returns
+    bool trace = false;
 
     Vm(Ast *ast);
     s32 run();
@@ -44,10 +56,33 @@ struct Vm
     Vm_Object run_function(Function_Expr *def);
     Vm_Object run_invoke(Invoke_Expr *invoke);
     Vm_Object run_atom(Ast_Entity *entity, void *data);
+    Vm_Object run_float(Ast_Entity *type, f64 data);
+    s32 run_result(Vm_Object object);
     Vm_Object run_return(Return_Expr *return_expr);
     Vm_Object run_if(If_Expr *if_expr);
 
-    void init_params(Var_Expr *param, Argument_Expr *argument);
+    // The same program run over a flat ast
+    s32 run(const Flat_Ast &flat);
+    Vm_Object run_expr(Flat_Node node);
+    Vm_Object run_scope(Flat_Node scope);
+    Vm_Object run_var(Flat_Node def);
+    Vm_Object run_binary(Flat_Node binary);
+    Vm_Object run_invoke(Flat_Node invoke);
+    Vm_Object run_if(Flat_Node if_expr);
+
+    Vm_Object run_unary(Token_Type op, Order_Expr order, Vm_Object object);
+    Vm_Kernel binary_kernel(Token_Type op, Vm_Object object_prev, Vm_Object object_post);
+    Vm_Object run_kernel(Vm_Kernel kernel, Ast_Entity *type, u64 bsp, Vm_Object object_prev, Vm_Object object_post);
+    Vm_Object run_var(Var *var, Vm_Object object);
+    Vm_Object run_zero(Ast_Entity *type);
+    Vm_Object store_var(Ast_Entity *type, u8 *ref, Vm_Object object);
+    Vm_Object run_var_id(Ast_Entity *entity, std::string_view name);
+    Vm_Object run_function(Function *function, Scope_Expr *scope);
+    Vm_Object return_invoke(Function *function, u64 bsp, Vm_Object return_object);
+
+    u64 push_record(Scope_Expr *scope);
+    void init_params(Var_Expr *param, Argument_Expr *argument, u64 base);
+    void init_params(Var_Expr *param, Flat_Node argument, u64 base);
     u8 *expr_source(Ast_Expr *expr);
     Vm_Atom vm_atom(Atom_Type *type, u8 *source);
 
@@ -0,0 +1,116 @@
+#ifndef BEE_AST_BENCH_HPP
+#define BEE_AST_BENCH_HPP
+
+#include "ast_dump.hpp"
+#include "bench.hpp"
+#include "flat_ast.hpp"
+#include "parser_bench.hpp"
+#include "register_system.hpp"
+#include "session.hpp"
+
+namespace bee
+{
+
+// Bytes of the expressions of the ast, the compounds count their array of pointers
+inline usize bench_expr_bytes(Flat_Node node)
+{
+    usize bytes = 0;
+    for (u32 n = node.n; n < node.flat->ends[node.n]; n++)
+    {
+        switch (Flat_Node{node.flat, n}.kind())
+        {
+        case Ast_Expr_Unary:
+            bytes += sizeof(Unary_Expr);
+            break;
+        case Ast_Expr_Binary:
+            bytes += sizeof(Binary_Expr);
+            break;
+        case Ast_Expr_Nested:
+            bytes += sizeof(Nested_Expr);
+            break;
+        case Ast_Expr_Scope:
+            bytes += sizeof(Scope_Expr) + sizeof(Compound_Expr);
+            for ([[maybe_unused]] Flat_Node child : Flat_Node{node.flat, n}.children())
+                bytes += sizeof(Ast_Expr *);
+            break;
+        case Ast_Expr_Return:
+            bytes += sizeof(Return_Expr);
+            break;
+        case Ast_Expr_Id:
+            bytes += sizeof(Id_Expr);
+            break;
+        case Ast_Expr_Var:
+            bytes += sizeof(Var_Expr);
+            break;
+        case Ast_Expr_Int:
+            bytes += sizeof(Int_Expr);
+            break;
+        case Ast_Expr_Float:
+            bytes += sizeof(Float_Expr);
+            break;
+        case Ast_Expr_Signature:
+            bytes += sizeof(Signature_Expr);
+            break;
+        case Ast_Expr_Function:
+            bytes += sizeof(Function_Expr);
+            break;
+        case Ast_Expr_Argument:
+            bytes += sizeof(Argument_Expr);
+            break;
+        case Ast_Expr_Invoke:
+            bytes += sizeof(Invoke_Expr);
+            break;
+        case Ast_Expr_If:
+            bytes += sizeof(If_Expr);
+            break;
+        default:
+            break;
+        }
+    }
+    return bytes;
+}
+
+inline void bench_ast()
+{
+    std::string deep = bench_deep_source(200, 16);
+    Session session;
+    Ast &ast = session.compile(deep);
+    Flat_Ast flat{ast};
+
+    usize nodes = 0;
+    for (u32 n = 0; n < flat.size(); n++)
+        nodes += !Flat_Node{&flat, n}.none();
+
+    fmt::print("ast: {} nodes, {:.1f} bytes per node as expressions, {:.1f} as a flat ast\n", nodes,
+               (f64)bench_expr_bytes(flat.root()) / nodes, (f64)flat.bytes() / nodes);
+
+    bench_report("ast/flatten", nodes, "nodes", bench_seconds(10, [&] {
+                     Flat_Ast{ast};
+                 }));
+    bench_report("ast/type-exprs", nodes, "nodes", bench_seconds(10, [&] {
+                     ast.type_system.type_exprs(ast.main_scope);
+                 }));
+    bench_report("ast/dump", nodes, "nodes", bench_seconds(10, [&] {
+                     Ast_Dump{&ast};
+                 }));
+    bench_report("ast/dump-flat", nodes, "nodes", bench_seconds(10, [&] {
+                     Ast_Dump{&ast, flat};
+                 }));
+
+    Flat_Node function = *flat.root().children().begin();
+    Function_Expr function_expr{};
+    bench_report("ast/intervals", nodes, "nodes", bench_seconds(10, [&] {
+                     Register_Allocator allocator{&function_expr, {}, ast.type_system};
+                     allocator.time = 0;
+                     allocator.parse_intervals(function.ptr<Scope_Expr>(1));
+                 }));
+    bench_report("ast/intervals-flat", nodes, "nodes", bench_seconds(10, [&] {
+                     Register_Allocator allocator{&function_expr, {}, ast.type_system};
+                     allocator.time = 0;
+                     allocator.parse_intervals(function.child(0));
+                 }));
+}
+
+} // namespace bee
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef BEE_BENCH_HPP
+#define BEE_BENCH_HPP
+
+#include "core.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace bee
+{
+
+// The programs of examples/, in the order of their names
+inline std::vector<std::string> bench_examples()
+{
+    std::vector<std::filesystem::path> paths;
+    for (const auto &entry : std::filesystem::directory_iterator{BEE_EXAMPLES_DIR})
+    {
+        if (entry.path().extension() == ".bee")
+            paths.push_back(entry.path());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<std::string> examples;
+    for (const auto &path : paths)
+    {
+        std::ifstream fstream{path};
+        examples.emplace_back(std::istreambuf_iterator{fstream}, std::istreambuf_iterator<char>{});
+    }
+    return examples;
+}
+
+// Every program of examples/ concatenated and repeated 'scale' times
+inline std::string bench_corpus(usize scale)
+{
+    std::string examples;
+    for (const std::string &example : bench_examples())
+    {
+        examples.append(example);
+        examples.push_back('\n');
+    }
+
+    std::string corpus;
+    corpus.reserve(examples.size() * scale);
+    for (usize n = 0; n < scale; n++)
+        corpus.append(examples);
+
+    return corpus;
+}
+
+// Best wall time out of 'runs' calls
+inline f64 bench_seconds(u32 runs, auto &&f)
+{
+    f64 best = std::numeric_limits<f64>::max();
+
+    for (u32 n = 0; n < runs; n++)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<f64>(end - begin).count());
+    }
+
+    return best;
+}
+
+inline void bench_report(std::string_view name, usize items, std::string_view unit, f64 seconds)
+{
+    fmt::print("{:<40} {:>14.0f} {}/s {:>10.3f} ms\n", name, items / seconds, unit, seconds * 1e3);
+}
+
+} // namespace bee
+
+#endif
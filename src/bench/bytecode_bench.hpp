@@ -0,0 +1,84 @@
+#ifndef BEE_BYTECODE_BENCH_HPP
+#define BEE_BYTECODE_BENCH_HPP
+
+#include "bench.hpp"
+#include "bytecode/bytecode.hpp"
+#include "bytecode/vm.hpp"
+#include "session.hpp"
+#include "vm/vm.hpp"
+
+namespace bee
+{
+
+// The recursive fibonacci of examples/, 'fib(n)' makes 2 * fib(n + 1) - 1 calls
+inline std::string bench_fib_source(u32 n)
+{
+    return fmt::format("fib :: (n: u32) -> u32\n"
+                       "{{\n"
+                       "\tif n < 2 {{\n"
+                       "\t\treturn n\n"
+                       "\t}}\n"
+                       "\treturn fib(n - 1) + fib(n - 2)\n"
+                       "}}\n"
+                       "main :: () -> s32\n"
+                       "{{\n"
+                       "\treturn fib({})\n"
+                       "}}\n",
+                       n);
+}
+
+inline usize bench_fib_calls(u32 n)
+{
+    usize prev = 0, fib = 1;
+    for (u32 i = 0; i < n; i++)
+    {
+        usize next = prev + fib;
+        prev = fib;
+        fib = next;
+    }
+    return 2 * fib - 1;
+}
+
+// 'main' computing one chain of 'length' binary operators of mixed precedence
+inline std::string bench_binary_source(usize length)
+{
+    std::string src = "main :: () -> s32\n{\n\ta := 3\n\tb := 2\n\tx := a";
+    for (usize n = 0; n < length; n++)
+        src += n % 4 == 0 ? " + a" : n % 4 == 1 ? " * b" : n % 4 == 2 ? " - b" : " < a";
+    return src + "\n\treturn 0\n}\n";
+}
+
+inline void bench_bytecode()
+{
+    u32 n = 25;
+    std::string src = bench_fib_source(n);
+    usize calls = bench_fib_calls(n);
+
+    Session session;
+    Ast &ast = session.compile(src);
+    f64 tree = bench_seconds(3, [&] {
+        Vm{&ast}.run();
+    });
+
+    Bytecode bytecode{&ast};
+    std::span<Bc_Instruction> code = bytecode.gen();
+    Bc_Vm vm{code};
+    f64 threaded = bench_seconds(3, [&] {
+        vm.run();
+    });
+
+    fmt::print("bytecode: fib({}), {} instructions, {:.1f}x the tree vm\n", n, code.size(), tree / threaded);
+    bench_report("bytecode/fib-tree-vm", calls, "calls", tree);
+    bench_report("bytecode/fib-bc-vm", calls, "calls", threaded);
+
+    usize length = 20000;
+    Session binary_session;
+    Ast &binary_ast = binary_session.compile(bench_binary_source(length));
+    bench_report("bytecode/binary-tree-vm", length, "ops", bench_seconds(10, [&] {
+                     Vm{&binary_ast}.run();
+                 }));
+}
+
+} // namespace bee
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef BEE_CLOSURE_BENCH_HPP
+#define BEE_CLOSURE_BENCH_HPP
+
+#include "bench.hpp"
+#include "bytecode_bench.hpp"
+#include "closure/closure.hpp"
+#include "closure/vm.hpp"
+#include "session.hpp"
+#include "vm/vm.hpp"
+#include <deque>
+
+namespace bee
+{
+
+inline void bench_closure()
+{
+    // The programs of examples/ both vms run, each one run 'scale' times
+    usize scale = 1000;
+    std::deque<Session> sessions;
+    std::deque<Closure> closures;
+    std::vector<Ast *> programs;
+    std::vector<Cl_Vm> cl_vms;
+    for (std::string &src : bench_examples())
+    {
+        try
+        {
+            // The scanner expects the source to end with a new line
+            src.push_back('\n');
+            Ast &ast = sessions.emplace_back().compile(src);
+            Vm{&ast}.run();
+            Cl_Vm cl_vm{closures.emplace_back(&ast).gen()};
+            cl_vm.run();
+            programs.push_back(&ast);
+            cl_vms.push_back(std::move(cl_vm));
+        }
+        catch (const Error &)
+        {
+        }
+    }
+
+    fmt::print("closure: {} examples run {} times\n", programs.size(), scale);
+    bench_report("closure/examples-tree-vm", programs.size() * scale, "runs", bench_seconds(3, [&] {
+                     for (usize n = 0; n < scale; n++)
+                     {
+                         for (Ast *ast : programs)
+                             Vm{ast}.run();
+                     }
+                 }));
+    bench_report("closure/examples-closure", programs.size() * scale, "runs", bench_seconds(3, [&] {
+                     for (usize n = 0; n < scale; n++)
+                     {
+                         for (Cl_Vm &vm : cl_vms)
+                             vm.run();
+                     }
+                 }));
+
+    // examples/function.bee scaled up from fib(2)
+    u32 fib = 25;
+    Session session;
+    Ast &ast = session.compile(bench_fib_source(fib));
+    Closure closure{&ast};
+    Cl_Vm vm{closure.gen()};
+    bench_report("closure/fib-tree-vm", bench_fib_calls(fib), "calls", bench_seconds(3, [&] {
+                     Vm{&ast}.run();
+                 }));
+    bench_report("closure/fib-closure", bench_fib_calls(fib), "calls", bench_seconds(3, [&] {
+                     vm.run();
+                 }));
+}
+
+} // namespace bee
+
+#endif
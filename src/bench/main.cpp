@@ -0,0 +1,18 @@
+#include "ast_bench.hpp"
+#include "bytecode_bench.hpp"
+#include "closure_bench.hpp"
+#include "core.hpp"
+#include "parser_bench.hpp"
+#include "regex_bench.hpp"
+#include "scanner_bench.hpp"
+using namespace bee;
+
+s32 main(s32 argc, char *argv[])
+{
+    bench_scanner();
+    bench_regex();
+    bench_parser();
+    bench_ast();
+    bench_bytecode();
+    bench_closure();
+}
@@ -0,0 +1,130 @@
+#ifndef BEE_PARSER_BENCH_HPP
+#define BEE_PARSER_BENCH_HPP
+
+#include "bench.hpp"
+#include "parser.hpp"
+#include "session.hpp"
+
+namespace bee
+{
+
+// The programs of examples/ that parse, each one a separate source
+inline std::vector<std::string> bench_sources()
+{
+    std::vector<std::string> sources;
+    std::string corpus = bench_corpus(1);
+    std::string_view next = corpus;
+
+    // bench_corpus() separates the files with an empty line, every file ends with '}'
+    for (usize end; (end = next.find("}\n\n")) != npos; next.remove_prefix(end + 3))
+    {
+        std::string src{next.substr(0, end + 2)};
+        try
+        {
+            Session{}.compile(src);
+            sources.push_back(std::move(src));
+        }
+        catch (const Error &)
+        {
+        }
+    }
+    return sources;
+}
+
+// Scopes nested 'depth' times, each one defining 'width' variables from the ones of the outer scopes
+inline std::string bench_deep_source(usize depth, usize width)
+{
+    std::string src = "deep :: () -> s32\n{\n";
+
+    for (usize n = 0; n < depth; n++)
+    {
+        for (usize i = 0; i < width; i++)
+        {
+            if (n == 0)
+                src += fmt::format("v0_{} := {}\n", i, i);
+            else
+                src += fmt::format("v{}_{} := v{}_{} + v0_{}\n", n, i, n - 1, i, i);
+        }
+        src += "{\n";
+    }
+
+    for (usize n = 0; n < depth; n++)
+        src += "}\n";
+    return src + "return 0\n}\n";
+}
+
+// One definition from a chain of 'length' binary operators of mixed precedence
+inline std::string bench_chain_source(usize length)
+{
+    std::string src = "a := 1\nx := a";
+    for (usize n = 0; n < length; n++)
+        src += n % 3 == 0 ? " + a" : n % 3 == 1 ? " * a" : " - a";
+    return src + "\n";
+}
+
+// Functions independent of each other, 'count' of them
+inline std::string bench_functions_source(usize count)
+{
+    std::string src;
+    for (usize n = 0; n < count; n++)
+        src += fmt::format("fun{} :: (x: s32) -> s32\n{{\n\treturn x + {}\n}}\n", n, n % 10);
+    return src;
+}
+
+inline void bench_parser()
+{
+    std::vector<std::string> sources = bench_sources();
+    usize scale = 200;
+
+    fmt::print("parser: {} sources compiled {} times\n", sources.size(), scale);
+    bench_report("parser/fresh-ast", sources.size() * scale, "sources", bench_seconds(3, [&] {
+                     for (usize n = 0; n < scale; n++)
+                     {
+                         for (const std::string &src : sources)
+                         {
+                             Scanner scanner{src, bee_syntax_map(), &bee_syntax_dfa()};
+                             Ast ast{};
+                             Parser{&scanner, &ast}.parse();
+                         }
+                     }
+                 }));
+    bench_report("parser/session", sources.size() * scale, "sources", bench_seconds(3, [&] {
+                     Session session;
+                     for (usize n = 0; n < scale; n++)
+                     {
+                         for (const std::string &src : sources)
+                             session.compile(src);
+                     }
+                 }));
+
+    std::string deep = bench_deep_source(100, 8);
+    Session session;
+    bench_report("parser/deep-scopes", deep.size(), "bytes", bench_seconds(10, [&] {
+                     session.compile(deep);
+                 }));
+
+    std::string chain = bench_chain_source(5000);
+    bench_report("parser/long-chain", chain.size(), "bytes", bench_seconds(10, [&] {
+                     session.compile(chain);
+                 }));
+
+    // One digit in the middle of the source changed back and forth, the two sources compiled in turns
+    std::string functions[2] = {bench_functions_source(1000), ""};
+    u32 digit = (u32)functions[0].find("return x + 0", functions[0].size() / 2) + 11;
+    functions[1] = functions[0];
+    functions[1][digit] = '1';
+    Source_Edit edit{digit, digit + 1, digit + 1};
+    usize turn = 0;
+
+    bench_report("parser/edit-full", functions[0].size(), "bytes", bench_seconds(10, [&] {
+                     session.compile(functions[turn++ % 2]);
+                 }));
+    session.compile(functions[turn % 2]);
+    bench_report("parser/edit-incremental", functions[0].size(), "bytes", bench_seconds(10, [&] {
+                     session.compile(functions[++turn % 2], edit);
+                 }));
+}
+
+} // namespace bee
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef BEE_REGEX_BENCH_HPP
+#define BEE_REGEX_BENCH_HPP
+
+#include "bench.hpp"
+#include "scanner_bench.hpp"
+#include "token.hpp"
+
+namespace bee
+{
+
+// Same loop as bench_scan_backtrack() on the flat graphs
+inline usize bench_scan_graph(std::string_view src, Syntax_Map map, bool memo = false)
+{
+    usize count = 0;
+    std::string_view next = src;
+
+    while (!next.empty())
+    {
+        for (const auto &[type, regex] : map)
+        {
+            if (usize match = memo ? regex.graph.submit_memo(next) : regex.graph.submit(next); match != npos)
+            {
+                next = next.substr(match);
+                count += !(type & (Token_Blank | Token_Comment));
+                break;
+            }
+        }
+    }
+
+    return count;
+}
+
+inline void bench_regex()
+{
+    std::string src = bench_corpus(100);
+    Syntax_Map map = bee_syntax_map();
+    usize count = bench_scan_graph(src, map);
+
+    fmt::print("regex: {} bytes, {} tokens\n", src.size(), count);
+    bench_report("regex/node-graph", count, "tokens", bench_seconds(3, [&] {
+                     bench_scan_backtrack(src, map);
+                 }));
+    bench_report("regex/flat-graph", count, "tokens", bench_seconds(3, [&] {
+                     bench_scan_graph(src, map);
+                 }));
+    bench_report("regex/memo-graph", count, "tokens", bench_seconds(3, [&] {
+                     bench_scan_graph(src, map, true);
+                 }));
+
+    // Nested quantifiers that never match, every way to split the input is tried without the memo
+    regex::Regex nested{"{'a'|'a'}* 'b'"};
+    std::string as(20, 'a');
+    bench_report("regex/nested-backtrack", as.size(), "bytes", bench_seconds(3, [&] {
+                     nested.graph.submit(as);
+                 }));
+    bench_report("regex/nested-memo", as.size(), "bytes", bench_seconds(3, [&] {
+                     nested.graph.submit_memo(as);
+                 }));
+
+    constexpr usize reps = 1000;
+    bench_report("regex/parse", reps * std::size(bee_syntax), "patterns", bench_seconds(3, [&] {
+                     for (usize n = 0; n < reps; n++)
+                     {
+                         for (const Syntax_Rule &rule : bee_syntax)
+                         {
+                             regex::Node_Arena arena;
+                             regex::Parser{rule.pattern, arena}.parse();
+                         }
+                     }
+                 }));
+}
+
+} // namespace bee
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef BEE_SCANNER_BENCH_HPP
+#define BEE_SCANNER_BENCH_HPP
+
+#include "bench.hpp"
+#include "scanner.hpp"
+#include "simd.hpp"
+#include "token_buffer.hpp"
+#include <deque>
+#include <sstream>
+
+namespace bee
+{
+
+inline usize bench_scan(Scanner scanner)
+{
+    usize count = 0;
+    while (scanner.tokenize().type != Token_Eof)
+        count++;
+    return count;
+}
+
+// Reference loop of the scanner before the regexes were compiled: one backtracking match per map entry
+inline usize bench_scan_backtrack(std::string_view src, Syntax_Map map)
+{
+    usize count = 0;
+    std::string_view next = src;
+
+    while (!next.empty())
+    {
+        for (const auto &[type, regex] : map)
+        {
+            if (usize match = regex.head->submit(next, 0); match != npos)
+            {
+                next = next.substr(match);
+                count += !(type & (Token_Blank | Token_Comment));
+                break;
+            }
+        }
+    }
+
+    return count;
+}
+
+// Source where most of the bytes are in comments, string bodies and indentation
+inline std::string bench_corpus_runs(usize scale)
+{
+    std::string corpus;
+    for (usize n = 0; n < scale; n++)
+    {
+        corpus += "// " + std::string(120, 'c') + "\n";
+        corpus += std::string(32, ' ') + "s := \"" + std::string(200, 's') + "\\\"" + std::string(60, 't') + "\";\n";
+    }
+    return corpus;
+}
+
+inline void bench_scanner()
+{
+    std::string src = bench_corpus(500);
+    Syntax_Map map = bee_syntax_map();
+    const regex::Dfa_Table *dfa = &bee_syntax_dfa();
+    usize count = bench_scan(Scanner{src, map});
+
+    fmt::print("scanner: {} bytes, {} tokens\n", src.size(), count);
+    bench_report("scanner/backtrack", count, "tokens", bench_seconds(3, [&] {
+                     bench_scan_backtrack(src, map);
+                 }));
+    bench_report("scanner/regex-dfa", count, "tokens", bench_seconds(3, [&] {
+                     bench_scan(Scanner{src, map});
+                 }));
+    bench_report("scanner/fused-dfa", count, "tokens", bench_seconds(3, [&] {
+                     bench_scan(Scanner{src, map, dfa});
+                 }));
+    // Token memory of the parser: one Token per entry of its queue before, 9 bytes per token in the buffer
+    bench_report("scanner/token-deque", count, "tokens", bench_seconds(3, [&] {
+                     Scanner scanner{src, map, dfa};
+                     std::deque<Token> tokens;
+                     while (tokens.emplace_back(scanner.tokenize()).type != Token_Eof)
+                         ;
+                 }));
+    bench_report("scanner/token-buffer", count, "tokens", bench_seconds(3, [&] {
+                     Scanner scanner{src, map, dfa};
+                     Token_Buffer buffer{scanner};
+                 }));
+    Thread_Pool pool;
+    bench_report(fmt::format("scanner/parallel-{}", pool.size()), count, "tokens", bench_seconds(3, [&] {
+                     Scanner scanner{src, map, dfa};
+                     Token_Buffer buffer{scanner, pool, src.size() / pool.size() / 4 + 1};
+                 }));
+    fmt::print("scanner: {} bytes of tokens in a deque, {} bytes in a buffer\n", count * sizeof(Token),
+               count * (sizeof(u8) + 2 * sizeof(u32)));
+    bench_report("scanner/stream", count, "tokens", bench_seconds(3, [&] {
+                     std::istringstream stream{src};
+                     Stream_Scanner scanner{stream, map, dfa};
+                     while (scanner.tokenize().type != Token_Eof)
+                         ;
+                 }));
+
+    std::string runs = bench_corpus_runs(20000);
+    regex::Dfa_Table scalar = dfa->scalar();
+    count = bench_scan(Scanner{runs, map, dfa});
+
+    fmt::print("scanner: {} bytes of comments and strings, {} tokens, {}\n", runs.size(), count,
+               simd_level_name(simd_level()));
+    bench_report("scanner/fused-dfa", runs.size(), "bytes", bench_seconds(3, [&] {
+                     bench_scan(Scanner{runs, map, &scalar});
+                 }));
+    bench_report("scanner/fused-dfa-simd", runs.size(), "bytes", bench_seconds(3, [&] {
+                     bench_scan(Scanner{runs, map, dfa});
+                 }));
+}
+
+} // namespace bee
+
+#endif
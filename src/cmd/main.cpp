@@ -2,9 +2,12 @@
 #include "core.hpp"
 #include "parser.hpp"
 #include "regex/format.hpp"
+#include "session.hpp"
+#include "source.hpp"
 #include "vm/vm.hpp"
+#include <chrono>
 #include <fmt/core.h>
-#include <fstream>
+#include <span>
 using namespace bee;
 
 // Register Regs_X86[]{
@@ -14,29 +17,55 @@ using namespace bee;
 //     "edx",
 // };
 
+// Every file is compiled in the same session, only the failures are reported with all the errors of each file
+static s32 compile_batch(std::span<const char *> paths)
+{
+    Session session;
+    usize failed = 0;
+    auto begin = std::chrono::steady_clock::now();
+    session.recover = true;
+
+    for (const char *path : paths)
+    {
+        try
+        {
+            session.compile_file(path);
+            failed += !session.diagnostics.empty();
+            for (const Error &error : session.diagnostics)
+                fmt::print(stderr, "{:s}: {:s}\n", path, error.what());
+        }
+        catch (const Error &error)
+        {
+            failed++;
+            fmt::print(stderr, "{:s}: {:s}\n", path, error.what());
+        }
+    }
+
+    std::chrono::duration<f64> seconds = std::chrono::steady_clock::now() - begin;
+    fmt::print("compiled {} files, {} failed in {:.3f} ms\n", paths.size(), failed, seconds.count() * 1e3);
+    return failed != 0;
+}
+
 s32 main(s32 argc, const char *argv[])
 {
+    if (argc > 2)
+        return compile_batch(std::span{argv + 1, (usize)argc - 1});
+
     if (argc != 2)
     {
         fmt::print("Bee - Cmd interface\n");
         return 0;
     }
 
-    std::fstream fstream{argv[1]};
-    if (!fstream.is_open())
-    {
-        throw Error{"fstream error", fmt::format("cannot open source from: '{:s}'", argv[1])};
-    }
-
-    std::string src{std::istreambuf_iterator{fstream}, {}};
-    src.push_back('\n');
-    Scanner scanner{src, bee_syntax_map()};
+    // The file is mapped, tokens and ast nodes point straight into the mapping
+    Source source{argv[1]};
+    Scanner scanner{source.src, bee_syntax_map(), &bee_syntax_dfa()};
     Ast ast{};
     Parser{&scanner, &ast}.parse();
 
     Ast_Dump ast_dump{&ast};
     fmt::print("{:s}\n", ast_dump.str());
-    fmt::print("{:s}\n", src);
+    fmt::print("{:s}\n", source.src);
 
     // Vm vm{&parser.ast};
     // fmt::print("program returned {}\n", vm.run());
@@ -0,0 +1,104 @@
+#ifndef BEE_ARENA_TEST_HPP
+#define BEE_ARENA_TEST_HPP
+
+#include "arena.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace bee
+{
+
+struct Arena_Counted
+{
+    std::string name;
+    s32 *count;
+
+    Arena_Counted(std::string name, s32 *count) : name{std::move(name)}, count{count}
+    {
+        (*count)++;
+    }
+
+    ~Arena_Counted()
+    {
+        (*count)--;
+    }
+};
+
+TEST(Arena, Mem_Align)
+{
+    Mem_Arena<64> arena;
+    u8 *byte = arena.emplace<u8>(1);
+    struct alignas(32) Wide
+    {
+        u8 data[32];
+    };
+    Wide *wide = arena.emplace<Wide>();
+    u64 *number = arena.push(u64{42});
+
+    EXPECT_EQ(*byte, 1);
+    EXPECT_EQ(*number, 42);
+    EXPECT_EQ((uintptr_t)wide % alignof(Wide), 0);
+    EXPECT_EQ((uintptr_t)number % alignof(u64), 0);
+    EXPECT_TRUE(arena.dtors.empty());
+
+    // Objects larger than a chunk get a chunk of their own
+    struct Large
+    {
+        u8 data[1000];
+    };
+    EXPECT_NE(arena.emplace<Large>(), nullptr);
+    EXPECT_GE(arena.chunks.back().size, sizeof(Large));
+}
+
+TEST(Arena, Mem_Destroy)
+{
+    s32 count = 0;
+    {
+        Mem_Arena<256> arena;
+        for (s32 n = 0; n < 100; n++)
+            EXPECT_EQ(arena.emplace<Arena_Counted>(fmt::format("object number {}", n), &count)->count, &count);
+
+        EXPECT_EQ(count, 100);
+        EXPECT_GT(arena.chunks.size(), 1);
+
+        arena.reset();
+        EXPECT_EQ(count, 0);
+        arena.emplace<Arena_Counted>("last", &count);
+    }
+    EXPECT_EQ(count, 0);
+}
+
+TEST(Arena, Mem_Rewind)
+{
+    s32 count = 0;
+    Mem_Arena<128> arena{2, 1024};
+
+    arena.emplace<Arena_Counted>("kept", &count);
+    Mem_Arena<128>::Mark mark = arena.mark();
+    Arena_Counted *first = arena.emplace<Arena_Counted>("rewound", &count);
+
+    arena.rewind(mark);
+    EXPECT_EQ(count, 1);
+    EXPECT_EQ(arena.emplace<Arena_Counted>("again", &count), first);
+
+    // Chunks grow by the factor up to the maximum and are kept by reset(), sources of the same size reuse them
+    for (s32 n = 0; n < 200; n++)
+        arena.emplace<u64>(n);
+    for (usize n = 1; n < arena.chunks.size(); n++)
+        EXPECT_EQ(arena.chunks[n].size, std::min<usize>(arena.chunks[n - 1].size * 2, 1024));
+
+    usize capacity = arena.capacity();
+    for (s32 source = 0; source < 10; source++)
+    {
+        arena.reset();
+        for (s32 n = 0; n < 200; n++)
+            arena.emplace<u64>(n);
+        arena.emplace<Arena_Counted>("source", &count);
+    }
+    EXPECT_EQ(arena.capacity(), capacity);
+    EXPECT_EQ(count, 1);
+}
+
+} // namespace bee
+
+#endif
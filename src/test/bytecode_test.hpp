@@ -0,0 +1,198 @@
+#ifndef BEE_BYTECODE_TEST_HPP
+#define BEE_BYTECODE_TEST_HPP
+
+#include "bytecode/bytecode.hpp"
+#include "bytecode/vm.hpp"
+#include "session.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace bee
+{
+
+inline s32 bytecode_run(const std::string &src)
+{
+    Session session;
+    Bytecode bytecode{&session.compile(src)};
+    return Bc_Vm{bytecode.gen()}.run();
+}
+
+TEST(Bytecode, Functions)
+{
+    EXPECT_EQ(bytecode_run("fib :: (n: u32) -> u32\n"
+                           "{\n"
+                           "\tif n < 2 {\n"
+                           "\t\treturn n\n"
+                           "\t}\n"
+                           "\treturn fib(n - 1) + fib(n - 2)\n"
+                           "}\n"
+                           "main :: () -> s32\n"
+                           "{\n"
+                           "\treturn fib(20)\n"
+                           "}\n"),
+              6765);
+
+    // The result of a call is an operand of the next one
+    EXPECT_EQ(bytecode_run("add :: (x: s32, y: s32) -> s32\n"
+                           "{\n"
+                           "\treturn x + y\n"
+                           "}\n"
+                           "twice :: (x: s32) -> s32\n"
+                           "{\n"
+                           "\treturn x * 2\n"
+                           "}\n"
+                           "main :: () -> s32\n"
+                           "{\n"
+                           "\treturn add(twice(add(1, 2)), twice(5)) - 1\n"
+                           "}\n"),
+              15);
+    // A function that ends without a return gives 0, not the register of its first variable
+    EXPECT_EQ(bytecode_run("main :: () -> s32\n"
+                           "{\n"
+                           "\ta := 2\n"
+                           "\ta = a + 1\n"
+                           "}\n"),
+              0);
+}
+
+TEST(Bytecode, Control)
+{
+    EXPECT_EQ(bytecode_run("main :: () -> s32\n"
+                           "{\n"
+                           "\ts := 0\n"
+                           "\tfor i := 0; i < 10; i++ {\n"
+                           "\t\ts = s + i\n"
+                           "\t}\n"
+                           "\tn := 100\n"
+                           "\tfor n > 1 {\n"
+                           "\t\tn = n / 2\n"
+                           "\t}\n"
+                           "\tif s == 45 {\n"
+                           "\t\ts = s + n\n"
+                           "\t} else {\n"
+                           "\t\ts = 0\n"
+                           "\t}\n"
+                           "\treturn s\n"
+                           "}\n"),
+              46);
+
+    EXPECT_EQ(bytecode_run("pow :: (x: s32, n: s32) -> s32\n"
+                           "{\n"
+                           "\tr := 1\n"
+                           "\tfor ; n > 0; n-- {\n"
+                           "\t\tr = r * x\n"
+                           "\t}\n"
+                           "\treturn r\n"
+                           "}\n"
+                           "main :: () -> s32\n"
+                           "{\n"
+                           "\treturn pow(3, 4)\n"
+                           "}\n"),
+              81);
+}
+
+TEST(Bytecode, Operators)
+{
+    auto run = [](std::string_view expr) {
+        return bytecode_run(fmt::format("main :: () -> s32\n"
+                                        "{{\n"
+                                        "\ta := 7\n"
+                                        "\tb := 2.5\n"
+                                        "\tc := a * b\n"
+                                        "\treturn {}\n"
+                                        "}}\n",
+                                        expr));
+    };
+
+    EXPECT_EQ(run("-a / 2"), -3);
+    EXPECT_EQ(run("a % 3 + (a << 2) + (a >> 1)"), 1 + 28 + 3);
+    EXPECT_EQ(run("(a > 6) + (a <= 6) + (c > 17) + (c < 17.6) + (a == 7 and c != 0)"), 4);
+    EXPECT_EQ(run("a++ + a"), 7 + 8);
+    EXPECT_EQ(run("(++a) + a"), 8 + 8);
+    EXPECT_EQ(run("(--a) * a"), 6 * 6);
+}
+
+// The opcodes are chosen for the atom of the operands, a mixed operation casts its operands first
+TEST(Bytecode, Typed)
+{
+    Session session;
+    Bytecode bytecode{&session.compile("main :: () -> s32\n"
+                                       "{\n"
+                                       "\ta := 7\n"
+                                       "\tb := 2.5\n"
+                                       "\tc := a * 2 + b\n"
+                                       "\treturn (c > 16) + (c < 17)\n"
+                                       "}\n")};
+    std::span<Bc_Instruction> code = bytecode.gen();
+
+    auto has = [&](Bc_Opcode opcode) {
+        return std::find_if(code.begin(), code.end(), [opcode](const Bc_Instruction &in) {
+                   return in.opcode == opcode;
+               }) != code.end();
+    };
+    EXPECT_TRUE(has(Bc_Mul_S32));
+    EXPECT_TRUE(has(Bc_Cast_S32_F32));
+    EXPECT_TRUE(has(Bc_Add_F32));
+    EXPECT_TRUE(has(Bc_Greater_F32));
+    EXPECT_FALSE(has(Bc_Greater_S32));
+    EXPECT_EQ(Bc_Vm{code}.run(), 2);
+}
+
+// Globals are defined before 'main' runs, the functions load them and store them back
+TEST(Bytecode, Globals)
+{
+    EXPECT_EQ(bytecode_run("b := 1\n"
+                           "c := b + 1\n"
+                           "bump :: (n: s32) -> s32\n"
+                           "{\n"
+                           "\tb = b + c * n\n"
+                           "\tb++\n"
+                           "\treturn b\n"
+                           "}\n"
+                           "main :: () -> s32\n"
+                           "{\n"
+                           "\tbump(1)\n"
+                           "\treturn bump(1) * 10 + b\n"
+                           "}\n"),
+              7 * 10 + 7);
+}
+
+// A chain of operators takes as many registers as one operation
+TEST(Bytecode, Chain)
+{
+    std::string src = "main :: () -> s32\n{\n\ta := 1\n\tx := a";
+    for (usize n = 0; n < 100000; n++)
+        src += " + a";
+    src += "\n\treturn x\n}\n";
+
+    Session session;
+    Bytecode bytecode{&session.compile(src)};
+    std::span<Bc_Instruction> code = bytecode.gen();
+    EXPECT_EQ(Bc_Vm{code}.run(), 100001);
+    EXPECT_LE(code[bytecode.entries.begin()->second].x, 4u);
+}
+
+TEST(Bytecode, Errors)
+{
+    EXPECT_THROW(bytecode_run("a := 1\n"), Error);
+    EXPECT_THROW(bytecode_run("main :: () -> s32\n{\n\ta := 0\n\treturn 1 / a\n}\n"), Error);
+    EXPECT_THROW(bytecode_run("f :: (n: s32) -> s32\n{\n\treturn f(n + 1)\n}\n"
+                              "main :: () -> s32\n{\n\treturn f(0)\n}\n"),
+                 Error);
+
+    // The parser checks the arguments against the parameters, the extra one is added to the ast after it
+    Session session;
+    Ast &ast = session.compile("f :: (n: s32) -> s32\n{\n\treturn n\n}\n"
+                               "main :: () -> s32\n{\n\treturn f(1)\n}\n");
+    Scope_Expr *main_scope = ((Function_Expr *)ast.main_scope->compound->back())->scope;
+    Invoke_Expr *invoke = (Invoke_Expr *)((Return_Expr *)main_scope->compound->back())->expr;
+    invoke->args->next = ast.push_expr(Argument_Expr{});
+    invoke->args->next->expr = invoke->args->expr;
+    Bytecode bytecode{&ast};
+    EXPECT_THROW(bytecode.gen(), Error);
+}
+
+} // namespace bee
+
+#endif
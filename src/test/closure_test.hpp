@@ -0,0 +1,412 @@
+#ifndef BEE_CLOSURE_TEST_HPP
+#define BEE_CLOSURE_TEST_HPP
+
+#include "bytecode/bytecode.hpp"
+#include "bytecode/vm.hpp"
+#include "closure/closure.hpp"
+#include "closure/vm.hpp"
+#include "flat_ast.hpp"
+#include "session.hpp"
+#include "vm/vm.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace bee
+{
+
+inline s32 closure_run(const std::string &src)
+{
+    Session session;
+    Closure closure{&session.compile(src)};
+    return Cl_Vm{closure.gen()}.run();
+}
+
+// The results of the tree Vm, Bc_Vm and Cl_Vm on one compile of the source. The tree Vm runs no 'for' loop, it is left
+// out when 'tree' is false
+inline std::vector<s32> closure_runs(const std::string &src, bool tree = true)
+{
+    Session session;
+    Ast &ast = session.compile(src);
+    std::vector<s32> results;
+    if (tree)
+        results.push_back(Vm{&ast}.run());
+    Bytecode bytecode{&ast};
+    results.push_back(Bc_Vm{bytecode.gen()}.run());
+    Closure closure{&ast};
+    results.push_back(Cl_Vm{closure.gen()}.run());
+    return results;
+}
+
+// Every program of examples/ that compiles gives the same result on the three Vms, or fails on all of them. The tree
+// Vm may only fail on the programs with a 'for' loop, they are compared on the other two
+TEST(Closure, Examples)
+{
+    auto result = [](auto &&run) -> std::optional<s32> {
+        try
+        {
+            return run();
+        }
+        catch (const Error &)
+        {
+            return std::nullopt;
+        }
+    };
+
+    usize compared = 0;
+    for (const auto &entry : std::filesystem::directory_iterator{BEE_EXAMPLES_DIR})
+    {
+        if (entry.path().extension() != ".bee")
+            continue;
+        SCOPED_TRACE(entry.path().filename().string());
+
+        // Not every example ends with a line break
+        std::ifstream fstream{entry.path()};
+        std::string src{std::istreambuf_iterator{fstream}, std::istreambuf_iterator<char>{}};
+        src.push_back('\n');
+
+        Session session;
+        try
+        {
+            session.compile(src);
+        }
+        catch (const Error &)
+        {
+            continue;
+        }
+        Ast *ast = &session.ast;
+
+        std::optional<s32> tree = result([&] {
+            return Vm{ast}.run();
+        });
+        std::optional<s32> bytecode = result([&] {
+            Bytecode bytecode{ast};
+            return Bc_Vm{bytecode.gen()}.run();
+        });
+        std::optional<s32> closure = result([&] {
+            Closure closure{ast};
+            return Cl_Vm{closure.gen()}.run();
+        });
+
+        Flat_Ast flat{*ast};
+        bool loops = false;
+        for (u32 n = 0; n < flat.size(); n++)
+            loops |= (Flat_Node{&flat, n}.kind() & (Ast_Expr_For | Ast_Expr_For_While)) != 0;
+
+        EXPECT_EQ(bytecode, closure);
+        if (!loops or tree.has_value())
+        {
+            EXPECT_EQ(tree, closure);
+        }
+        compared++;
+    }
+    EXPECT_GE(compared, 6u);
+}
+
+TEST(Closure, Functions)
+{
+    EXPECT_EQ(closure_runs("fib :: (n: u32) -> u32\n"
+                           "{\n"
+                           "\tif n < 2 {\n"
+                           "\t\treturn n\n"
+                           "\t}\n"
+                           "\treturn fib(n - 1) + fib(n - 2)\n"
+                           "}\n"
+                           "main :: () -> s32\n"
+                           "{\n"
+                           "\treturn fib(15)\n"
+                           "}\n"),
+              std::vector<s32>(3, 610));
+
+    // The result of a call is an operand of the next one
+    EXPECT_EQ(closure_runs("add :: (x: s32, y: s32) -> s32\n"
+                           "{\n"
+                           "\treturn x + y\n"
+                           "}\n"
+                           "twice :: (x: s32) -> s32\n"
+                           "{\n"
+                           "\treturn x * 2\n"
+                           "}\n"
+                           "main :: () -> s32\n"
+                           "{\n"
+                           "\treturn add(twice(add(1, 2)), twice(5)) - 1\n"
+                           "}\n"),
+              std::vector<s32>(3, 15));
+}
+
+// The frame of a call is taken before its arguments run, the calls in the arguments and the recursive calls take the
+// slots above it and leave the variables of the caller as they were
+TEST(Closure, Recursion)
+{
+    std::string src = "sum :: (n: s32) -> s32\n"
+                      "{\n"
+                      "\tif n == 0 {\n"
+                      "\t\treturn 0\n"
+                      "\t}\n"
+                      "\ta := n * 2\n"
+                      "\tb := sum(n - 1)\n"
+                      "\treturn a + b + n\n"
+                      "}\n"
+                      "add :: (x: s32, y: s32) -> s32\n"
+                      "{\n"
+                      "\tif x == 0 {\n"
+                      "\t\treturn y\n"
+                      "\t}\n"
+                      "\treturn add(x - 1, add(0, y) + 1)\n"
+                      "}\n"
+                      "main :: () -> s32\n"
+                      "{\n"
+                      "\treturn sum(10) + add(20, add(3, 4)) * 1000\n"
+                      "}\n";
+    EXPECT_EQ(closure_runs(src), std::vector<s32>(3, 3 * 55 + 27 * 1000));
+
+    Session session;
+    Closure closure{&session.compile(src)};
+    Cl_Vm vm{closure.gen()};
+    EXPECT_EQ(vm.run(), 3 * 55 + 27 * 1000);
+    EXPECT_EQ(vm.sp, vm.stack.data());
+    EXPECT_EQ(vm.calls, 0);
+    for (auto [function, entry] : closure.entries)
+        EXPECT_EQ(entry->slots, function->name == "sum" ? 3u : function->name == "add" ? 2u : 0u) << function->name;
+
+    // Deeper than the stack of the tree Vm holds
+    std::string deep = src.substr(0, src.find("main")) + "main :: () -> s32\n{\n\treturn sum(1000)\n}\n";
+    EXPECT_EQ(closure_runs(deep, false), std::vector<s32>(2, 3 * 500500));
+}
+
+TEST(Closure, Control)
+{
+    EXPECT_EQ(closure_runs("main :: () -> s32\n"
+                           "{\n"
+                           "\ts := 0\n"
+                           "\tfor i := 0; i < 10; i++ {\n"
+                           "\t\ts = s + i\n"
+                           "\t}\n"
+                           "\tn := 100\n"
+                           "\tfor n > 1 {\n"
+                           "\t\tn = n / 2\n"
+                           "\t}\n"
+                           "\tif s == 45 {\n"
+                           "\t\ts = s + n\n"
+                           "\t} else {\n"
+                           "\t\ts = 0\n"
+                           "\t}\n"
+                           "\treturn s\n"
+                           "}\n",
+                           false),
+              std::vector<s32>(2, 46));
+
+    EXPECT_EQ(closure_runs("pow :: (x: s32, n: s32) -> s32\n"
+                           "{\n"
+                           "\tr := 1\n"
+                           "\tfor ; n > 0; n-- {\n"
+                           "\t\tr = r * x\n"
+                           "\t}\n"
+                           "\treturn r\n"
+                           "}\n"
+                           "main :: () -> s32\n"
+                           "{\n"
+                           "\treturn pow(3, 4)\n"
+                           "}\n",
+                           false),
+              std::vector<s32>(2, 81));
+}
+
+// A return leaves the scopes and the loops it is nested in up to its call, the caller goes on after the call
+TEST(Closure, Return)
+{
+    EXPECT_EQ(closure_runs("depth :: (n: s32) -> s32\n"
+                           "{\n"
+                           "\tif n > 0 {\n"
+                           "\t\tif n > 1 {\n"
+                           "\t\t\treturn depth(n - 1) + 1\n"
+                           "\t\t}\n"
+                           "\t\treturn 1\n"
+                           "\t}\n"
+                           "\treturn 0\n"
+                           "}\n"
+                           "main :: () -> s32\n"
+                           "{\n"
+                           "\ta := depth(5)\n"
+                           "\tif a == 5 {\n"
+                           "\t\tif a > 4 {\n"
+                           "\t\t\treturn a * 10\n"
+                           "\t\t}\n"
+                           "\t}\n"
+                           "\treturn -1\n"
+                           "}\n"),
+              std::vector<s32>(3, 50));
+
+    std::string src = "find :: (n: s32) -> s32\n"
+                      "{\n"
+                      "\tfor i := 0; i < 100; i++ {\n"
+                      "\t\tif i * i > n {\n"
+                      "\t\t\tfor j := 0; j < 10; j++ {\n"
+                      "\t\t\t\tif j == 3 {\n"
+                      "\t\t\t\t\treturn i * 10 + j\n"
+                      "\t\t\t\t}\n"
+                      "\t\t\t}\n"
+                      "\t\t}\n"
+                      "\t}\n"
+                      "\treturn -1\n"
+                      "}\n"
+                      "main :: () -> s32\n"
+                      "{\n"
+                      "\ta := find(50)\n"
+                      "\tb := a + 1\n"
+                      "\treturn find(10) + b * 100 + find(100000)\n"
+                      "}\n";
+    EXPECT_EQ(closure_runs(src, false), std::vector<s32>(2, 43 + 84 * 100 - 1));
+}
+
+TEST(Closure, Operators)
+{
+    auto run = [](std::string_view expr) {
+        return closure_runs(fmt::format("main :: () -> s32\n"
+                                        "{{\n"
+                                        "\ta := 7\n"
+                                        "\tb := 2.5\n"
+                                        "\tc := a * b\n"
+                                        "\treturn {}\n"
+                                        "}}\n",
+                                        expr));
+    };
+
+    EXPECT_EQ(run("-a / 2"), std::vector<s32>(3, -3));
+    EXPECT_EQ(run("a % 3 + (a << 2) + (a >> 1)"), std::vector<s32>(3, 1 + 28 + 3));
+    EXPECT_EQ(run("(a > 6) + (a <= 6) + (c > 17) + (c < 17.6) + (a == 7 and c != 0)"), std::vector<s32>(3, 4));
+    EXPECT_EQ(run("a++ + a"), std::vector<s32>(3, 7 + 8));
+    EXPECT_EQ(run("(++a) + a"), std::vector<s32>(3, 8 + 8));
+    EXPECT_EQ(run("(--a) * a"), std::vector<s32>(3, 6 * 6));
+}
+
+// The value of a chain so far is cast to the atom of each operation that needs it: u8 to s32, then s32 to f32. The u8
+// operations wrap around before the value is widened
+TEST(Closure, Chain)
+{
+    std::string mixed = "main :: () -> s32\n"
+                        "{\n"
+                        "\ta: u8 = 250\n"
+                        "\tb: s32 = 10\n"
+                        "\tc := 0.5\n"
+                        "\td: s64 = 3\n"
+                        "\tx := a + b + c + c\n"
+                        "\ty := a + a + b - d\n"
+                        "\treturn (x == 261) * 1000 + y\n"
+                        "}\n";
+    EXPECT_EQ(closure_runs(mixed), std::vector<s32>(3, 1000 + 244 + 10 - 3));
+
+    Session session;
+    Closure closure{&session.compile(mixed)};
+    EXPECT_EQ(Cl_Vm{closure.gen()}.run(), 1000 + 244 + 10 - 3);
+    auto x = std::ranges::find_if(closure.nodes, [](const Cl_Node &node) {
+        return node.steps.size() == 3;
+    });
+    ASSERT_NE(x, closure.nodes.end());
+    EXPECT_NE(x->steps[0].cast, nullptr);
+    EXPECT_NE(x->steps[1].cast, nullptr);
+    EXPECT_EQ(x->steps[2].cast, nullptr);
+
+    // Every operation computes in the composed atom, s64 + f32 is an f64 on all the Vms
+    std::string wide = "main :: () -> s32\n"
+                       "{\n"
+                       "\ta: s64 = 3\n"
+                       "\tb: f32 = 2.5\n"
+                       "\tc: f64 = a + b\n"
+                       "\tif c > 5.0 {\n"
+                       "\t\treturn 1\n"
+                       "\t}\n"
+                       "\treturn 2\n"
+                       "}\n";
+    EXPECT_EQ(closure_runs(wide), std::vector<s32>(3, 1));
+    Ast &wide_ast = session.compile(wide);
+    EXPECT_EQ(Vm{&wide_ast}.run(Flat_Ast{wide_ast}), 1);
+
+    // A long chain is one node, it runs in a loop
+    std::string src = "main :: () -> s32\n{\n\ta := 1\n\tx := a";
+    for (usize n = 0; n < 100000; n++)
+        src += " + a";
+    src += "\n\treturn x\n}\n";
+
+    Closure long_closure{&session.compile(src)};
+    EXPECT_EQ(Cl_Vm{long_closure.gen()}.run(), 100001);
+    EXPECT_EQ(long_closure.entries.begin()->second->slots, 2u);
+}
+
+// The left operand of a binary operation is cast by the node of the operation, the right one by a cast node. A
+// comparison casts both to their composed atom, s8 for 'n < a' where 200 is -56
+TEST(Closure, Casts)
+{
+    std::string src = "main :: () -> s32\n"
+                      "{\n"
+                      "\ta: u8 = 200\n"
+                      "\tb: s32 = 100\n"
+                      "\tc := 2.5\n"
+                      "\tn: s8 = -3\n"
+                      "\tp := b * c\n"
+                      "\tq := c * b\n"
+                      "\tr := n < a\n"
+                      "\ts := a + n\n"
+                      "\treturn (p == 250) + (q == 250) * 10 + r * 100 + s * 1000\n"
+                      "}\n";
+    EXPECT_EQ(closure_runs(src), std::vector<s32>(3, 1 + 10 - 59 * 1000));
+
+    Session session;
+    Closure closure{&session.compile(src)};
+    EXPECT_EQ(Cl_Vm{closure.gen()}.run(), 1 + 10 - 59 * 1000);
+    usize prev_casts = std::ranges::count_if(closure.nodes, [](const Cl_Node &node) {
+        return node.op != NULL and node.cast != NULL;
+    });
+    usize post_casts = std::ranges::count_if(closure.nodes, [](const Cl_Node &node) {
+        return node.op != NULL and node.b != NULL and node.b->op == NULL and node.b->cast != NULL;
+    });
+    EXPECT_GE(prev_casts, 2u);
+    EXPECT_GE(post_casts, 2u);
+}
+
+// Globals are defined before 'main' runs, the functions load them and store them back
+TEST(Closure, Globals)
+{
+    EXPECT_EQ(closure_runs("b := 1\n"
+                           "c := b + 1\n"
+                           "bump :: (n: s32) -> s32\n"
+                           "{\n"
+                           "\tb = b + c * n\n"
+                           "\tb++\n"
+                           "\treturn b\n"
+                           "}\n"
+                           "main :: () -> s32\n"
+                           "{\n"
+                           "\tbump(1)\n"
+                           "\treturn bump(1) * 10 + b\n"
+                           "}\n"),
+              std::vector<s32>(3, 7 * 10 + 7));
+}
+
+TEST(Closure, Errors)
+{
+    EXPECT_THROW(closure_run("a := 1\n"), Error);
+    EXPECT_THROW(closure_run("main :: () -> s32\n{\n\ta := 0\n\treturn 1 / a\n}\n"), Error);
+    EXPECT_THROW(closure_run("f :: (n: s32) -> s32\n{\n\treturn f(n + 1)\n}\n"
+                             "main :: () -> s32\n{\n\treturn f(0)\n}\n"),
+                 Error);
+
+    // The parser checks the arguments against the parameters, the extra one is added to the ast after it
+    Session session;
+    Ast &ast = session.compile("f :: (n: s32) -> s32\n{\n\treturn n\n}\n"
+                               "main :: () -> s32\n{\n\treturn f(1)\n}\n");
+    Scope_Expr *main_scope = ((Function_Expr *)ast.main_scope->compound->back())->scope;
+    Invoke_Expr *invoke = (Invoke_Expr *)((Return_Expr *)main_scope->compound->back())->expr;
+    invoke->args->next = ast.push_expr(Argument_Expr{});
+    invoke->args->next->expr = invoke->args->expr;
+    Closure closure{&ast};
+    EXPECT_THROW(closure.gen(), Error);
+}
+
+} // namespace bee
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef BEE_DFA_TEST_HPP
+#define BEE_DFA_TEST_HPP
+
+#include "regex/regex.hpp"
+#include "regex/static.hpp"
+#include "token.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace bee::regex
+{
+
+static testing::AssertionResult assert_dfa(const Regex &regex, std::string_view expr)
+{
+    usize expected = regex.head != NULL ? regex.head->submit(expr, 0) : npos;
+    usize result = regex.dfa.submit(expr).index;
+
+    if (result != expected)
+    {
+        return testing::AssertionFailure()
+               << fmt::format("'{}' with '{}': dfa matched {} != {}", regex.src, expr, (s64)result, (s64)expected);
+    }
+    return testing::AssertionSuccess();
+}
+
+TEST(Dfa, Compile)
+{
+    EXPECT_FALSE("'abc'"_rx.dfa.empty());
+    EXPECT_FALSE("{'a'|'b'}+ 'c'?"_rx.dfa.empty());
+    EXPECT_FALSE("'enum' /!a"_rx.dfa.empty());
+    EXPECT_FALSE("'//' {{{'\\'^}|^} ~ /'\n'}? /'\n'"_rx.dfa.empty());
+
+    // Lookaheads spanning more than one character are left to the backtracking matcher
+    EXPECT_TRUE("'a' /'bc'"_rx.dfa.empty());
+    EXPECT_TRUE("'a' !{'bc'}"_rx.dfa.empty());
+}
+
+TEST(Dfa, First_Match)
+{
+    EXPECT_EQ("{'a'|'ab'}"_rx.dfa.submit("ab").index, 1);
+    EXPECT_EQ("{'ab'|'a'}"_rx.dfa.submit("ab").index, 2);
+    EXPECT_EQ("{'a'|'ab'} 'c'"_rx.dfa.submit("abc").index, 3);
+    EXPECT_EQ("^~'c'"_rx.dfa.submit("abcabc").index, 3);
+    EXPECT_EQ("[0-9]+"_rx.dfa.submit("123abc").index, 3);
+    EXPECT_EQ("'in' /!a"_rx.dfa.submit("int").index, npos);
+    EXPECT_EQ("'in' /!a"_rx.dfa.submit("in ").index, 2);
+    EXPECT_EQ("'in' /!a"_rx.dfa.submit("in").index, npos);
+}
+
+TEST(Dfa, Syntax_Map)
+{
+    constexpr std::string_view alphabet = "abefinorsux019_.+-*/=<>!&|~^'\"\\{}()[] \t\n";
+    std::mt19937 rng{0xbee};
+    std::uniform_int_distribution<usize> letter{0, alphabet.size() - 1};
+    std::uniform_int_distribution<usize> length{0, 12};
+
+    for (const auto &[type, regex] : bee_syntax_map())
+    {
+        EXPECT_FALSE(regex.dfa.empty()) << regex.src;
+
+        for (u32 n = 0; n < 2000; n++)
+        {
+            std::string expr(length(rng), ' ');
+            for (char &c : expr)
+                c = alphabet[letter(rng)];
+            EXPECT_TRUE(assert_dfa(regex, expr));
+        }
+    }
+}
+
+TEST(Dfa, Static)
+{
+    using Keyword = Static_Regex<"'enum' /!a">;
+    using Number = Static_Regex<"[0-9]+ {'.' [0-9]*}?">;
+
+    static_assert(Keyword::submit("enum ") == 4);
+    static_assert(Keyword::submit("enums") == npos);
+    static_assert(Number::submit("12.5+") == 4);
+
+    EXPECT_EQ(Number::match("3.14 ").view(), "3.14");
+    EXPECT_FALSE(Number::match("x"));
+}
+
+TEST(Dfa, Static_Syntax)
+{
+    Dfa dfa = syntax_dfa(bee_syntax_map());
+    const Dfa_Table &table = bee_syntax_dfa();
+
+    ASSERT_FALSE(dfa.empty());
+    EXPECT_EQ(table.width, dfa.width);
+    EXPECT_EQ(table.start, dfa.start);
+    EXPECT_TRUE(std::equal(dfa.classes, dfa.classes + 256, table.classes));
+
+    for (usize n = 0; n < dfa.table.size(); n++)
+    {
+        EXPECT_EQ(table.table[n].state, dfa.table[n].state);
+        EXPECT_EQ(table.table[n].accept, dfa.table[n].accept);
+    }
+}
+
+TEST(Dfa, Accel)
+{
+    const Dfa_Table &table = bee_syntax_dfa();
+    Dfa_Table scalar = table.scalar();
+
+    std::string comment = "//" + std::string(100, 'c') + "\\\n" + std::string(50, 'd') + "\n";
+    std::string str = "\"" + std::string(80, 's') + "\\\"" + std::string(40, 't') + "\" ";
+    std::string blank = std::string(90, ' ') + "\t\f  x";
+
+    for (std::string_view expr : {std::string_view{comment}, std::string_view{str}, std::string_view{blank}})
+    {
+        Dfa_Match expected = scalar.submit(expr);
+        Dfa_Match result = table.submit(expr);
+
+        EXPECT_NE(expected.index, npos);
+        EXPECT_EQ(result.index, expected.index) << expr;
+        EXPECT_EQ(result.accept, expected.accept) << expr;
+    }
+
+    // Mostly letters so that comments and strings run long enough to take the simd paths
+    constexpr std::string_view alphabet = "aaaaaaaaaaaaaaaaaaaaaaaab//  *\"'\\\t\n";
+    std::mt19937 rng{0xbee};
+    std::uniform_int_distribution<usize> letter{0, alphabet.size() - 1};
+    std::uniform_int_distribution<usize> length{0, 120};
+
+    for (u32 n = 0; n < 5000; n++)
+    {
+        std::string expr(length(rng), ' ');
+        for (char &c : expr)
+            c = alphabet[letter(rng)];
+
+        Dfa_Match expected = scalar.submit(expr);
+        Dfa_Match result = table.submit(expr);
+        EXPECT_EQ(result.index, expected.index) << expr;
+        EXPECT_EQ(result.accept, expected.accept) << expr;
+    }
+}
+
+} // namespace bee::regex
+
+#endif
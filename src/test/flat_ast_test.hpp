@@ -0,0 +1,164 @@
+#ifndef BEE_FLAT_AST_TEST_HPP
+#define BEE_FLAT_AST_TEST_HPP
+
+#include "ast_dump.hpp"
+#include "flat_ast.hpp"
+#include "register_system.hpp"
+#include "session.hpp"
+#include "var.hpp"
+#include "vm/vm.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace bee
+{
+
+inline const std::string flat_ast_source = "add :: (x: s32, y: s32) -> s32\n"
+                                           "{\n"
+                                           "\treturn x + y\n"
+                                           "}\n"
+                                           "main :: () -> s32\n"
+                                           "{\n"
+                                           "\ta := add(1, 2)\n"
+                                           "\tb := -a * 3 + 4\n"
+                                           "\tif b > 0 {\n"
+                                           "\t\treturn b\n"
+                                           "\t}\n"
+                                           "\tc := (a + 2.5) * 2\n"
+                                           "\treturn a + 1\n"
+                                           "}\n";
+
+// Walks the expressions in the order they are flattened, each one next to its node
+inline void expect_same_types(Type_System &type_system, Ast_Expr *expr, Flat_Node node)
+{
+    if (!expr)
+    {
+        EXPECT_TRUE(node.none());
+        return;
+    }
+    ASSERT_EQ(node.kind(), expr->kind());
+    if (!(expr->kind() & Ast_Expr_Str))
+    {
+        EXPECT_EQ(type_system.expr_type(node), type_system.expr_type(expr));
+    }
+
+    std::vector<Ast_Expr *> children;
+    switch (expr->kind())
+    {
+    case Ast_Expr_Unary:
+        children = {((Unary_Expr *)expr)->expr};
+        break;
+    case Ast_Expr_Binary:
+        children = {((Binary_Expr *)expr)->prev, ((Binary_Expr *)expr)->post};
+        break;
+    case Ast_Expr_Nested:
+        children = {((Nested_Expr *)expr)->expr};
+        break;
+    case Ast_Expr_Scope:
+        children = *((Scope_Expr *)expr)->compound;
+        break;
+    case Ast_Expr_Return:
+        children = {((Return_Expr *)expr)->expr};
+        break;
+    case Ast_Expr_Var:
+        children = {((Var_Expr *)expr)->expr, ((Var_Expr *)expr)->next};
+        break;
+    case Ast_Expr_Function:
+        children = {((Function_Expr *)expr)->scope};
+        break;
+    case Ast_Expr_Argument:
+        children = {((Argument_Expr *)expr)->expr, ((Argument_Expr *)expr)->next};
+        break;
+    case Ast_Expr_Invoke:
+        children = {((Invoke_Expr *)expr)->args};
+        break;
+    case Ast_Expr_If:
+        children = {((If_Expr *)expr)->condition, ((If_Expr *)expr)->scope_if, ((If_Expr *)expr)->scope_else};
+        break;
+    default:
+        break;
+    }
+
+    usize n = 0;
+    for (Flat_Node child : node.children())
+    {
+        ASSERT_LT(n, children.size());
+        expect_same_types(type_system, children[n++], child);
+    }
+    EXPECT_EQ(n, children.size());
+}
+
+TEST(Flat_Ast, Walk)
+{
+    Session session;
+    Ast &ast = session.compile(flat_ast_source);
+    Flat_Ast flat{ast};
+
+    EXPECT_EQ(flat.ends[0], flat.size());
+    expect_same_types(ast.type_system, ast.main_scope, flat.root());
+    EXPECT_EQ((Ast_Dump{&ast, flat}.str()), (Ast_Dump{&ast}.str()));
+
+    // Every child lies inside the subtree of its parent
+    for (u32 n = 0; n < flat.size(); n++)
+    {
+        EXPECT_GT(flat.ends[n], n);
+        for (Flat_Node child : Flat_Node{&flat, n}.children())
+            EXPECT_LE(flat.ends[child.n], flat.ends[n]);
+    }
+}
+
+TEST(Flat_Ast, Run)
+{
+    Session session;
+    Ast &ast = session.compile(flat_ast_source);
+    Flat_Ast flat{ast};
+
+    s32 result = Vm{&ast}.run();
+    EXPECT_EQ(Vm{&ast}.run(flat), result);
+}
+
+TEST(Flat_Ast, Intervals)
+{
+    Session session;
+    Ast &ast = session.compile(flat_ast_source);
+    Flat_Ast flat{ast};
+    usize functions = 0;
+
+    for (Flat_Node node : flat.root().children())
+    {
+        if (node.kind() != Ast_Expr_Function)
+            continue;
+
+        // The variables of the function are the entities of its var nodes, in one pass over its subtree
+        std::vector<Var *> vars;
+        for (u32 n = node.n; n < flat.ends[node.n]; n++)
+        {
+            if (Flat_Node{&flat, n}.kind() == Ast_Expr_Var)
+                vars.push_back(Flat_Node{&flat, n}.ptr<Var>(0));
+        }
+        if (vars.empty())
+            continue;
+
+        auto intervals = [&](auto scope) {
+            for (Var *var : vars)
+                var->begin = (u32)-1, var->end = 0;
+
+            Function_Expr function_expr{};
+            Register_Allocator allocator{&function_expr, {}, ast.type_system};
+            allocator.time = 0;
+            allocator.parse_intervals(scope);
+
+            std::vector<std::pair<u32, u32>> intervals;
+            for (Var *var : vars)
+                intervals.push_back({var->begin, var->end});
+            return intervals;
+        };
+        EXPECT_EQ(intervals(node.child(0)), intervals(node.ptr<Scope_Expr>(1)));
+        functions++;
+    }
+    EXPECT_EQ(functions, 1);
+}
+
+} // namespace bee
+
+#endif
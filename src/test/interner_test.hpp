@@ -0,0 +1,68 @@
+#ifndef BEE_INTERNER_TEST_HPP
+#define BEE_INTERNER_TEST_HPP
+
+#include "interner.hpp"
+#include "parser.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace bee
+{
+
+TEST(Interner, Dense)
+{
+    Interner interner;
+    EXPECT_EQ(interner.find("a"), Symbol_None);
+
+    std::vector<std::string> names;
+    for (u32 n = 0; n < 1000; n++)
+        names.push_back(fmt::format("name{}", n));
+
+    // The views of the first names stay valid while the table grows
+    std::string_view first = interner.str(interner.intern(names[0]));
+    for (u32 n = 0; n < names.size(); n++)
+        EXPECT_EQ(interner.intern(names[n]), n);
+
+    EXPECT_EQ(interner.size(), names.size());
+    EXPECT_EQ(first.data(), interner.str(0).data());
+    for (u32 n = 0; n < names.size(); n++)
+    {
+        EXPECT_EQ(interner.intern(std::string{names[n]}), n);
+        EXPECT_EQ(interner.find(names[n]), n);
+        EXPECT_EQ(interner.str(n), names[n]);
+    }
+    EXPECT_EQ(interner.find("name1000"), Symbol_None);
+    EXPECT_EQ(interner.intern(""), names.size());
+}
+
+// Every identifier token of a buffer gets the symbol of its name, the entities share it with their references
+TEST(Interner, Tokens)
+{
+    std::string src = "a := 1\nb := a + a\n";
+    Scanner scanner{src, bee_syntax_map(), &bee_syntax_dfa()};
+    Token_Buffer buffer{scanner};
+    Ast ast{};
+
+    buffer.intern(ast.interner);
+    u32 a = ast.interner.find("a");
+    u32 b = ast.interner.find("b");
+    ASSERT_NE(a, Symbol_None);
+    ASSERT_NE(b, Symbol_None);
+
+    for (usize n = 0; n < buffer.size(); n++)
+    {
+        Token token = buffer.token(n);
+        EXPECT_EQ(token.symbol, token.type == Token_Id ? ast.interner.find(token.expr) : Symbol_None);
+    }
+
+    Parser{&buffer, &ast}.parse();
+    EXPECT_EQ(ast.main_frame->find_def(a)->name.data(), ast.interner.str(a).data());
+    EXPECT_EQ(ast.main_frame->find_def(b)->symbol, b);
+
+    Ast other{};
+    EXPECT_THROW((Parser{&buffer, &other}), Error);
+}
+
+} // namespace bee
+
+#endif
@@ -1,6 +1,18 @@
+#include "arena_test.hpp"
+#include "bytecode_test.hpp"
+#include "closure_test.hpp"
 #include "core.hpp"
+#include "dfa_test.hpp"
+#include "flat_ast_test.hpp"
+#include "interner_test.hpp"
+#include "parser_test.hpp"
 #include "regex_test.hpp"
 #include "scanner_test.hpp"
+#include "session_test.hpp"
+#include "simd_test.hpp"
+#include "symbol_table_test.hpp"
+#include "type_system_test.hpp"
+#include "vm_test.hpp"
 #include <gtest/gtest.h>
 using namespace bee;
 
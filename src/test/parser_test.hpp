@@ -0,0 +1,212 @@
+#ifndef BEE_PARSER_TEST_HPP
+#define BEE_PARSER_TEST_HPP
+
+#include "ast_dump.hpp"
+#include "flat_ast.hpp"
+#include "register_system.hpp"
+#include "session.hpp"
+#include "var.hpp"
+#include "vm/vm.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace bee
+{
+
+// The operands and operators of an expression with every binary expression in parentheses
+inline std::string parser_tree(Ast_Expr *expr)
+{
+    switch (expr->kind())
+    {
+    case Ast_Expr_Binary: {
+        Binary_Expr *binary = (Binary_Expr *)expr;
+        return fmt::format("({} {} {})", parser_tree(binary->prev), binary->op.expr, parser_tree(binary->post));
+    }
+    case Ast_Expr_Unary:
+        return fmt::format("{}{}", ((Unary_Expr *)expr)->op.expr, parser_tree(((Unary_Expr *)expr)->expr));
+    case Ast_Expr_Nested:
+        return parser_tree(((Nested_Expr *)expr)->expr);
+    case Ast_Expr_Id:
+        return std::string{((Id_Expr *)expr)->name.expr};
+    case Ast_Expr_Int:
+        return fmt::format("{}", ((Int_Expr *)expr)->data);
+    default:
+        return "?";
+    }
+}
+
+// The tree of the expression defining the last variable of the source
+inline std::string parser_tree(std::string_view expr)
+{
+    Session session;
+    Ast &ast = session.compile(fmt::format("a := 1\nb := 2\nc := 3\nd := 4\nx := {}\n", expr));
+    return parser_tree(((Var_Expr *)ast.main_scope->compound->back())->expr);
+}
+
+TEST(Parser, Precedence)
+{
+    EXPECT_EQ(parser_tree("a + b * c"), "(a + (b * c))");
+    EXPECT_EQ(parser_tree("a * b + c"), "((a * b) + c)");
+    EXPECT_EQ(parser_tree("a - b - c - d"), "(((a - b) - c) - d)");
+    EXPECT_EQ(parser_tree("a * b + c * d"), "((a * b) + (c * d))");
+    EXPECT_EQ(parser_tree("a < b + c == d > 1"), "((a < (b + c)) == (d > 1))");
+    EXPECT_EQ(parser_tree("a + b << 1 < c and d or a"), "(((((a + b) << 1) < c) and d) or a)");
+    EXPECT_EQ(parser_tree("-a * (b + c) / d"), "((-a * (b + c)) / d)");
+
+    // '~' is not a binary operator
+    EXPECT_THROW(parser_tree("a ~ b"), Error);
+    EXPECT_THROW(parser_tree("a * b ~ c"), Error);
+}
+
+// The statements of a scope are climbed the same way as the expressions of a definition, assignments to the right
+TEST(Parser, Statements)
+{
+    Session session;
+    Ast &ast = session.compile("main :: () -> s32\n"
+                               "{\n"
+                               "\ta := 10 - 4 - 3\n"
+                               "\tb := 0\n"
+                               "\tb = a * 2 + 2 * 3 - 1\n"
+                               "\treturn b + 2 * a\n"
+                               "}\n");
+    EXPECT_EQ(Vm{&ast}.run(), 17);
+}
+
+// Chains of left associative operators do not recurse, they parse at any length
+TEST(Parser, Chain)
+{
+    std::string src = "a := 1\nx := a";
+    for (usize n = 0; n < 100000; n++)
+        src += " + a";
+    src += "\n";
+
+    Session session;
+    Ast &ast = session.compile(src);
+    Ast_Expr *expr = ((Var_Expr *)ast.main_scope->compound->back())->expr;
+
+    usize depth = 0;
+    for (; expr->kind() == Ast_Expr_Binary; expr = ((Binary_Expr *)expr)->prev)
+    {
+        EXPECT_EQ(((Binary_Expr *)expr)->post->kind(), Ast_Expr_Id);
+        depth++;
+    }
+    EXPECT_EQ(depth, 100000);
+}
+
+// The passes after parsing walk the chains without recursing into them, in the same order as before
+TEST(Parser, Chain_Passes)
+{
+    auto chain = [](usize length) {
+        std::string src = "main :: () -> s32\n{\n\ta := 1\n\tb := 2\n\treturn a";
+        for (usize n = 0; n < length; n++)
+            src += n % 2 == 0 ? " + b" : " - a";
+        return src + "\n}\n";
+    };
+
+    std::string src = chain(100000);
+    Session session;
+    Ast &ast = session.compile(src);
+    Flat_Ast flat{ast};
+    EXPECT_EQ(Vm{&ast}.run(), 50001);
+    EXPECT_EQ(Vm{&ast}.run(flat), 50001);
+
+    Flat_Node function = *flat.root().children().begin();
+    std::vector<Var *> vars;
+    for (u32 n = function.n; n < flat.ends[function.n]; n++)
+    {
+        if (Flat_Node{&flat, n}.kind() == Ast_Expr_Var)
+            vars.push_back(Flat_Node{&flat, n}.ptr<Var>(0));
+    }
+    ASSERT_EQ(vars.size(), 2);
+
+    auto intervals = [&](auto scope) {
+        for (Var *var : vars)
+            var->begin = (u32)-1, var->end = 0;
+
+        Function_Expr function_expr{};
+        Register_Allocator allocator{&function_expr, {}, ast.type_system};
+        allocator.time = 0;
+        allocator.parse_intervals(scope);
+
+        std::vector<std::pair<u32, u32>> intervals;
+        for (Var *var : vars)
+            intervals.push_back({var->begin, var->end});
+        return intervals;
+    };
+    std::vector<std::pair<u32, u32>> scope_intervals = intervals(function.ptr<Scope_Expr>(1));
+    EXPECT_GT(scope_intervals.back().second, 100000);
+    EXPECT_EQ(intervals(function.child(0)), scope_intervals);
+
+    src = chain(1000);
+    Ast &dumped = session.compile(src);
+    EXPECT_EQ((Ast_Dump{&dumped, Flat_Ast{dumped}}.str()), (Ast_Dump{&dumped}.str()));
+}
+
+// Nesting has a limit that is reported as an error before the stack runs out
+TEST(Parser, Depth)
+{
+    auto nested = [](usize depth, std::string_view open, std::string_view close) {
+        std::string src = "a := 1\nx := ";
+        for (usize n = 0; n < depth; n++)
+            src += open;
+        src += "a";
+        for (usize n = 0; n < depth; n++)
+            src += close;
+        return src + "\n";
+    };
+
+    Session session;
+    EXPECT_EQ(session.compile(nested(200, "(", ")")).main_scope->compound->size(), 2);
+    EXPECT_EQ(session.compile(nested(Parser_Depth_Limit / 2, "-", "")).main_scope->compound->size(), 2);
+    EXPECT_THROW(session.compile(nested(100000, "(", ")")), Error);
+    EXPECT_THROW(session.compile(nested(100000, "-", "")), Error);
+    EXPECT_THROW(session.compile(nested(100000, "a = ", "")), Error);
+}
+
+// Every statement that fails is reported, the ones around it are parsed
+TEST(Parser, Recover)
+{
+    std::string src = "a := 1\n"
+                      "b := c + 1\n"
+                      "d := a +\n"
+                      "}\n"
+                      "f :: () -> s32\n"
+                      "{\n"
+                      "\tx := y\n"
+                      "\tif a > 0 {\n"
+                      "\t\treturn a *\n"
+                      "\t}\n"
+                      "\treturn a\n"
+                      "}\n"
+                      "g := a * 2\n"
+                      "h := (a + (a * \n";
+    Session session;
+    EXPECT_THROW(session.compile(src), Error);
+
+    session.recover = true;
+    testing::internal::CaptureStdout();
+    Ast &ast = session.compile(src);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+
+    std::vector<std::string> errors;
+    for (const Error &error : session.diagnostics)
+        errors.push_back(error.what());
+    ASSERT_EQ(errors.size(), 6);
+    EXPECT_NE(errors[0].find("use of unknown identifier"), npos);
+    EXPECT_NE(errors[1].find("missing post operand"), npos);
+    EXPECT_NE(errors[2].find("got '}'"), npos);
+    EXPECT_NE(errors[3].find("use of unknown identifier"), npos);
+    EXPECT_NE(errors[4].find("missing post operand"), npos);
+    EXPECT_EQ(ast.main_scope->compound->size(), 3);
+    EXPECT_FALSE(session.parsed);
+
+    // A source without errors compiles as it does without recovery
+    src = "a := 1\nb := a + 1\n";
+    EXPECT_EQ(session.compile(src).main_scope->compound->size(), 2);
+    EXPECT_TRUE(session.diagnostics.empty());
+    EXPECT_TRUE(session.parsed);
+}
+
+} // namespace bee
+
+#endif
@@ -188,6 +188,87 @@ TEST(Regex, Wave)
     EXPECT_THROW("{}~"_rx, Error);
 }
 
+TEST(Regex, Graph)
+{
+    constexpr std::string_view patterns[] = {
+        "a+ {'_'|a|n}*",
+        "{'a'|'ab'} 'c'?",
+        "'a' /'bc'",
+        "'a' !{'bc'} ^",
+        "'//' {{{'\\'^}|^} ~ /'\n'}? /'\n'",
+        "{' '} ~ 'sus'",
+        "n+ /!{'.' n}",
+    };
+
+    // The flat graph has to match exactly like the node graph it was built from
+    for (std::string_view pattern : patterns)
+    {
+        Regex regex{pattern};
+        for (usize n = 0; n < LOREM_IPSUM.size(); n++)
+        {
+            std::string_view expr = LOREM_IPSUM.substr(n);
+            EXPECT_EQ(regex.graph.submit(expr), regex.head->submit(expr, 0)) << pattern << " with " << expr;
+        }
+    }
+
+    EXPECT_EQ("'a' /'bc'"_rx.match("abc").index, 1);
+    EXPECT_EQ("'a' /'bc'"_rx.match("abd").index, npos);
+    EXPECT_EQ("'a' !{'bc'} ^"_rx.match("abd").index, 3);
+    EXPECT_EQ("'a' !{'bc'} ^"_rx.match("abcd").index, npos);
+}
+
+TEST(Regex, Large)
+{
+    // Patterns of more nodes than the first chunk of the arena
+    Regex number{"{'-'|'+'}? {{n+ {'.' n*}?} | {'.' n+}} {{'e'|'E'} {'-'|'+'}? n+}? {'f'|'d'|'l'|'u'|'i'}*"};
+    EXPECT_GT(number.arena.size, regex::Node_Arena_Size);
+    EXPECT_EQ(number.match("-12.5e+3f;").view(), "-12.5e+3f"sv);
+    EXPECT_EQ(number.match(".5E2").view(), ".5E2"sv);
+    EXPECT_EQ(number.graph.submit("1e"), 1);
+    EXPECT_FALSE(number.match("e2"));
+
+    std::string keywords;
+    for (usize n = 0; n < 200; n++)
+        keywords += fmt::format("{}'kw{:03}'", n != 0 ? "|" : "", n);
+
+    Regex regex{keywords};
+    EXPECT_GT(regex.arena.size, regex::Node_Arena_Size * 4);
+    EXPECT_EQ(regex.match("kw199").view(), "kw199"sv);
+    EXPECT_EQ(regex.graph.submit("kw042 "), 5);
+    EXPECT_FALSE(regex.match("kw"));
+}
+
+TEST(Regex, Memo)
+{
+    constexpr std::string_view patterns[] = {
+        "a+ {'_'|a|n}*",
+        "{'a'|'ab'} 'c'?",
+        "'a' !{'bc'} ^",
+        "'//' {{{'\\'^}|^} ~ /'\n'}? /'\n'",
+        "{' '} ~ 'sus'",
+        "{a|' '}+ /{'.' '\n'}",
+    };
+
+    for (std::string_view pattern : patterns)
+    {
+        Regex regex{pattern, Engine_Memo};
+        for (usize n = 0; n < LOREM_IPSUM.size(); n++)
+        {
+            std::string_view expr = LOREM_IPSUM.substr(n);
+            EXPECT_EQ(regex.graph.submit_memo(expr), regex.graph.submit(expr)) << pattern << " with " << expr;
+        }
+    }
+
+    // Exponential with plain backtracking
+    std::string as(4096, 'a');
+    EXPECT_FALSE(Regex("{'a'|'a'}* 'b'", Engine_Memo).match(as));
+    EXPECT_EQ(Regex("{'a'|'a'}* /'b'", Engine_Memo).match(as + "b").view(), as);
+    EXPECT_EQ(Regex("{{'a'|'a'}+}* 'b'", Engine_Memo).match(as + "b").index, as.size() + 1);
+
+    // A loop that consumes nothing fails instead of recursing forever
+    EXPECT_EQ(Regex("{'a'?}* 'b'", Engine_Memo).match("b").index, 1);
+}
+
 } // namespace bee::regex
 
 #endif
@@ -2,9 +2,19 @@
 #define BEE_SCANNER_TEST
 
 #include "scanner.hpp"
+#include "source.hpp"
+#include "token_buffer.hpp"
+#include <filesystem>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <random>
+#include <sstream>
 #include <string>
 
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
 namespace bee
 {
 
@@ -389,6 +399,232 @@ fib :: (n: s64) -> s64
                 {")", Token_Nested_End}, {"}", Token_Scope_End}, {"}", Token_Scope_End});
 }
 
+TEST(Scanner, Fused)
+{
+    std::string src = std::string{bee_snake_source} + "\n// Comment \"with\" 'quotes'\n\"string\\n\" 'c' 0x1f 0b01 1.5e3\n";
+    Scanner scanner{src, bee_syntax_map()};
+    Scanner fused{src, bee_syntax_map(), &bee_syntax_dfa()};
+
+    ASSERT_FALSE(bee_syntax_dfa().empty());
+    while (!scanner.eof())
+    {
+        Token expected = scanner.tokenize();
+        Token result = fused.tokenize();
+
+        EXPECT_EQ(result.expr, expected.expr);
+        EXPECT_EQ(result.type, expected.type);
+    }
+    EXPECT_TRUE(fused.eof());
+}
+
+static std::vector<Token> scan_all(auto &scanner)
+{
+    std::vector<Token> tokens;
+    for (Token token = scanner.tokenize(); token.type != Token_Eof; token = scanner.tokenize())
+        tokens.push_back(token);
+    return tokens;
+}
+
+static std::string write_temp(std::string_view name, std::string_view content)
+{
+    std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+    std::ofstream{path, std::ios::binary} << content;
+    return path.string();
+}
+
+TEST(Scanner, Source)
+{
+    std::string src = std::string{bee_snake_source};
+    Scanner reference{src, bee_syntax_map()};
+    std::vector<Token> expected = scan_all(reference);
+
+    {
+        Source source{write_temp("bee_source_test.bee", src)};
+        Scanner scanner{source.src, bee_syntax_map(), &bee_syntax_dfa()};
+        std::vector<Token> tokens = scan_all(scanner);
+
+        EXPECT_EQ(source.src, src);
+        ASSERT_EQ(tokens.size(), expected.size());
+        for (usize n = 0; n < tokens.size(); n++)
+        {
+            EXPECT_EQ(tokens[n].expr, expected[n].expr);
+            EXPECT_EQ(tokens[n].type, expected[n].type);
+        }
+    }
+
+    // The '\n' is appended when missing, even when the file fills its last page
+    EXPECT_EQ(Source{write_temp("bee_source_test.bee", "a := 1")}.src, "a := 1\n");
+    EXPECT_EQ(Source{write_temp("bee_source_test.bee", std::string(4096, 'a'))}.src, std::string(4096, 'a') + "\n");
+    EXPECT_EQ(Source{write_temp("bee_source_test.bee", "")}.src, "\n");
+    EXPECT_THROW(Source{"bee_source_test_missing.bee"}, Error);
+
+#if __has_include(<unistd.h>)
+    // A pipe has no size, it is read until its end
+    s32 fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    ASSERT_EQ(write(fds[1], src.data(), src.size()), (ssize_t)src.size());
+    close(fds[1]);
+    {
+        Source piped{"/dev/fd/" + std::to_string(fds[0])};
+        EXPECT_FALSE(piped.mapped());
+        EXPECT_EQ(piped.src, src);
+    }
+    close(fds[0]);
+#endif
+}
+
+TEST(Scanner, Stream)
+{
+    std::string src = std::string{bee_snake_source} + "// Comment \"with\" 'quotes'\n\"string\\n\" 'c' 0x1f 1.5e3";
+    std::string full = src + "\n";
+    Scanner scanner{full, bee_syntax_map(), &bee_syntax_dfa()};
+    std::vector<Token> expected = scan_all(scanner);
+
+    // Chunks smaller than a line, larger than a line and larger than the whole source
+    for (usize chunk_size : {1, 7, 64, 1 << 16})
+    {
+        std::istringstream stream{src};
+        Stream_Scanner stream_scanner{stream, bee_syntax_map(), &bee_syntax_dfa(), chunk_size};
+
+        for (usize n = 0; n < expected.size(); n++)
+        {
+            Token token = stream_scanner.tokenize();
+            EXPECT_EQ(token.expr, expected[n].expr) << "chunk " << chunk_size << " token " << n;
+            EXPECT_EQ(token.type, expected[n].type) << "chunk " << chunk_size << " token " << n;
+        }
+        EXPECT_EQ(stream_scanner.tokenize().type, Token_Eof);
+        EXPECT_TRUE(stream_scanner.eof());
+    }
+}
+
+TEST(Scanner, Token_Buffer)
+{
+    std::string src = std::string{bee_snake_source};
+    Scanner reference{src, bee_syntax_map(), &bee_syntax_dfa()};
+    Scanner scanner{src, bee_syntax_map(), &bee_syntax_dfa()};
+    std::vector<Token> expected = scan_all(reference);
+    Token_Buffer buffer{scanner};
+
+    ASSERT_EQ(buffer.size(), expected.size() + 1);
+    for (usize n = 0; n < expected.size(); n++)
+    {
+        EXPECT_EQ(buffer.token(n).expr, expected[n].expr);
+        EXPECT_EQ(buffer.token(n).type, expected[n].type);
+    }
+    EXPECT_EQ(buffer.type(buffer.size() - 1), Token_Eof);
+
+    usize packed = sizeof(buffer.types[0]) + sizeof(buffer.offsets[0]) + sizeof(buffer.sizes[0]);
+    EXPECT_GE(sizeof(Token), packed * 3);
+
+    // Tokens are only consumed when they have one of the expected types, Eof is never moved past
+    Token_Cursor cursor{&buffer, 0};
+    EXPECT_FALSE(cursor.scan(Token_Id).ok);
+    EXPECT_TRUE(cursor.peek(Token_NewLine).ok);
+    EXPECT_EQ(cursor.scan(Token_NewLine | Token_Id).type, Token_NewLine);
+    EXPECT_EQ(cursor.scan(Token_Id).expr, "import_c");
+
+    cursor.n = buffer.size() - 1;
+    EXPECT_TRUE(cursor.eof());
+    EXPECT_TRUE(cursor.scan(Token_Eof).ok);
+    EXPECT_TRUE(cursor.eof());
+}
+
+static std::string random_source(std::mt19937 &rng, usize size)
+{
+    // Fragments that may leave a comment, a string or a char open at the end of the line, '@' is not a token
+    static constexpr std::string_view fragments[] = {
+        "x",    "_id",  "for ", "in",  "0x1f", "0b10", "12", "3.5e-2", ".5",   "\"str\"", "\"a\\\"b", "\"\\",
+        "'c'",  "'\\'", "'",    "//",  "// c", "/",    "*",  "::",     "->",   "<<",      "==",       "!",
+        "{",    "}",    "(",    ")",   " ",    "\t",   "  ", "\n",     "\n\n", "\\",      "\"",       "@",
+    };
+    std::uniform_int_distribution<usize> fragment{0, std::size(fragments) - 1};
+    std::uniform_int_distribution<u32> percent{0, 99};
+    std::string src;
+
+    while (src.size() < size)
+    {
+        std::string_view next = fragments[fragment(rng)];
+        if (next != "@" or percent(rng) == 0)
+            src += next;
+    }
+    return src + '\n';
+}
+
+static void expect_same_tokens(const Token_Buffer &buffer, const Token_Buffer &expected)
+{
+    ASSERT_EQ(buffer.size(), expected.size());
+    for (usize n = 0; n < expected.size(); n++)
+    {
+        ASSERT_EQ(buffer.types[n], expected.types[n]) << n;
+        ASSERT_EQ(buffer.offsets[n], expected.offsets[n]) << n;
+        ASSERT_EQ(buffer.sizes[n], expected.sizes[n]) << n;
+    }
+}
+
+TEST(Scanner, Parallel)
+{
+    // Strings and chars escape a '\n' with a '\\', a token may only begin with a '\n' when it ends there
+    std::optional<regex::Charset> guards = Token_Buffer::newline_guards(bee_syntax_dfa());
+    ASSERT_TRUE(guards);
+    EXPECT_TRUE((*guards)['\\']);
+    EXPECT_FALSE((*guards)['"'] or (*guards)['a'] or (*guards)[' ']);
+    EXPECT_TRUE((*Token_Buffer::newline_guards(regex::Regex{"'a\nb'"}.dfa.view()))['a']);
+    EXPECT_FALSE(Token_Buffer::newline_guards(regex::Regex{"'\nb'"}.dfa.view()));
+
+    Thread_Pool pool{4};
+    std::mt19937 rng{0xbee};
+    std::uniform_int_distribution<usize> size{0, 4096};
+    std::uniform_int_distribution<usize> chunk_size{1, 256};
+    usize errors = 0;
+
+    for (u32 n = 0; n < 200; n++)
+    {
+        std::string src = random_source(rng, size(rng));
+        usize chunk = chunk_size(rng);
+        std::optional<Token_Buffer> expected, buffer;
+        std::string expected_error, error;
+
+        try
+        {
+            Scanner scanner{src, bee_syntax_map(), &bee_syntax_dfa()};
+            expected.emplace(scanner);
+        }
+        catch (const Error &e)
+        {
+            expected_error = e.what();
+        }
+
+        try
+        {
+            Scanner scanner{src, bee_syntax_map(), &bee_syntax_dfa()};
+            buffer.emplace(scanner, pool, chunk);
+            EXPECT_TRUE(scanner.eof());
+        }
+        catch (const Error &e)
+        {
+            error = e.what();
+        }
+
+        // The error thrown is the first of the source, as in a serial scan
+        ASSERT_EQ(error, expected_error) << src;
+        if (expected)
+            expect_same_tokens(*buffer, *expected);
+        errors += !expected_error.empty();
+    }
+    EXPECT_GT(errors, 0);
+    EXPECT_LT(errors, 200);
+
+    // Sources of a single chunk and scanners without an automaton are scanned serially
+    std::string src = std::string{bee_snake_source};
+    Scanner reference{src, bee_syntax_map(), &bee_syntax_dfa()};
+    Scanner scanner{src, bee_syntax_map()};
+    Token_Buffer expected{reference};
+    expect_same_tokens(Token_Buffer{scanner, pool, 64}, expected);
+
+    Scanner whole{src, bee_syntax_map(), &bee_syntax_dfa()};
+    expect_same_tokens(Token_Buffer{whole, pool}, expected);
+}
+
 } // namespace bee
 
 #endif
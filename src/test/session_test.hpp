@@ -0,0 +1,227 @@
+#ifndef BEE_SESSION_TEST_HPP
+#define BEE_SESSION_TEST_HPP
+
+#include "flat_ast.hpp"
+#include "session.hpp"
+#include "vm/vm.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <string>
+
+namespace bee
+{
+
+TEST(Session, Reuse)
+{
+    const std::string sources[] = {
+        "a := 1\nb := a + 2\n",
+        "add :: (x: s32, y: s32) -> s32\n{\n\treturn x + y\n}\n",
+        "c := 3.5\nd := c * c\n",
+    };
+    Session session;
+
+    session.compile(sources[0]);
+    Frame *builtins = session.ast.builtins;
+    Ast_Entity *s32_type = session.ast.type_system.s32_type;
+    ASSERT_NE(builtins, nullptr);
+    EXPECT_EQ(session.ast.main_frame->owner, builtins);
+
+    // After one pass over the sources, the arena holding the expressions and the frames is enough for all of them
+    for (const std::string &src : sources)
+        session.compile(src);
+    usize capacity = session.ast.exprs.capacity();
+    usize names = session.ast.interner.size();
+
+    for (s32 n = 0; n < 10; n++)
+    {
+        for (const std::string &src : sources)
+        {
+            Ast &ast = session.compile(src);
+            EXPECT_NE(ast.main_frame->find_def(ast.interner.find("s32")), nullptr);
+        }
+    }
+    EXPECT_EQ(session.ast.exprs.capacity(), capacity);
+    EXPECT_EQ(session.ast.interner.size(), names);
+    EXPECT_EQ(session.ast.builtins, builtins);
+    EXPECT_EQ(session.ast.type_system.s32_type, s32_type);
+    EXPECT_EQ(session.sources, 34);
+
+    // A source that does not compile leaves the session usable
+    EXPECT_THROW(session.compile("x := unknown\n"), Error);
+    Ast &ast = session.compile(sources[1]);
+    EXPECT_NE(ast.main_frame->find_def(ast.interner.find("add")), nullptr);
+    EXPECT_EQ(ast.main_frame->find_def(ast.interner.find("a")), nullptr);
+}
+
+// The source with the last occurrence of 'find' replaced, and the edit of the bytes that changed as an editor gives it
+inline std::pair<std::string, Source_Edit> session_edit(std::string_view src, std::string_view find,
+                                                        std::string_view replace)
+{
+    u32 at = (u32)src.rfind(find);
+    std::string edited{src.substr(0, at)};
+    edited += replace;
+    edited += src.substr(at + find.size());
+
+    u32 prefix = 0, suffix = 0;
+    while (prefix < std::min(find.size(), replace.size()) and find[prefix] == replace[prefix])
+        prefix++;
+    while (suffix < std::min(find.size(), replace.size()) - prefix and
+           find[find.size() - suffix - 1] == replace[replace.size() - suffix - 1])
+        suffix++;
+    return {edited, Source_Edit{at + prefix, at + (u32)find.size() - suffix, at + (u32)replace.size() - suffix}};
+}
+
+// The kinds and the tokens of the nodes, the tokens that are not in the source are empty
+inline std::vector<std::pair<Ast_Expr_Kind, std::string_view>> session_nodes(const Ast &ast)
+{
+    Flat_Ast flat{ast};
+    std::vector<std::pair<Ast_Expr_Kind, std::string_view>> nodes;
+    for (u32 n = 0; n < flat.size(); n++)
+        nodes.push_back({Flat_Node{&flat, n}.kind(), Flat_Node{&flat, n}.token()});
+    return nodes;
+}
+
+TEST(Session, Edit)
+{
+    std::string src = "add :: (x: s32, y: s32) -> s32\n"
+                      "{\n"
+                      "\treturn x + y\n"
+                      "}\n"
+                      "\n"
+                      "twice :: (x: s32) -> s32\n"
+                      "{\n"
+                      "\treturn x * 2\n"
+                      "}\n"
+                      "main :: () -> s32\n"
+                      "{\n"
+                      "\ta := add(1, 2)\n"
+                      "\treturn twice(a)\n"
+                      "}\n";
+    Session session;
+    Ast &ast = session.compile(src);
+    ASSERT_EQ(ast.units.size(), 3);
+
+    // Each edit is compiled from a new buffer, the previous one is overwritten
+    auto edit = [&](std::string_view find, std::string_view replace) {
+        auto [edited, source_edit] = session_edit(src, find, replace);
+        std::vector<Ast_Expr *> exprs = *ast.main_scope->compound;
+
+        src.assign(src.size(), '#');
+        src = std::move(edited);
+        session.compile(src, source_edit);
+
+        Session fresh;
+        EXPECT_EQ(session_nodes(ast), session_nodes(fresh.compile(src)));
+        EXPECT_EQ(Vm{&ast}.run(), Vm{&fresh.ast}.run());
+
+        std::vector<bool> kept;
+        for (Ast_Expr *expr : exprs)
+            kept.push_back(std::ranges::count(*ast.main_scope->compound, expr) == 1);
+        return kept;
+    };
+
+    // A function body, and the function that calls it
+    EXPECT_EQ(edit("x * 2", "x * 3"), (std::vector<bool>{true, false, false}));
+    // The body of a function that is called, the caller is parsed again and the other function kept
+    EXPECT_EQ(edit("return x + y", "return x + y + 1"), (std::vector<bool>{false, true, false}));
+    // The last function, the lines of the edit only
+    EXPECT_EQ(edit("add(1, 2)", "add(3,\n 2)"), (std::vector<bool>{true, true, false}));
+    EXPECT_EQ(session.reparsed, 3);
+
+    // Lines added between units and at the end of the source, then a use of one of them
+    EXPECT_EQ(edit("}\n\ntwice", "}\nb := 1\n\ntwice"), (std::vector<bool>{true, true, true}));
+    EXPECT_EQ(edit("}\n", "}\nc := 2\n"), (std::vector<bool>{true, true, true, true}));
+    EXPECT_EQ(ast.units.size(), 5);
+    EXPECT_EQ(edit("\treturn twice(a)", "\treturn twice(a) + b"), (std::vector<bool>{true, true, true, false, true}));
+
+    // A source that does not parse leaves the next edit to a full compile
+    auto [broken, broken_edit] = session_edit(src, "x * 3", "x * ");
+    EXPECT_THROW(session.compile(broken, broken_edit), Error);
+    usize reparsed = session.reparsed;
+    auto [fixed, fixed_edit] = session_edit(broken, "x * ", "x * 4");
+    Ast &fixed_ast = session.compile(fixed, fixed_edit);
+    EXPECT_EQ(session.reparsed, reparsed);
+    Session fresh;
+    EXPECT_EQ(session_nodes(fixed_ast), session_nodes(fresh.compile(fixed)));
+
+    // The target of an assignment is shared with the statement before it, a kept unit moves its tokens once
+    std::string assign = "g := 1\n"
+                         "inc :: (y: s32) -> s32\n"
+                         "{\n"
+                         "\ty = y + 1\n"
+                         "\treturn y\n"
+                         "}\n";
+    Session assign_session;
+    assign_session.compile(assign);
+    auto [moved, moved_edit] = session_edit(assign, "g := 1", "g := 10");
+    assign.assign(assign.size(), '#');
+    Ast &moved_ast = assign_session.compile(moved, moved_edit);
+    EXPECT_EQ(assign_session.reparsed, 1);
+    Session moved_fresh;
+    EXPECT_EQ(session_nodes(moved_ast), session_nodes(moved_fresh.compile(moved)));
+
+    // An edit that changes nothing at the end of the source scans no lines
+    u32 size = (u32)moved.size();
+    assign_session.compile(moved, Source_Edit{size, size, size});
+    EXPECT_EQ(assign_session.reparsed, 2);
+    EXPECT_EQ(session_nodes(moved_ast), session_nodes(moved_fresh.ast));
+}
+
+TEST(Session, Dead)
+{
+    std::string src = "add :: (x: s32, y: s32) -> s32\n"
+                      "{\n"
+                      "\treturn x + y\n"
+                      "}\n"
+                      "main :: () -> s32\n"
+                      "{\n"
+                      "\treturn add(1, 2)\n"
+                      "}\n";
+    Session session;
+    session.compile(src);
+    usize live = session.ast.exprs.size();
+
+    // The edits replace both units, the arena holds the dead ones up to the limit and is then emptied by a full compile
+    usize compiles = 0;
+    for (s32 n = 0; n < 2000; n++)
+    {
+        auto [edited, source_edit] = session_edit(src, n % 2 ? "x + y + 1" : "x + y", n % 2 ? "x + y" : "x + y + 1");
+        src = std::move(edited);
+        usize reparsed = session.reparsed;
+        session.compile(src, source_edit);
+        compiles += session.reparsed == reparsed;
+        EXPECT_LE(session.ast.exprs.size(), 2 * std::max(Session_Dead_Limit, live) + live);
+    }
+    EXPECT_GT(compiles, 0);
+    EXPECT_LT(compiles, 2000 / 10);
+    EXPECT_EQ(Vm{&session.ast}.run(), 3);
+}
+
+// In recovery mode an edit that does not parse is compiled again from scratch, which collects its errors. Nothing is
+// printed on the way
+TEST(Session, Recover)
+{
+    std::string src = "a := 1\nb := a + 1\nc := b * 2\n";
+    Session session;
+    session.recover = true;
+    session.compile(src);
+    ASSERT_TRUE(session.parsed);
+
+    auto [broken, broken_edit] = session_edit(src, "a + 1", "a +");
+    testing::internal::CaptureStdout();
+    session.compile(broken, broken_edit);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+    ASSERT_EQ(session.diagnostics.size(), 2);
+    EXPECT_NE(std::string{session.diagnostics[0].what()}.find("missing post operand"), std::string::npos);
+    EXPECT_NE(std::string{session.diagnostics[1].what()}.find("use of unknown identifier"), std::string::npos);
+    EXPECT_FALSE(session.parsed);
+
+    auto [fixed, fixed_edit] = session_edit(broken, "a +", "a + 2");
+    session.compile(fixed, fixed_edit);
+    EXPECT_TRUE(session.diagnostics.empty());
+    EXPECT_TRUE(session.parsed);
+}
+
+} // namespace bee
+
+#endif
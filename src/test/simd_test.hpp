@@ -0,0 +1,68 @@
+#ifndef BEE_SIMD_TEST_HPP
+#define BEE_SIMD_TEST_HPP
+
+#include "simd.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+namespace bee
+{
+
+TEST(Simd, Find)
+{
+    const u8 newline[] = {'\n', '\\'};
+    std::string src = std::string(70, 'x') + "\\n" + std::string(30, 'y') + "\n";
+
+    for (Simd_Level level : {Simd_Scalar, Simd_Sse2, Simd_Avx2})
+    {
+        EXPECT_EQ(simd_find(level, src, newline, 2), 70) << simd_level_name(level);
+        EXPECT_EQ(simd_find(level, std::string_view{src}.substr(71), newline, 2), 31) << simd_level_name(level);
+        EXPECT_EQ(simd_find(level, std::string(100, 'z'), newline, 2), 100) << simd_level_name(level);
+        EXPECT_EQ(simd_find(level, "", newline, 2), 0) << simd_level_name(level);
+    }
+}
+
+TEST(Simd, Skip)
+{
+    const u8 blanks[] = {' ', '\v', '\b', '\f', '\t'};
+    std::string src = std::string(40, ' ') + "\t\f" + std::string(20, ' ') + "a  ";
+
+    for (Simd_Level level : {Simd_Scalar, Simd_Sse2, Simd_Avx2})
+    {
+        EXPECT_EQ(simd_skip(level, src, blanks, 5), 62) << simd_level_name(level);
+        EXPECT_EQ(simd_skip(level, std::string(64, ' '), blanks, 5), 64) << simd_level_name(level);
+        EXPECT_EQ(simd_skip(level, "a", blanks, 5), 0) << simd_level_name(level);
+    }
+}
+
+TEST(Simd, Random)
+{
+    const u8 needles[] = {'"', '\n', '\\', 0xff};
+    std::mt19937 rng{0xbee};
+    std::uniform_int_distribution<u32> byte{0, 255};
+    std::uniform_int_distribution<usize> length{0, 200};
+
+    for (u32 n = 0; n < 2000; n++)
+    {
+        std::string src(length(rng), ' ');
+        for (char &c : src)
+            c = byte(rng) < 248 ? 'a' + byte(rng) % 26 : needles[byte(rng) % 4];
+
+        for (u32 count = 0; count <= 4; count++)
+        {
+            usize find = simd_find(Simd_Scalar, src, needles, count);
+            usize skip = simd_skip(Simd_Scalar, src, needles, count);
+
+            for (Simd_Level level : {Simd_Sse2, Simd_Avx2})
+            {
+                EXPECT_EQ(simd_find(level, src, needles, count), find);
+                EXPECT_EQ(simd_skip(level, src, needles, count), skip);
+            }
+        }
+    }
+}
+
+} // namespace bee
+
+#endif
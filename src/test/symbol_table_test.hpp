@@ -0,0 +1,93 @@
+#ifndef BEE_SYMBOL_TABLE_TEST_HPP
+#define BEE_SYMBOL_TABLE_TEST_HPP
+
+#include "symbol_table.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+namespace bee
+{
+
+TEST(Symbol_Table, Scope)
+{
+    Symbol_Table<std::string_view, s32> table;
+    EXPECT_EQ(table.find("a"), 0);
+
+    table.push_scope();
+    table.insert("a", 1);
+    table.insert("b", 2);
+
+    table.push_scope();
+    table.insert("a", 3);
+    EXPECT_EQ(table.find("a"), 3);
+    EXPECT_EQ(table.find("b"), 2);
+    EXPECT_EQ(table.find_scope("b"), 0);
+    EXPECT_EQ(table.scope().size(), 1);
+
+    table.pop_scope();
+    EXPECT_EQ(table.find("a"), 1);
+    EXPECT_EQ(table.find_scope("b"), 2);
+
+    table.pop_scope();
+    EXPECT_EQ(table.find("a"), 0);
+    EXPECT_EQ(table.find("b"), 0);
+    EXPECT_TRUE(table.bindings.empty());
+}
+
+// Compared to a stack of maps, one per scope, searched from the innermost one
+TEST(Symbol_Table, Random)
+{
+    Symbol_Table<std::string_view, u32> table;
+    std::vector<std::unordered_map<std::string_view, u32>> frames(1);
+    std::vector<std::string> names;
+    for (u32 n = 0; n < 300; n++)
+        names.push_back(fmt::format("name{}", n));
+
+    std::mt19937 rng{0xbee};
+    std::uniform_int_distribution<usize> name{0, names.size() - 1};
+    std::uniform_int_distribution<u32> action{0, 9};
+    table.push_scope();
+
+    for (u32 n = 1; n < 20000; n++)
+    {
+        std::string_view key = names[name(rng)];
+
+        switch (action(rng))
+        {
+        case 0:
+            table.push_scope();
+            frames.emplace_back();
+            break;
+        case 1:
+            if (frames.size() > 1)
+            {
+                table.pop_scope();
+                frames.pop_back();
+            }
+            break;
+        case 2:
+        case 3:
+        case 4:
+            table.insert(key, n);
+            frames.back()[key] = n;
+            break;
+        default: {
+            u32 expected = 0;
+            for (auto frame = frames.rbegin(); frame != frames.rend() and expected == 0; frame++)
+                expected = frame->contains(key) ? frame->at(key) : 0;
+
+            ASSERT_EQ(table.find(key), expected) << key;
+            ASSERT_EQ(table.find_scope(key), frames.back().contains(key) ? frames.back().at(key) : 0) << key;
+        }
+        }
+    }
+
+    table.clear();
+    EXPECT_EQ(table.find(names[0]), 0);
+}
+
+} // namespace bee
+
+#endif
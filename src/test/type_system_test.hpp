@@ -0,0 +1,42 @@
+#ifndef BEE_TYPE_SYSTEM_TEST_HPP
+#define BEE_TYPE_SYSTEM_TEST_HPP
+
+#include "session.hpp"
+#include <gtest/gtest.h>
+
+namespace bee
+{
+
+inline void expect_typed(Type_System &type_system, Ast_Expr *expr)
+{
+    ASSERT_NE(expr->typed, nullptr);
+    EXPECT_EQ(expr->typed, type_system.expr_type(expr));
+    ast_expr_children(expr, [&](Ast_Expr *child) {
+        expect_typed(type_system, child);
+    });
+}
+
+// Every expression is typed once the source is parsed, the cached type is the one expr_type() derives
+TEST(Type_System, Typed)
+{
+    Session session;
+    Ast &ast = session.compile("add :: (x: s32, y: s32) -> s32\n"
+                               "{\n"
+                               "\treturn x + y\n"
+                               "}\n"
+                               "a := add(1, 2)\n"
+                               "b := -(-(a * 2.5))\n"
+                               "c := 1099511627776\n");
+    expect_typed(ast.type_system, ast.main_scope);
+
+    Compound_Expr &compound = *ast.main_scope->compound;
+    ASSERT_EQ(compound.size(), 4);
+    EXPECT_EQ(compound[1]->typed, ast.type_system.s32_type);
+    EXPECT_EQ(compound[2]->typed, ast.type_system.f32_type);
+    EXPECT_EQ(compound[3]->typed, ast.type_system.s64_type);
+    EXPECT_EQ(ast.type_system.typed(((Var_Expr *)compound[2])->expr), ast.type_system.f32_type);
+}
+
+} // namespace bee
+
+#endif
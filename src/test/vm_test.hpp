@@ -0,0 +1,254 @@
+#ifndef BEE_VM_TEST_HPP
+#define BEE_VM_TEST_HPP
+
+#include "flat_ast.hpp"
+#include "session.hpp"
+#include "type.hpp"
+#include "vm/kernel.hpp"
+#include "vm/vm.hpp"
+#include <gtest/gtest.h>
+
+namespace bee
+{
+
+TEST(Vm, Kernels)
+{
+    Atom_Type s32_atom, f32_atom;
+    s32_atom.desc = Atom_Signed;
+    s32_atom.size = 4;
+    f32_atom.desc = Atom_Float;
+    f32_atom.size = 4;
+    Atom_Type *s32_type = &s32_atom;
+    Atom_Type *f32_type = &f32_atom;
+
+    u8 result[8], prev[8], post[8];
+    s32 seven = 7, three = 3;
+    f32 half = 0.5;
+    std::memcpy(prev, &seven, sizeof(seven));
+    std::memcpy(post, &three, sizeof(three));
+
+    EXPECT_EQ(vm_kernel(Token_Mod, s32_type, s32_type)(result, prev, post), sizeof(s32));
+    EXPECT_EQ(*(s32 *)result, 1);
+    EXPECT_EQ(vm_kernel(Token_Less, s32_type, s32_type)(result, prev, post), sizeof(bool));
+    EXPECT_EQ(*(bool *)result, false);
+
+    // The operands are converted to their composed atom, an assignment converts into the type on the left
+    std::memcpy(post, &half, sizeof(half));
+    EXPECT_EQ(vm_kernel(Token_Add, s32_type, f32_type)(result, prev, post), sizeof(f32));
+    EXPECT_EQ(*(f32 *)result, 7.5);
+    vm_kernel(Token_Assign, f32_type, s32_type)(result, post, prev);
+    EXPECT_EQ(*(f32 *)post, 7);
+
+    EXPECT_EQ(vm_kernel(Token_Mod, s32_type, f32_type), nullptr);
+    EXPECT_EQ(vm_kernel(Token_Bin_Not, s32_type, s32_type), nullptr);
+
+    // A comparison converts both operands to their composed atom, -3 and 200 compare as s8
+    Atom_Type s8_atom, u8_atom;
+    s8_atom.desc = Atom_Signed;
+    s8_atom.size = 1;
+    u8_atom.desc = Atom_Raw;
+    u8_atom.size = 1;
+    s8 minus = -3;
+    u8 large = 200;
+    std::memcpy(prev, &minus, sizeof(minus));
+    std::memcpy(post, &large, sizeof(large));
+    vm_kernel(Token_Less, &s8_atom, &u8_atom)(result, prev, post);
+    EXPECT_EQ(*(bool *)result, false);
+    vm_kernel(Token_Greater, &s8_atom, &u8_atom)(result, prev, post);
+    EXPECT_EQ(*(bool *)result, true);
+}
+
+// The kernels resolved by the first run are kept on the binary expressions for the next ones
+TEST(Vm, Binary)
+{
+    Session session;
+    Ast &ast = session.compile("main :: () -> s32\n"
+                               "{\n"
+                               "\ta := 7\n"
+                               "\tb := a % 4 * 2 + a - (a < 8)\n"
+                               "\treturn b\n"
+                               "}\n");
+    EXPECT_EQ(Vm{&ast}.run(), 3 * 2 + 7 - 1);
+    EXPECT_EQ(Vm{&ast}.run(), 3 * 2 + 7 - 1);
+}
+
+// The variables are placed in the records of their functions before the program runs, the scopes that end give their
+// bytes back. Every call has its own record, the value it returns outlives it
+TEST(Vm, Slots)
+{
+    Session session;
+    Ast &ast = session.compile("g := 2\n"
+                               "fib :: (n: u32) -> u32\n"
+                               "{\n"
+                               "\tif n < 2 {\n"
+                               "\t\treturn n\n"
+                               "\t}\n"
+                               "\treturn fib(n - 1) + fib(n - 2)\n"
+                               "}\n"
+                               "main :: () -> s32\n"
+                               "{\n"
+                               "\ta: s64\n"
+                               "\tif g < 3 {\n"
+                               "\t\tb := 3\n"
+                               "\t\ta = b\n"
+                               "\t}\n"
+                               "\tc := 4\n"
+                               "\treturn fib(10) + a + c + g\n"
+                               "}\n");
+    Flat_Ast flat{ast};
+    EXPECT_EQ(Vm{&ast}.run(), 55 + 3 + 4 + 2);
+    EXPECT_EQ(Vm{&ast}.run(flat), 55 + 3 + 4 + 2);
+
+    std::vector<Var *> vars;
+    std::vector<Scope_Expr *> records;
+    for (Flat_Node child : flat.root().children())
+    {
+        if (child.kind() == Ast_Expr_Var)
+            vars.push_back(child.ptr<Var>(0));
+        else if (child.kind() == Ast_Expr_Function)
+            records.push_back(child.ptr<Scope_Expr>(1));
+    }
+    ASSERT_EQ(vars.size(), 1);
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(vars[0]->depth, 0);
+    EXPECT_EQ(vars[0]->offset, 0);
+    EXPECT_EQ(ast.main_scope->slots, sizeof(s32));
+
+    // fib has its parameter, main has 'a', then 'b' and 'c' in the same bytes
+    EXPECT_EQ(records[0]->depth, 1);
+    EXPECT_EQ(records[0]->slots, sizeof(u32));
+    EXPECT_EQ(records[1]->depth, 1);
+    EXPECT_EQ(records[1]->slots, sizeof(s64) + sizeof(s32));
+}
+
+// The parameters of the calls are printed as they return when asked to
+TEST(Vm, Trace)
+{
+    Session session;
+    Ast &ast = session.compile("add :: (x: s32, y: s32) -> s32\n"
+                               "{\n"
+                               "\treturn x + y\n"
+                               "}\n"
+                               "main :: () -> s32\n"
+                               "{\n"
+                               "\treturn add(add(1, 2), 3)\n"
+                               "}\n");
+    Vm vm{&ast};
+    testing::internal::CaptureStdout();
+    EXPECT_EQ(vm.run(), 6);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+
+    vm.trace = true;
+    testing::internal::CaptureStdout();
+    EXPECT_EQ(vm.run(), 6);
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "x: s32 = 1\ny: s32 = 2\nx: s32 = 3\ny: s32 = 3\n");
+}
+
+// Every run starts from an empty stack, the records of the previous ones do not pile up on it
+// A variable without expression is zero even in bytes a previous call wrote, 'main' without a return gives 0
+TEST(Vm, Zero)
+{
+    Session session;
+    Ast &ast = session.compile("g: f64\n"
+                               "dirty :: (n: s32) -> s32\n"
+                               "{\n"
+                               "\ta := n + 6\n"
+                               "\treturn a\n"
+                               "}\n"
+                               "zero :: (n: s32) -> s32\n"
+                               "{\n"
+                               "\ta: s32\n"
+                               "\treturn a\n"
+                               "}\n"
+                               "main :: () -> s32\n"
+                               "{\n"
+                               "\tb: u8\n"
+                               "\tif g == 0 {\n"
+                               "\t\treturn dirty(1) + zero(1) + b\n"
+                               "\t}\n"
+                               "\treturn 1\n"
+                               "}\n");
+    Flat_Ast flat{ast};
+    EXPECT_EQ(Vm{&ast}.run(), 7);
+    EXPECT_EQ(Vm{&ast}.run(flat), 7);
+
+    Ast &last = session.compile("main :: () -> s32\n"
+                                "{\n"
+                                "\ta := 5\n"
+                                "\ta = a + 1\n"
+                                "}\n");
+    Flat_Ast last_flat{last};
+    EXPECT_EQ(Vm{&last}.run(), 0);
+    EXPECT_EQ(Vm{&last}.run(last_flat), 0);
+}
+
+// The f32 literals are narrowed from the f64 they are parsed as, the comparisons 'main' returns are widened to s32
+TEST(Vm, Floats)
+{
+    Session session;
+    Ast &ast = session.compile("main :: () -> s32\n"
+                               "{\n"
+                               "\tb: s32 = 100\n"
+                               "\tc := 2.5\n"
+                               "\treturn (c > 2) + (b * c == 250) * 10 + (c * 2.0 < 5.5) * 100\n"
+                               "}\n");
+    Flat_Ast flat{ast};
+    EXPECT_EQ(Vm{&ast}.run(), 111);
+    EXPECT_EQ(Vm{&ast}.run(flat), 111);
+
+    Ast &compare = session.compile("main :: () -> s32\n"
+                                   "{\n"
+                                   "\tc := 2.5\n"
+                                   "\treturn c + c == 5\n"
+                                   "}\n");
+    Flat_Ast compare_flat{compare};
+    EXPECT_EQ(Vm{&compare}.run(), 1);
+    EXPECT_EQ(Vm{&compare}.run(compare_flat), 1);
+}
+
+// A call whose value is not used is a statement of its own
+TEST(Vm, Calls)
+{
+    Session session;
+    Ast &ast = session.compile("g := 1\n"
+                               "bump :: (n: s32) -> s32\n"
+                               "{\n"
+                               "\tg = g + n\n"
+                               "\treturn g\n"
+                               "}\n"
+                               "main :: () -> s32\n"
+                               "{\n"
+                               "\tbump(2)\n"
+                               "\tbump(3)\n"
+                               "\treturn g\n"
+                               "}\n");
+    Flat_Ast flat{ast};
+    EXPECT_EQ(Vm{&ast}.run(), 6);
+    EXPECT_EQ(Vm{&ast}.run(flat), 6);
+}
+
+TEST(Vm, Rerun)
+{
+    Session session;
+    Ast &ast = session.compile("g := 2\n"
+                               "twice :: (n: s32) -> s32\n"
+                               "{\n"
+                               "\treturn n * g\n"
+                               "}\n"
+                               "main :: () -> s32\n"
+                               "{\n"
+                               "\ta := twice(5)\n"
+                               "\treturn a + g\n"
+                               "}\n");
+    Flat_Ast flat{ast};
+    Vm vm{&ast};
+    for (usize n = 0; n < std::size(vm.stack); n++)
+    {
+        ASSERT_EQ(vm.run(), 12);
+        ASSERT_EQ(vm.run(flat), 12);
+    }
+}
+
+} // namespace bee
+
+#endif